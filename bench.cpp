@@ -1,12 +1,18 @@
+#include "common/baseline.hpp"
 #include "common/common.hpp"
+#include "common/dataset.hpp"
 #include "common/registry.hpp"
+#include "common/suite.hpp"
+#include "common/trace.hpp"
 #include "register_dwarfs.hpp"
+#ifdef DPCPP_ENABLED
+#include "common/dpcpp/queue_manager.hpp"
+#endif
 #include <boost/program_options.hpp>
 #include <iostream>
 
-bool isGroupBy(const std::string &dwarfName) {
-  return (dwarfName.find("GroupBy") != std::string::npos);
-}
+// Exit codes, so that runs can be used as a gate in CI.
+enum ExitCode { Success = 0, Error = 1, InvalidResult = 2, Regression = 3 };
 
 int main(int argc, char *argv[]) {
   populate_registry();
@@ -14,16 +20,21 @@ int main(int argc, char *argv[]) {
   auto registry = Registry::instance();
   namespace po = boost::program_options;
 
-  std::unique_ptr<RunOptions> opts = std::make_unique<RunOptions>();
+  auto opts = std::make_unique<RunOptions>();
   size_t groups_count = 1;
   size_t executors = 1;
+  std::string baseline_path;
+  std::string suite_path;
+  std::string trace_path;
+  std::string dataset_path;
+  double regression_threshold = 0.05;
 
   opts->root_path = helpers::get_kernels_root_env(argv[0]);
   std::cout
       << "DWARF_BENCH_ROOT is set to " << opts->root_path << std::endl
       << "You can change that with 'export DWARF_BENCH_ROOT=/your/path'\n";
 
-  Dwarf *dwarf;
+  Dwarf *dwarf = nullptr;
   std::string dwarf_name, device_type;
   po::options_description desc("Dwarf bench");
   desc.add_options()("help", "Show help message");
@@ -35,16 +46,125 @@ int main(int argc, char *argv[]) {
       "Data array size, ususally a column size in elements");
   desc.add_options()("iterations", po::value<size_t>(&opts->iterations),
                      "Number of iterations to run a bmark.");
+  desc.add_options()("warmup", po::value<size_t>(&opts->warmup),
+                     "Number of discarded iterations before measuring.");
+  desc.add_options()(
+      "target_ci", po::value<double>(&opts->target_ci),
+      "Repeat until the relative 95% confidence interval of host time is "
+      "below this value (e.g. 0.02), 0 disables adaptive repetition.");
+  desc.add_options()(
+      "max_iterations", po::value<size_t>(&opts->max_iterations),
+      "Upper bound of iterations for adaptive repetition.");
+  desc.add_options()(
+      "outlier_threshold", po::value<double>(&opts->outlier_threshold),
+      "Reject samples further than this many scaled MADs from the median, "
+      "0 disables rejection.");
+  desc.add_options()(
+      "peak_bandwidth", po::value<double>(&opts->peak_bandwidth),
+      "Peak memory bandwidth in GB/s to report bandwidth utilization against.");
+  desc.add_options()("measure_peak_bandwidth",
+                     po::bool_switch(&opts->measure_peak_bandwidth),
+                     "Measure peak memory bandwidth of the selected device "
+                     "with a copy kernel.");
+  desc.add_options()(
+      "distribution", po::value<Distribution>(&opts->distribution),
+      "Distribution of generated keys: uniform, zipf:<theta>, "
+      "selfsimilar:<h>, sequential, sorted, clustered:<clusters>, "
+      "heavyhitter:<share> or collision:<stride>.");
+  desc.add_options()(
+      "probe_ratio", po::value<double>(&opts->probe_ratio),
+      "Probe rows per build row of joins, input sizes set the build side "
+      "(e.g. 100 for a 1:100 join).");
+  desc.add_options()("match_rate", po::value<double>(&opts->match_rate),
+                     "Share of probe rows of joins with a matching build "
+                     "row, in [0, 1].");
+  desc.add_options()(
+      "build_duplicates", po::value<size_t>(&opts->build_duplicates),
+      "Build rows per distinct key of joins, above 1 for N:M joins.");
+  desc.add_options()(
+      "probe_duplicates", po::value<size_t>(&opts->probe_duplicates),
+      "Probe rows per distinct key of joins, above 1 for 1:N joins.");
+  desc.add_options()(
+      "partition_fanout", po::value<size_t>(&opts->partition_fanout),
+      "Partitions per radix pass of PartitionedJoin and TBBPartitionedJoin, "
+      "a power of two. By default build partitions fit in the cache.");
+  desc.add_options()(
+      "partition_passes", po::value<size_t>(&opts->partition_passes),
+      "Radix partitioning passes of the partitioned joins.");
+  desc.add_options()(
+      "key_width", po::value<KeyWidth>(&opts->key_width),
+      "Keys of Join and GroupBy: 32, 64 or 2x32 (two 32-bit key columns "
+      "packed into a 64-bit composite key).");
+  desc.add_options()(
+      "hasher", po::value<HasherKind>(&opts->hasher),
+      "Hash function of HashBuild, Join and GroupBy: default, "
+      "multiply_shift, fibonacci, crc32, xxhash or wyhash. All but default "
+      "use power-of-two tables.");
+  desc.add_options()(
+      "verify", po::value<RunOptions::Verification>(&opts->verify),
+      "Result check of join dwarfs: none, sample (the rows of a sample of "
+      "probe keys) or full (all rows against a parallel hash join).");
+  desc.add_options()("seed", po::value<uint64_t>(&opts->seed),
+                     "Seed of generated inputs, reported with the results so "
+                     "that a run can be reproduced.");
+  desc.add_options()(
+      "dataset", po::value<std::string>(&dataset_path),
+      "Directory of column files (<column>.col) to use as input instead of "
+      "random data, e.g. keys.col, or build_keys.col and probe_keys.col for "
+      "joins. Input sizes select the first rows of each column.");
+  desc.add_options()(
+      "perf_counters", po::bool_switch(&opts->perf_counters),
+      "Collect cycles, instructions, LLC, dTLB and branch misses of the "
+      "measured regions with perf_event_open (TBB dwarfs and the SYCL CPU "
+      "device, Linux only). Threads started during a measured iteration are "
+      "not counted, so use it with --warmup.");
+  desc.add_options()(
+      "probe_stats", po::bool_switch(&opts->probe_stats),
+      "Report probe length histograms, CAS failures, cuckoo evictions and "
+      "allocated slab nodes of the hash tables of HashBuild, Join, GroupBy, "
+      "CuckooHashBuild and SlabHashBuild. Builds instrumented kernels, whose "
+      "timings are not comparable with uninstrumented runs.");
   desc.add_options()("device",
                      po::value<RunOptions::DeviceType>(&opts->device_ty),
                      "Device to run on.");
   desc.add_options()("report_path", po::value<std::string>(&opts->report_path),
-                     "Full/Relative path to a report file.");
+                     "Full/Relative path to a report file. A .json or .jsonl "
+                     "extension writes JSON lines, CSV otherwise.");
   desc.add_options()(
       "groups_count", po::value<size_t>(&groups_count),
       "Number of unique keys for dwarfs with keys (groupby, hash build etc.).");
   desc.add_options()("executors", po::value<size_t>(&executors),
                      "Number of executors for GroupByLocal.");
+  desc.add_options()(
+      "load_factor",
+      po::value<std::vector<double>>(&opts->load_factor)->multitoken(),
+      "Load factors of the hash tables of hash-based dwarfs, e.g. "
+      "'0.25 0.5 0.75' to sweep memory footprint against throughput. "
+      "Open addressing tables take (0, 1], cuckoo tables (0, 0.95] and slab "
+      "hash tables any positive value. Growable tables take (0, 0.95] as the "
+      "load factor at which they double. Each dwarf has its own default.");
+  desc.add_options()(
+      "op_mix", po::value<std::vector<OpMix>>(&opts->op_mix)->multitoken(),
+      "Shares of inserts, finds and erases of SlabMixedOps as "
+      "'<inserts>:<finds>:<erases>' weights, e.g. '90:5:5 20:70:10' for a "
+      "write-heavy and a read-heavy point. Defaults to 20:70:10.");
+  desc.add_options()(
+      "baseline", po::value<std::string>(&baseline_path),
+      "JSON report of a previous run to compare against. Exits with 3 if "
+      "any point regresses, 2 on invalid results and 1 on errors.");
+  desc.add_options()(
+      "regression_threshold", po::value<double>(&regression_threshold),
+      "Relative slowdown of the median host time (e.g. 0.05) that counts as "
+      "a regression when it is statistically significant.");
+  desc.add_options()(
+      "suite", po::value<std::string>(&suite_path),
+      "Sweep file (.json or .ini) listing dwarfs, devices and sizes to run "
+      "in one process with a consolidated report. Other options are used as "
+      "defaults for settings the file does not specify.");
+  desc.add_options()(
+      "trace", po::value<std::string>(&trace_path),
+      "Write a Chrome trace event timeline (chrome://tracing, Perfetto) of "
+      "all iterations, phases, kernels and transfers to this file.");
   po::positional_options_description pos_opts;
   pos_opts.add("dwarf", 1);
 
@@ -70,30 +190,95 @@ int main(int argc, char *argv[]) {
     if (vm.count("help")) {
       std::cout << desc;
       return 0;
-    } else if (!dwarf) {
+    } else if (!dwarf && suite_path.empty()) {
       std::cerr << "List supported dwarfs to run with '" << argv[0] << " list'"
                 << std::endl;
-      return 1;
+      return Error;
     }
 
     if (opts->input_size.empty()) {
       opts->input_size.push_back(1);
     }
+    if (!dataset_path.empty()) {
+      opts->dataset = std::make_shared<Dataset>(dataset_path);
+    }
+    if (!trace_path.empty()) {
+      opts->tracer = std::make_shared<Tracer>();
+    }
+#ifdef DPCPP_ENABLED
+    // Shared by all points, so devices are set up and kernels built once.
+    opts->queues = make_queue_manager();
+#endif
 
-    helpers::set_dpcpp_filter_env(*opts);
+    Suite suite;
+    if (!suite_path.empty()) {
+      suite = load_suite(suite_path, *opts, groups_count, executors);
+    } else {
+      suite.report_path = opts->report_path;
+      suite.points.push_back(
+          {dwarf_name,
+           make_run_options(dwarf_name, *opts, groups_count, executors)});
+    }
+    for (const auto &point : suite.points) {
+      if (!registry->find(point.dwarf))
+        throw std::invalid_argument("Unknown dwarf " + point.dwarf);
+    }
 
-    if (isGroupBy(dwarf_name)) {
-      std::unique_ptr<GroupByRunOptions> tmpPtr =
-          std::make_unique<GroupByRunOptions>(*opts, groups_count, executors);
-      opts.reset();
-      opts = std::move(tmpPtr);
+    int status = Success;
+    // Dwarfs keep results of all their points, so each is reported once.
+    std::vector<Dwarf *> ran;
+    for (const auto &point : suite.points) {
+      Dwarf *dw = registry->find(point.dwarf);
+      helpers::set_dpcpp_filter_env(*point.opts);
+      try {
+        dw->init(*point.opts);
+        dw->run(*point.opts);
+      } catch (std::exception &e) {
+        std::cerr << point.dwarf << " failed: " << e.what() << std::endl;
+        status = Error;
+      }
+      if (std::find(ran.begin(), ran.end(), dw) == ran.end())
+        ran.push_back(dw);
     }
 
-    dwarf->init(*opts);
-    dwarf->run(*opts);
-    dwarf->report(*opts);
+    if (opts->tracer) {
+      opts->tracer->write(trace_path);
+    }
+
+    RunOptions report_opts;
+    report_opts.report_path = suite.report_path;
+    for (auto *dw : ran) {
+      dw->report(report_opts);
+    }
+
+    for (auto *dw : ran) {
+      const auto &results = dw->results();
+      if (!std::all_of(results.begin(), results.end(),
+                       [](const auto &res) { return res.valid(); })) {
+        std::cerr << dw->name() << ": some results are invalid" << std::endl;
+        if (status == Success)
+          status = InvalidResult;
+      }
+    }
+
+    if (!baseline_path.empty()) {
+      Baseline baseline = Baseline::load(baseline_path);
+      size_t regressions = 0;
+      for (auto *dw : ran) {
+        regressions += compare_with_baseline(baseline, dw->name(),
+                                             dw->results(),
+                                             regression_threshold, std::cout);
+      }
+      if (regressions) {
+        std::cerr << regressions << " regression(s) against " << baseline_path
+                  << std::endl;
+        if (status == Success)
+          status = Regression;
+      }
+    }
+    return status;
   } catch (std::exception &e) {
     std::cerr << "Caught exception: " << e.what() << std::endl;
+    return Error;
   }
-  return 0;
 }
\ No newline at end of file
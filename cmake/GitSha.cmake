@@ -0,0 +1,21 @@
+# Run with cmake -P at build time: writes the current commit of SOURCE_DIR to
+# the header OUTPUT, which is only touched when the commit changed so that a
+# rebuild at the same commit recompiles nothing.
+execute_process(
+    COMMAND git rev-parse --short HEAD
+    WORKING_DIRECTORY ${SOURCE_DIR}
+    OUTPUT_VARIABLE sha
+    OUTPUT_STRIP_TRAILING_WHITESPACE
+    ERROR_QUIET
+)
+if(NOT sha)
+  set(sha unknown)
+endif()
+
+set(content "#define DWARF_BENCH_GIT_SHA \"${sha}\"\n")
+if(EXISTS ${OUTPUT})
+  file(READ ${OUTPUT} current)
+endif()
+if(NOT "${current}" STREQUAL "${content}")
+  file(WRITE ${OUTPUT} "${content}")
+endif()
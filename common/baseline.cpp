@@ -0,0 +1,118 @@
+#include "baseline.hpp"
+#include <algorithm>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace pt = boost::property_tree;
+
+Baseline Baseline::load(const std::string &path) {
+  std::ifstream in(path);
+  if (!in.is_open())
+    throw std::runtime_error("Could not open the baseline at " + path);
+
+  Baseline baseline;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos)
+      continue;
+
+    pt::ptree record;
+    std::istringstream is(line);
+    pt::read_json(is, record);
+
+    DwarfParams params;
+    for (const auto &p : record.get_child("params")) {
+      params[p.first] = p.second.data();
+    }
+
+    const auto &host = record.get_child("host_time_us");
+    Stats s;
+    s.samples = host.get<size_t>("samples");
+    s.mean = host.get<double>("mean");
+    s.median = host.get<double>("median");
+    s.stddev = host.get<double>("stddev");
+    baseline.add(record.get<std::string>("dwarf"), params, s);
+  }
+  return baseline;
+}
+
+void Baseline::add(const std::string &dwarf, const DwarfParams &params,
+                   const Stats &host_stats) {
+  // The latest record of a point wins when reports were appended to.
+  entries_[{dwarf, params}] = host_stats;
+}
+
+const Stats *Baseline::find(const std::string &dwarf,
+                            const DwarfParams &params) const {
+  auto it = entries_.find({dwarf, params});
+  return it == entries_.end() ? nullptr : &it->second;
+}
+
+Comparison compare(const Stats &baseline, const Stats &current,
+                   double threshold) {
+  Comparison c;
+  if (current.median > 0)
+    c.speedup = baseline.median / current.median;
+
+  auto var_of_mean = [](const Stats &s) {
+    return s.samples ? s.stddev * s.stddev / s.samples : 0;
+  };
+  double vb = var_of_mean(baseline);
+  double vc = var_of_mean(current);
+  double se2 = vb + vc;
+  if (se2 > 0) {
+    c.t_value = (current.mean - baseline.mean) / std::sqrt(se2);
+    // Welch-Satterthwaite degrees of freedom.
+    double denom = 0;
+    if (baseline.samples > 1)
+      denom += vb * vb / (baseline.samples - 1);
+    if (current.samples > 1)
+      denom += vc * vc / (current.samples - 1);
+    size_t dof = denom > 0 ? static_cast<size_t>(se2 * se2 / denom) : 0;
+    c.significant =
+        std::abs(c.t_value) > stats::t_critical(std::max<size_t>(dof, 1));
+  } else {
+    // No spread to test against (e.g. single iterations), any change counts.
+    c.significant = current.mean != baseline.mean;
+  }
+
+  c.regression = c.significant && current.mean > baseline.mean &&
+                 current.median > baseline.median * (1 + threshold);
+  return c;
+}
+
+size_t compare_with_baseline(const Baseline &baseline, const std::string &dwarf,
+                             const MeasureResults &results, double threshold,
+                             std::ostream &os) {
+  size_t regressions = 0;
+  for (const auto &res : results) {
+    os << dwarf;
+    for (const auto &p : res.params) {
+      os << " " << p.first << "=" << p.second;
+    }
+    os << ": ";
+
+    const Stats *base = baseline.find(dwarf, res.params);
+    if (!base) {
+      os << "no baseline\n";
+      continue;
+    }
+
+    Comparison c = compare(*base, res.host_stats, threshold);
+    os << std::fixed << std::setprecision(3) << c.speedup << "x ("
+       << base->median << " -> " << res.host_stats.median << " us, t "
+       << c.t_value << ")" << std::defaultfloat;
+    if (c.regression) {
+      os << " REGRESSION";
+      ++regressions;
+    } else if (!c.significant) {
+      os << " not significant";
+    }
+    os << "\n";
+  }
+  return regressions;
+}
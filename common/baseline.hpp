@@ -0,0 +1,43 @@
+#pragma once
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#include "result.hpp"
+#include "stats.hpp"
+
+// Host time statistics of a previous run, read from a JSON lines report.
+class Baseline {
+public:
+  static Baseline load(const std::string &path);
+
+  void add(const std::string &dwarf, const DwarfParams &params,
+           const Stats &host_stats);
+  // nullptr if the point was not measured in the baseline run.
+  const Stats *find(const std::string &dwarf, const DwarfParams &params) const;
+  size_t size() const { return entries_.size(); }
+
+private:
+  std::map<std::pair<std::string, DwarfParams>, Stats> entries_;
+};
+
+struct Comparison {
+  // Baseline median over current median, > 1 means the current run is faster.
+  double speedup = 1;
+  // Welch's t statistic of the means, positive if the current run is slower.
+  double t_value = 0;
+  bool significant = false;
+  bool regression = false;
+};
+
+// Welch's t-test at the 95% level. A point regresses when it is
+// significantly slower and its median grew by more than `threshold`
+// (relative, e.g. 0.05).
+Comparison compare(const Stats &baseline, const Stats &current,
+                   double threshold);
+
+// Prints the comparison of every point and returns the number of regressions.
+size_t compare_with_baseline(const Baseline &baseline, const std::string &dwarf,
+                             const MeasureResults &results, double threshold,
+                             std::ostream &os);
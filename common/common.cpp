@@ -1,40 +1,106 @@
 #include "common.hpp"
 #include "boost/dll.hpp"
+#include <chrono>
+#include <cmath>
 #include <cstdlib>
-#include <set>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <thread>
 
 namespace helpers {
-std::vector<uint32_t> make_unique_random(size_t size) {
-  constexpr size_t size_multiplier = 10;
+uint64_t input_seed(const RunOptions &opts, const std::string &stream) {
+  return distribution::derive_seed(opts.seed, stream);
+}
+
+namespace {
+// Largest key of unique inputs, below the empty key of the hash tables.
+uint32_t keys_hi(uint64_t range) {
+  return std::min<uint64_t>(range, std::numeric_limits<uint32_t>::max() - 1);
+}
+} // namespace
+
+std::vector<uint32_t> make_unique_random(const RunOptions &opts,
+                                         const std::string &stream, size_t size,
+                                         uint32_t hi) {
+  return distribution::narrow<uint32_t>(distribution::unique(
+      size, 1, hi ? hi : keys_hi(size * 10), input_seed(opts, stream)));
+}
+
+size_t probe_rows(const RunOptions &opts, size_t build_rows) {
+  return static_cast<size_t>(std::llround(build_rows * opts.probe_ratio));
+}
 
-  std::random_device rd;
-  std::mt19937 gen(rd());
-  std::uniform_int_distribution<int> dist(
-      1, std::min((long)(size * size_multiplier), (long)((uint32_t)-1)));
+namespace {
+size_t distinct_keys(size_t rows, size_t duplicates) {
+  if (duplicates == 0)
+    throw std::invalid_argument("Join keys need at least one row each");
+  return (rows + duplicates - 1) / duplicates;
+}
 
-  std::set<uint32_t> s;
-  while (s.size() < size) {
-    s.insert(dist(gen) % (size * 10));
+// Largest key of join inputs, with room for the probe keys that miss.
+uint32_t join_keys_hi(const RunOptions &opts, size_t build_rows) {
+  const size_t keys =
+      distinct_keys(build_rows, opts.build_duplicates) +
+      distinct_keys(probe_rows(opts, build_rows), opts.probe_duplicates);
+  return keys_hi(std::max(build_rows * 10, keys));
+}
+} // namespace
+
+std::vector<uint32_t> make_build_key_ids(const RunOptions &opts,
+                                         size_t build_rows) {
+  return distribution::narrow<uint32_t>(distribution::repeated(
+      build_rows, opts.build_duplicates, 1, join_keys_hi(opts, build_rows),
+      input_seed(opts, "build_keys")));
+}
+
+std::vector<uint32_t> make_probe_key_ids(const RunOptions &opts,
+                                         size_t build_rows) {
+  return distribution::narrow<uint32_t>(distribution::matching(
+      probe_rows(opts, build_rows),
+      distinct_keys(build_rows, opts.build_duplicates), opts.match_rate,
+      opts.probe_duplicates, 1, join_keys_hi(opts, build_rows),
+      input_seed(opts, "build_keys")));
+}
+
+std::vector<double> load_factors(const RunOptions &opts, double fallback,
+                                 double max) {
+  if (opts.load_factor.empty())
+    return {fallback};
+  for (double lf : opts.load_factor) {
+    if (!(lf > 0 && lf <= max)) {
+      std::ostringstream os;
+      os << "Load factor " << lf << " is out of (0, " << max
+         << "] for this dwarf";
+      throw std::invalid_argument(os.str());
+    }
   }
-  return std::vector<uint32_t>(s.begin(), s.end());
+  return opts.load_factor;
 }
 
-std::vector<int> make_random_uniform_binary(size_t size) {
-  std::random_device rd;
-  std::mt19937 gen(rd());
+size_t table_capacity(size_t entries, double load_factor) {
+  return std::max<size_t>(1, std::ceil(entries / load_factor));
+}
+
+DwarfParams table_params(const RunOptions &opts, size_t buf_size,
+                         double load_factor) {
+  DwarfParams params{{"buf_size", std::to_string(buf_size)}};
+  if (!opts.load_factor.empty()) {
+    std::ostringstream os;
+    os << load_factor;
+    params["load_factor"] = os.str();
+  }
+  return params;
+}
+
+std::vector<int> make_random_uniform_binary(size_t size, uint64_t seed) {
+  std::mt19937_64 gen(seed);
   std::vector<int> out(size);
   std::uniform_int_distribution<int> dist(0, 1);
   std::generate(out.begin(), out.end(), [&]() { return dist(gen); });
   return out;
 }
 
-uint32_t make_random() {
-  std::random_device rd;
-  std::mt19937 gen(rd());
-  std::uniform_int_distribution<int> dist(1, 1000);
-  return dist(gen);
-}
-
 std::string get_kernels_root_env(const char *argv0) {
   auto *val = std::getenv("DWARF_BENCH_ROOT");
   return val ? val : boost::dll::program_location().parent_path().c_str();
@@ -54,4 +120,39 @@ void set_dpcpp_filter_env(const RunOptions &opts) {
 void set_dpcpp_filter_env_no_overwrite(const char *filter) {
   setenv("SYCL_DEVICE_FILTER", filter, 0);
 }
+
+double measure_host_bandwidth() {
+  constexpr size_t size = 1 << 28;
+  constexpr int repetitions = 5;
+  const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  const size_t chunk = size / threads;
+
+  std::vector<char> src(size, 1);
+  std::vector<char> dst(size, 0);
+
+  double best = 0;
+  for (int rep = 0; rep < repetitions; ++rep) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+      size_t len = (t == threads - 1) ? size - t * chunk : chunk;
+      workers.emplace_back([&, t, len]() {
+        std::memcpy(dst.data() + t * chunk, src.data() + t * chunk, len);
+      });
+    }
+    for (auto &w : workers) {
+      w.join();
+    }
+    std::chrono::duration<double> secs =
+        std::chrono::steady_clock::now() - start;
+    best = std::max(best, 2.0 * size / secs.count() / 1e9);
+  }
+  return best;
+}
+
+void calibrate_peak_bandwidth(Meter &meter) {
+  if (meter.opts().measure_peak_bandwidth && !meter.has_peak_bandwidth()) {
+    meter.set_peak_bandwidth(measure_host_bandwidth());
+  }
+}
 } // namespace helpers
\ No newline at end of file
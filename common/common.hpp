@@ -5,9 +5,11 @@
 #include <fstream>
 #include <iostream>
 #include <random>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "dataset.hpp"
 #include "dwarf.hpp"
 #include "meter.hpp"
 #include "options.hpp"
@@ -26,25 +28,93 @@ void dump_collection(const Collection &c, std::ostream &os = std::cout) {
 }
 
 namespace helpers {
-std::vector<uint32_t> make_unique_random(size_t size);
+// Seed of the generated input `stream` (e.g. its column name) under --seed.
+uint64_t input_seed(const RunOptions &opts, const std::string &stream);
 
 template <class T>
-std::vector<T> make_random(size_t size, size_t random_range_left = 1,
+std::vector<T> make_random(const RunOptions &opts, const std::string &stream,
+                           size_t size, size_t random_range_left = 1,
                            size_t random_range_right = 10000) {
-  std::random_device rd;
-  std::mt19937 gen(rd());
+  std::mt19937_64 gen(input_seed(opts, stream));
   std::vector<T> out(size);
   std::uniform_int_distribution<T> dist(random_range_left, random_range_right);
   std::generate(out.begin(), out.end(), [&]() { return dist(gen); });
   return out;
 }
 
-std::vector<uint32_t> make_unique_random(size_t size);
-uint32_t make_random();
-std::vector<int> make_random_uniform_binary(size_t size);
+// Distinct keys in [1, hi] in random order, hi defaults to 10 * size.
+std::vector<uint32_t> make_unique_random(const RunOptions &opts,
+                                         const std::string &stream, size_t size,
+                                         uint32_t hi = 0);
+
+// Inputs of joins with `build_rows` build rows, shaped by the join options.
+// Keys are generated as dense ids, see make_keys_of_ids for other widths.
+size_t probe_rows(const RunOptions &opts, size_t build_rows);
+std::vector<uint32_t> make_build_key_ids(const RunOptions &opts,
+                                         size_t build_rows);
+std::vector<uint32_t> make_probe_key_ids(const RunOptions &opts,
+                                         size_t build_rows);
+
+// Keys of dense ids under --key_width, throws if they do not fit in Key.
+template <class Key>
+std::vector<Key> make_keys_of_ids(const RunOptions &opts,
+                                  const std::vector<uint32_t> &ids) {
+  if (sizeof(Key) < sizeof(uint64_t) && opts.key_width != KeyWidth::Bits32)
+    throw std::invalid_argument("Key width " + to_string(opts.key_width) +
+                                " is not supported by this dwarf");
+  std::vector<Key> keys(ids.size());
+  std::transform(ids.begin(), ids.end(), keys.begin(), [&](uint32_t id) {
+    return static_cast<Key>(id_key(opts.key_width, id));
+  });
+  return keys;
+}
+
+template <class Key = uint32_t>
+std::vector<Key> make_build_keys(const RunOptions &opts, size_t build_rows) {
+  return make_keys_of_ids<Key>(opts, make_build_key_ids(opts, build_rows));
+}
+
+template <class Key = uint32_t>
+std::vector<Key> make_probe_keys(const RunOptions &opts, size_t build_rows) {
+  return make_keys_of_ids<Key>(opts, make_probe_key_ids(opts, build_rows));
+}
+
+// Load factors of the hash table points of a dwarf: --load_factor if given,
+// its `fallback` otherwise. Throws if one is not in (0, max].
+std::vector<double> load_factors(const RunOptions &opts, double fallback,
+                                 double max = 1);
+// Slots for `entries` keys at `load_factor`, at least one.
+size_t table_capacity(size_t entries, double load_factor);
+// Params of a measured hash table point, with the load factor if swept.
+DwarfParams table_params(const RunOptions &opts, size_t buf_size,
+                         double load_factor);
+
+// Keys in [lo, hi] drawn from the distribution selected in the options.
+template <class T>
+std::vector<T> make_keys(const RunOptions &opts, const std::string &stream,
+                         size_t size, T lo, T hi) {
+  return distribution::generate<T>(opts.distribution, size, lo, hi,
+                                   input_seed(opts, stream));
+}
+
+// Rows of column `name` of the --dataset when one is given, otherwise the
+// values returned by `generate`.
+template <class T, class Generate>
+Column<T> input_column(const RunOptions &opts, const std::string &name,
+                       size_t rows, Generate generate) {
+  if (opts.dataset)
+    return opts.dataset->column<T>(name, rows);
+  return Column<T>(generate());
+}
+
+std::vector<int> make_random_uniform_binary(size_t size, uint64_t seed);
 std::string get_kernels_root_env(const char *argv0);
 void set_dpcpp_filter_env_no_overwrite(const char *filter);
 void set_dpcpp_filter_env(const RunOptions &opts);
+// Best-of copy bandwidth of host memory in GB/s, counting read and write.
+double measure_host_bandwidth();
+// Host counterpart of calibrate_peak_bandwidth for dwarfs without a device.
+void calibrate_peak_bandwidth(Meter &meter);
 
 template <typename T, typename U>
 bool check_first(const T &v1, const U &v2, size_t sz) {
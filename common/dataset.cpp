@@ -0,0 +1,110 @@
+#include "dataset.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr char column_magic[8] = {'D', 'W', 'A', 'R', 'F', 'C', 'O', 'L'};
+constexpr uint32_t column_version = 1;
+
+// Bytes per element of the column types, 0 for unknown ones.
+size_t element_size(ColumnType type) {
+  switch (type) {
+  case ColumnType::U32:
+  case ColumnType::I32:
+  case ColumnType::F32:
+    return 4;
+  case ColumnType::U64:
+  case ColumnType::I64:
+  case ColumnType::F64:
+    return 8;
+  }
+  return 0;
+}
+} // namespace
+
+Dataset::Dataset(std::string path) : path_(std::move(path)) {
+  struct stat st;
+  if (stat(path_.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+    throw std::invalid_argument("Dataset " + path_ + " is not a directory");
+}
+
+std::string Dataset::file(const std::string &name) const {
+  return path_ + "/" + name + ".col";
+}
+
+bool Dataset::has_column(const std::string &name) const {
+  struct stat st;
+  return stat(file(name).c_str(), &st) == 0;
+}
+
+Dataset::Mapping::~Mapping() {
+  if (address)
+    munmap(address, length);
+}
+
+std::shared_ptr<const Dataset::Mapping>
+Dataset::map(const std::string &name, ColumnType type, size_t rows) const {
+  const std::string path = file(name);
+  auto &mapping = mappings_[name];
+  if (!mapping) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("Could not open the column file " + path);
+    struct stat st;
+    fstat(fd, &st);
+    auto m = std::make_shared<Mapping>();
+    m->length = st.st_size;
+    if (m->length >= sizeof(ColumnFileHeader)) {
+      void *address = mmap(nullptr, m->length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (address != MAP_FAILED)
+        m->address = address;
+    }
+    close(fd);
+    if (!m->address)
+      throw std::runtime_error("Could not map the column file " + path);
+
+    const auto *header = static_cast<const ColumnFileHeader *>(m->address);
+    if (std::memcmp(header->magic, column_magic, sizeof(column_magic)) != 0 ||
+        header->version != column_version || !element_size(header->type))
+      throw std::runtime_error(path + " is not a column file");
+    // Rows past the end of the file would be read beyond the mapping.
+    const size_t data_length = m->length - sizeof(ColumnFileHeader);
+    if (header->rows > data_length / element_size(header->type))
+      throw std::runtime_error(path + " is truncated, it has " +
+                               std::to_string(data_length) +
+                               " bytes of data for " +
+                               std::to_string(header->rows) + " rows");
+    m->rows = header->rows;
+    m->data = header + 1;
+    mapping = std::move(m);
+  }
+
+  const auto *header = static_cast<const ColumnFileHeader *>(mapping->address);
+  if (header->type != type)
+    throw std::invalid_argument("Column " + path +
+                                " has another element type than expected");
+  if (rows > mapping->rows)
+    throw std::invalid_argument("Column " + path + " has " +
+                                std::to_string(mapping->rows) + " rows, " +
+                                std::to_string(rows) + " requested");
+  return mapping;
+}
+
+void write_column(const std::string &path, ColumnType type, const void *data,
+                  size_t rows, size_t element_size) {
+  std::ofstream of(path, std::ios::binary);
+  if (!of.is_open())
+    throw std::runtime_error("Could not open the file at " + path);
+  ColumnFileHeader header = {};
+  std::memcpy(header.magic, column_magic, sizeof(column_magic));
+  header.version = column_version;
+  header.type = type;
+  header.rows = rows;
+  of.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  of.write(static_cast<const char *>(data), rows * element_size);
+}
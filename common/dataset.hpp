@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Element types of column files.
+enum class ColumnType : uint32_t { U32 = 1, I32, U64, I64, F32, F64 };
+
+template <class T> ColumnType column_type();
+template <> inline ColumnType column_type<uint32_t>() {
+  return ColumnType::U32;
+}
+template <> inline ColumnType column_type<int32_t>() {
+  return ColumnType::I32;
+}
+template <> inline ColumnType column_type<uint64_t>() {
+  return ColumnType::U64;
+}
+template <> inline ColumnType column_type<int64_t>() {
+  return ColumnType::I64;
+}
+template <> inline ColumnType column_type<float>() { return ColumnType::F32; }
+template <> inline ColumnType column_type<double>() { return ColumnType::F64; }
+
+// Header of a column file, followed by `rows` little-endian elements.
+struct ColumnFileHeader {
+  char magic[8]; // "DWARFCOL"
+  uint32_t version;
+  ColumnType type;
+  uint64_t rows;
+  uint64_t reserved;
+};
+static_assert(sizeof(ColumnFileHeader) == 32, "Column data must be aligned");
+
+// Read-only input column of a dwarf. It either owns generated values or
+// refers to a memory-mapped file without copying, and keeps it mapped.
+template <class T> class Column {
+public:
+  using value_type = T;
+  using const_iterator = const T *;
+
+  Column() = default;
+  Column(std::vector<T> values) {
+    auto owned = std::make_shared<const std::vector<T>>(std::move(values));
+    data_ = owned->data();
+    size_ = owned->size();
+    storage_ = std::move(owned);
+  }
+  Column(const T *data, size_t size, std::shared_ptr<const void> storage)
+      : storage_(std::move(storage)), data_(data), size_(size) {}
+
+  const T *data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const T *begin() const { return data_; }
+  const T *end() const { return data_ + size_; }
+  const T &operator[](size_t i) const { return data_[i]; }
+
+  std::vector<T> to_vector() const { return std::vector<T>(begin(), end()); }
+
+private:
+  std::shared_ptr<const void> storage_;
+  const T *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Directory of column files named <column>.col, mapped on first use.
+class Dataset {
+public:
+  explicit Dataset(std::string path);
+
+  const std::string &path() const { return path_; }
+  bool has_column(const std::string &name) const;
+
+  // First `rows` rows of a column, throws if the file is missing, too short
+  // or has another element type.
+  template <class T>
+  Column<T> column(const std::string &name, size_t rows) const {
+    auto mapping = map(name, column_type<T>(), rows);
+    return Column<T>(static_cast<const T *>(mapping->data), rows, mapping);
+  }
+
+private:
+  struct Mapping {
+    ~Mapping();
+    void *address = nullptr;
+    size_t length = 0;
+    const void *data = nullptr;
+    uint64_t rows = 0;
+  };
+
+  std::shared_ptr<const Mapping> map(const std::string &name, ColumnType type,
+                                     size_t rows) const;
+  std::string file(const std::string &name) const;
+
+  std::string path_;
+  mutable std::map<std::string, std::shared_ptr<const Mapping>> mappings_;
+};
+
+// Writes a column file, e.g. to convert real data for --dataset.
+void write_column(const std::string &path, ColumnType type, const void *data,
+                  size_t rows, size_t element_size);
+
+template <class T>
+void write_column(const std::string &path, const std::vector<T> &values) {
+  write_column(path, column_type<T>(), values.data(), values.size(),
+               sizeof(T));
+}
@@ -0,0 +1,323 @@
+#include "distribution.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+struct KindInfo {
+  Distribution::Kind kind;
+  // Used when the parameter is omitted, negative if there is none.
+  double default_param;
+};
+
+const std::map<std::string, KindInfo> kinds = {
+    {"uniform", {Distribution::Uniform, -1}},
+    {"zipf", {Distribution::Zipf, 0.99}},
+    {"selfsimilar", {Distribution::SelfSimilar, 0.2}},
+    {"sequential", {Distribution::Sequential, -1}},
+    {"sorted", {Distribution::Sorted, -1}},
+    {"clustered", {Distribution::Clustered, 16}},
+    {"heavyhitter", {Distribution::HeavyHitter, 0.5}},
+    {"collision", {Distribution::Collision, 1024}}};
+
+bool valid_param(Distribution::Kind kind, double p) {
+  switch (kind) {
+  case Distribution::Zipf:
+    return p > 0;
+  case Distribution::SelfSimilar:
+    return p > 0 && p < 1;
+  case Distribution::HeavyHitter:
+    return p >= 0 && p <= 1;
+  case Distribution::Clustered:
+  case Distribution::Collision:
+    return p >= 1;
+  default:
+    return true;
+  }
+}
+
+// Zipf ranks in [1, n] by rejection-inversion (Hormann and Derflinger), which
+// needs neither a table nor the normalization constant, so it works for any
+// exponent and key range.
+class ZipfSampler {
+public:
+  ZipfSampler(uint64_t n, double exponent) : n_(n), s_(exponent) {
+    h_integral_x1_ = h_integral(1.5) - 1;
+    h_integral_n_ = h_integral(n + 0.5);
+    threshold_ = 2 - h_integral_inverse(h_integral(2.5) - h(2));
+  }
+
+  template <class Gen> uint64_t operator()(Gen &gen) {
+    std::uniform_real_distribution<double> uniform(0, 1);
+    while (true) {
+      double u =
+          h_integral_n_ + uniform(gen) * (h_integral_x1_ - h_integral_n_);
+      double x = h_integral_inverse(u);
+      double k = std::min<double>(std::max(std::floor(x + 0.5), 1.0), n_);
+      if (k - x <= threshold_ || u >= h_integral(k + 0.5) - h(k))
+        return static_cast<uint64_t>(k);
+    }
+  }
+
+private:
+  // log1p(x) / x and expm1(x) / x, stable around 0.
+  static double helper1(double x) {
+    return std::abs(x) > 1e-8 ? std::log1p(x) / x
+                              : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+  }
+  static double helper2(double x) {
+    return std::abs(x) > 1e-8 ? std::expm1(x) / x
+                              : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x));
+  }
+
+  double h(double x) const { return std::exp(-s_ * std::log(x)); }
+  double h_integral(double x) const {
+    double log_x = std::log(x);
+    return helper2((1 - s_) * log_x) * log_x;
+  }
+  double h_integral_inverse(double x) const {
+    double t = std::max(x * (1 - s_), -1.0);
+    return std::exp(helper1(t) * x);
+  }
+
+  uint64_t n_;
+  double s_;
+  double h_integral_x1_;
+  double h_integral_n_;
+  double threshold_;
+};
+
+// Finalizer of splitmix64.
+uint64_t mix(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+// Whether [lo, hi] has at least n values.
+bool fits(uint64_t lo, uint64_t hi, uint64_t n) {
+  return n == 0 || (hi >= lo && hi - lo >= n - 1);
+}
+
+// Sets out[i] = f(i) on all hardware threads.
+template <class F> void parallel_fill(std::vector<uint64_t> &out, F f) {
+  const size_t threads =
+      std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(),
+                                           out.size() / (1 << 16)));
+  const size_t chunk = (out.size() + threads - 1) / threads;
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      const size_t end = std::min(out.size(), (t + 1) * chunk);
+      for (size_t i = t * chunk; i < end; ++i) {
+        out[i] = f(i);
+      }
+    });
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+}
+} // namespace
+
+std::istream &operator>>(std::istream &in, Distribution &d) {
+  std::string spec;
+  in >> spec;
+  std::transform(spec.begin(), spec.end(), spec.begin(),
+                 [](char c) { return std::tolower(c); });
+
+  auto colon = spec.find(':');
+  auto it = kinds.find(spec.substr(0, colon));
+  if (it == kinds.end()) {
+    in.setstate(std::ios::failbit);
+    return in;
+  }
+  d.kind = it->second.kind;
+  d.param = it->second.default_param;
+  if (colon != std::string::npos) {
+    std::istringstream param(spec.substr(colon + 1));
+    if (d.param < 0 || !(param >> d.param) || !param.eof())
+      in.setstate(std::ios::failbit);
+  }
+  if (!valid_param(d.kind, d.param))
+    in.setstate(std::ios::failbit);
+  return in;
+}
+
+std::string to_string(const Distribution &d) {
+  for (const auto &k : kinds) {
+    if (k.second.kind != d.kind)
+      continue;
+    if (k.second.default_param < 0)
+      return k.first;
+    std::ostringstream os;
+    os << k.first << ":" << d.param;
+    return os.str();
+  }
+  return "unknown";
+}
+
+namespace distribution {
+Permutation::Permutation(uint64_t domain, uint64_t seed) : domain_(domain) {
+  unsigned bits = 2;
+  while (bits < 64 && (uint64_t(1) << bits) < domain) {
+    ++bits;
+  }
+  half_bits_ = (bits + 1) / 2;
+  half_mask_ = (uint64_t(1) << half_bits_) - 1;
+  for (auto &key : keys_) {
+    seed = mix(seed + 0x9e3779b97f4a7c15ull);
+    key = seed;
+  }
+}
+
+uint64_t Permutation::operator()(uint64_t i) const {
+  uint64_t x = i;
+  do {
+    uint64_t left = x >> half_bits_;
+    uint64_t right = x & half_mask_;
+    for (uint64_t key : keys_) {
+      uint64_t next = left ^ (mix(right ^ key) & half_mask_);
+      left = right;
+      right = next;
+    }
+    x = (left << half_bits_) | right;
+  } while (x >= domain_);
+  return x;
+}
+
+uint64_t derive_seed(uint64_t seed, const std::string &stream) {
+  // FNV-1a, which unlike std::hash is the same on all platforms.
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (char c : stream) {
+    h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+  }
+  return mix(seed ^ mix(h));
+}
+
+std::vector<uint64_t> generate(const Distribution &d, size_t size, uint64_t lo,
+                               uint64_t hi, uint64_t seed) {
+  if (hi < lo)
+    throw std::invalid_argument("Empty key range");
+  const uint64_t range = hi - lo + 1;
+  std::mt19937_64 gen(seed);
+  std::uniform_int_distribution<uint64_t> uniform(lo, hi);
+  std::vector<uint64_t> out(size);
+
+  switch (d.kind) {
+  case Distribution::Uniform:
+  case Distribution::Sorted:
+    std::generate(out.begin(), out.end(), [&]() { return uniform(gen); });
+    if (d.kind == Distribution::Sorted)
+      std::sort(out.begin(), out.end());
+    break;
+  case Distribution::Zipf: {
+    ZipfSampler zipf(range, d.param);
+    std::generate(out.begin(), out.end(),
+                  [&]() { return lo + zipf(gen) - 1; });
+    break;
+  }
+  case Distribution::SelfSimilar: {
+    std::uniform_real_distribution<double> u(0, 1);
+    const double exponent = std::log(d.param) / std::log(1 - d.param);
+    std::generate(out.begin(), out.end(), [&]() {
+      auto v = static_cast<uint64_t>(range * std::pow(u(gen), exponent));
+      return lo + std::min(v, range - 1);
+    });
+    break;
+  }
+  case Distribution::Sequential:
+    for (size_t i = 0; i < size; ++i) {
+      out[i] = lo + i % range;
+    }
+    break;
+  case Distribution::Clustered: {
+    const auto clusters = static_cast<size_t>(d.param);
+    const uint64_t width = std::max<uint64_t>(1, range / (clusters * 64));
+    std::vector<uint64_t> centers(clusters);
+    std::generate(centers.begin(), centers.end(),
+                  [&]() { return uniform(gen); });
+    std::uniform_int_distribution<size_t> cluster(0, clusters - 1);
+    std::uniform_int_distribution<uint64_t> offset(0, width - 1);
+    std::generate(out.begin(), out.end(), [&]() {
+      return lo + (centers[cluster(gen)] - lo + offset(gen)) % range;
+    });
+    break;
+  }
+  case Distribution::HeavyHitter: {
+    const uint64_t hot = uniform(gen);
+    std::bernoulli_distribution is_hot(d.param);
+    std::generate(out.begin(), out.end(),
+                  [&]() { return is_hot(gen) ? hot : uniform(gen); });
+    break;
+  }
+  case Distribution::Collision: {
+    const auto stride = static_cast<uint64_t>(d.param);
+    std::uniform_int_distribution<uint64_t> slot(0, (range - 1) / stride);
+    std::generate(out.begin(), out.end(),
+                  [&]() { return lo + slot(gen) * stride; });
+    break;
+  }
+  }
+  return out;
+}
+
+std::vector<uint64_t> unique(size_t size, uint64_t lo, uint64_t hi,
+                             uint64_t seed) {
+  if (!fits(lo, hi, size))
+    throw std::invalid_argument("Key range is too small for unique keys");
+  std::vector<uint64_t> out(size);
+  Permutation keys(hi - lo + 1, seed);
+  parallel_fill(out, [&](size_t i) { return lo + keys(i); });
+  return out;
+}
+
+std::vector<uint64_t> repeated(size_t size, size_t duplicates, uint64_t lo,
+                               uint64_t hi, uint64_t seed) {
+  if (duplicates == 0)
+    throw std::invalid_argument("Keys need at least one row each");
+  const size_t distinct = (size + duplicates - 1) / duplicates;
+  if (!fits(lo, hi, distinct))
+    throw std::invalid_argument("Key range is too small for unique keys");
+  std::vector<uint64_t> out(size);
+  Permutation keys(hi - lo + 1, seed);
+  Permutation order(std::max<size_t>(size, 1), derive_seed(seed, "order"));
+  parallel_fill(out, [&](size_t i) { return lo + keys(order(i) % distinct); });
+  return out;
+}
+
+std::vector<uint64_t> matching(size_t size, size_t build_keys,
+                               double match_rate, size_t duplicates,
+                               uint64_t lo, uint64_t hi, uint64_t seed) {
+  if (match_rate < 0 || match_rate > 1)
+    throw std::invalid_argument("Match rate must be in [0, 1]");
+  if (duplicates == 0)
+    throw std::invalid_argument("Keys need at least one row each");
+  const auto matched = static_cast<size_t>(std::llround(match_rate * size));
+  const size_t missing = size - matched;
+  if (matched > 0 && build_keys == 0)
+    throw std::invalid_argument("No build keys to match");
+  // Matching rows repeat build keys more often when there are too few.
+  const size_t hit_keys =
+      std::min((matched + duplicates - 1) / duplicates, build_keys);
+  const size_t miss_keys = (missing + duplicates - 1) / duplicates;
+  if (!fits(lo, hi, build_keys + miss_keys))
+    throw std::invalid_argument("Key range is too small for unique keys");
+
+  // Build keys are keys(i) for i < build_keys, so matches take the indices
+  // picked by `hits` and misses the ones after the build side.
+  std::vector<uint64_t> out(size);
+  Permutation keys(hi - lo + 1, seed);
+  Permutation hits(std::max<size_t>(build_keys, 1), derive_seed(seed, "hits"));
+  Permutation order(std::max<size_t>(size, 1), derive_seed(seed, "probe"));
+  parallel_fill(out, [&](size_t i) {
+    uint64_t j = order(i);
+    return lo + keys(j < matched ? hits(j % hit_keys)
+                                 : build_keys + (j - matched) % miss_keys);
+  });
+  return out;
+}
+} // namespace distribution
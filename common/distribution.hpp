@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Key distribution of generated inputs, parsed from "<kind>[:<param>]":
+//   uniform               uniform over the key range
+//   zipf:<theta>          rank r drawn with probability ~ 1/r^theta
+//   selfsimilar:<h>       fraction h of the range gets 1 - h of the rows
+//   sequential            range values in order, wrapping around
+//   sorted                uniform, sorted ascending
+//   clustered:<clusters>  rows packed around a few random centers
+//   heavyhitter:<share>   a single key gets this share of the rows
+//   collision:<stride>    keys equal modulo stride, so they share a bucket
+//                         of modulo-based hash tables up to that size
+struct Distribution {
+  enum Kind {
+    Uniform,
+    Zipf,
+    SelfSimilar,
+    Sequential,
+    Sorted,
+    Clustered,
+    HeavyHitter,
+    Collision
+  };
+  Kind kind = Uniform;
+  double param = 0;
+};
+
+std::istream &operator>>(std::istream &in, Distribution &d);
+std::string to_string(const Distribution &d);
+
+namespace distribution {
+// Keyed bijection of [0, domain): a Feistel network over the next power of
+// two, cycle-walking values outside the domain. Every element is computed on
+// its own, so distinct values are generated in parallel without a set.
+class Permutation {
+public:
+  Permutation(uint64_t domain, uint64_t seed);
+  uint64_t operator()(uint64_t i) const;
+
+private:
+  uint64_t domain_;
+  unsigned half_bits_;
+  uint64_t half_mask_;
+  uint64_t keys_[4];
+};
+
+// Seed of one generated input (e.g. a column name) under a run seed, so that
+// the inputs of a run differ but are all reproduced by the same seed.
+uint64_t derive_seed(uint64_t seed, const std::string &stream);
+
+// Draws `size` values in [lo, hi] as 64-bit integers.
+std::vector<uint64_t> generate(const Distribution &d, size_t size, uint64_t lo,
+                               uint64_t hi, uint64_t seed);
+
+// `size` distinct values in [lo, hi] in random order.
+std::vector<uint64_t> unique(size_t size, uint64_t lo, uint64_t hi,
+                             uint64_t seed);
+
+// `size` values in [lo, hi] in random order, the keys of one side of a join:
+// each of the first ceil(size / duplicates) values of unique(.., lo, hi, seed)
+// about `duplicates` times.
+std::vector<uint64_t> repeated(size_t size, size_t duplicates, uint64_t lo,
+                               uint64_t hi, uint64_t seed);
+
+// `size` values in [lo, hi] in random order, the keys of the other side of a
+// join with repeated(.., lo, hi, seed) of `build_keys` distinct values:
+// round(match_rate * size) of them are among those and the others are not.
+// Distinct values repeat about `duplicates` times, matching ones more often
+// if there are too few build keys. Throws if the range is too small.
+std::vector<uint64_t> matching(size_t size, size_t build_keys,
+                               double match_rate, size_t duplicates,
+                               uint64_t lo, uint64_t hi, uint64_t seed);
+
+template <class T> std::vector<T> narrow(const std::vector<uint64_t> &values) {
+  static_assert(std::is_integral<T>::value, "Keys must be integers");
+  return std::vector<T>(values.begin(), values.end());
+}
+
+template <class T>
+std::vector<T> generate(const Distribution &d, size_t size, T lo, T hi,
+                        uint64_t seed) {
+  return narrow<T>(generate(d, size, static_cast<uint64_t>(lo),
+                            static_cast<uint64_t>(hi), seed));
+}
+} // namespace distribution
@@ -0,0 +1,222 @@
+#pragma once
+#include "dpcpp_common.hpp"
+#include "hashfunctions.hpp"
+#include <type_traits>
+
+namespace BucketHash {
+constexpr size_t CACHE_LINE = 64;
+constexpr size_t SUBGROUP_SIZE = 16;
+
+// Smallest power-of-two bucket count that keeps `entries` at most
+// `load_factor` of the slots.
+inline size_t buckets_count(size_t entries, size_t bucket_size,
+                            double load_factor = 0.5) {
+  size_t buckets = 1;
+  while (buckets * bucket_size * load_factor < entries) {
+    buckets <<= 1;
+  }
+  return buckets;
+}
+
+// Kernels over `rows` keys get a work-item per key when probing with vector
+// compares and a sub-group per key when probing cooperatively.
+inline sycl::nd_range<1> launch_range(size_t rows, bool cooperative) {
+  size_t items = cooperative ? rows * SUBGROUP_SIZE : rows;
+  items = (items + SUBGROUP_SIZE - 1) / SUBGROUP_SIZE * SUBGROUP_SIZE;
+  return {std::max(items, SUBGROUP_SIZE), SUBGROUP_SIZE};
+}
+inline size_t key_index(const sycl::nd_item<1> &it, bool cooperative) {
+  return cooperative ? it.get_global_id(0) / SUBGROUP_SIZE
+                     : it.get_global_id(0);
+}
+
+template <class Name> class VectorKernel;
+template <class Name> class CooperativeKernel;
+
+// Submits f(it, cooperative) over launch_range(rows, cooperative), where
+// `cooperative` is a std::bool_constant so that sub-group code sits under
+// `if constexpr`. Only the cooperative kernel requires sub-groups of
+// SUBGROUP_SIZE lanes, so vector probing runs on devices without them.
+template <class Name, class F>
+void parallel_for(sycl::handler &h, size_t rows, bool cooperative, F f) {
+  if (cooperative) {
+    h.parallel_for<CooperativeKernel<Name>>(
+        launch_range(rows, true),
+        [=](sycl::nd_item<1> it)
+            [[intel::reqd_sub_group_size(SUBGROUP_SIZE)]] {
+              f(it, std::true_type());
+            });
+  } else {
+    h.parallel_for<VectorKernel<Name>>(
+        launch_range(rows, false),
+        [=](sycl::nd_item<1> it) { f(it, std::false_type()); });
+  }
+}
+} // namespace BucketHash
+
+// Open addressing over buckets of a cache line of keys (16 32-bit or 8
+// 64-bit ones) and a power-of-two number of buckets, so probing moves to the
+// next bucket with a mask. A bucket is looked up at once: by a single vector
+// compare in a work-item, or by the lanes of a sub-group that all pass the
+// same key. Like SimpleNonOwningHashTable, a key may be inserted more than
+// once and entries are never removed.
+template <class Key, class T, class Hash> class BucketizedHashTable {
+public:
+  static constexpr size_t bucket_size = BucketHash::CACHE_LINE / sizeof(Key);
+
+  explicit BucketizedHashTable(size_t buckets, sycl::global_ptr<Key> keys,
+                               sycl::global_ptr<T> vals, Hash hash,
+                               Key empty_key)
+      : _keys(keys), _vals(vals), _mask(buckets - 1), _hasher(hash),
+        _empty_key(empty_key) {}
+
+  bool insert(Key key, T val) {
+    size_t bucket = _hasher(key) & _mask;
+    for (size_t step = 0; step <= _mask; ++step) {
+      for (uint32_t empty = match(bucket, _empty_key); empty;
+           empty &= empty - 1) {
+        const size_t at = bucket * bucket_size + sycl::ctz(empty);
+        Key expected = _empty_key;
+        if (sycl::atomic<Key>(_keys + at).compare_exchange_strong(expected,
+                                                                  key)) {
+          _vals[at] = val;
+          return true;
+        }
+      }
+      bucket = (bucket + 1) & _mask;
+    }
+    return false;
+  }
+
+  // Calls f(value, i) for the i-th entry with `key` and returns the number
+  // of entries.
+  template <class F> size_t find_all(const Key &key, F f) const {
+    size_t found = 0;
+    size_t bucket = _hasher(key) & _mask;
+    for (size_t step = 0; step <= _mask; ++step) {
+      for (uint32_t hits = match(bucket, key); hits; hits &= hits - 1) {
+        f(_vals[bucket * bucket_size + sycl::ctz(hits)], found++);
+      }
+      if (match(bucket, _empty_key))
+        break;
+      bucket = (bucket + 1) & _mask;
+    }
+    return found;
+  }
+
+  bool has(const Key &key) const {
+    size_t bucket = _hasher(key) & _mask;
+    for (size_t step = 0; step <= _mask; ++step) {
+      if (match(bucket, key))
+        return true;
+      if (match(bucket, _empty_key))
+        return false;
+      bucket = (bucket + 1) & _mask;
+    }
+    return false;
+  }
+
+  // The same operations on a bucket at a time by a whole sub-group, with
+  // every lane comparing the slots lane, lane + lanes, ...
+  bool insert(const sycl::sub_group &sg, Key key, T val) {
+    const size_t lane = sg.get_local_id()[0];
+    const size_t lanes = sg.get_local_range()[0];
+    size_t bucket = _hasher(key) & _mask;
+    for (size_t step = 0; step <= _mask; ++step) {
+      for (size_t base = 0; base < bucket_size; base += lanes) {
+        const size_t slot = base + lane;
+        const size_t at = bucket * bucket_size + slot;
+        bool empty = slot < bucket_size && _keys[at] == _empty_key;
+        while (sycl::any_of_group(sg, empty)) {
+          const size_t first = sycl::reduce_over_group(
+              sg, empty ? lane : lanes, sycl::minimum<size_t>());
+          bool done = false;
+          if (lane == first) {
+            Key expected = _empty_key;
+            done = sycl::atomic<Key>(_keys + at)
+                       .compare_exchange_strong(expected, key);
+            if (done)
+              _vals[at] = val;
+            empty = false;
+          }
+          if (sycl::group_broadcast(sg, done, first))
+            return true;
+        }
+      }
+      bucket = (bucket + 1) & _mask;
+    }
+    return false;
+  }
+
+  // Calls f(value, i) in the lane holding the i-th entry with `key` and
+  // returns the number of entries to all lanes.
+  template <class F>
+  size_t find_all(const sycl::sub_group &sg, const Key &key, F f) const {
+    const size_t lane = sg.get_local_id()[0];
+    const size_t lanes = sg.get_local_range()[0];
+    size_t found = 0;
+    size_t bucket = _hasher(key) & _mask;
+    for (size_t step = 0; step <= _mask; ++step) {
+      bool empty = false;
+      for (size_t base = 0; base < bucket_size; base += lanes) {
+        const size_t slot = base + lane;
+        const size_t at = bucket * bucket_size + slot;
+        const Key k = slot < bucket_size ? _keys[at] : _empty_key;
+        size_t hit = slot < bucket_size && k == key;
+        size_t before =
+            sycl::exclusive_scan_over_group(sg, hit, sycl::plus<size_t>());
+        if (hit)
+          f(_vals[at], found + before);
+        found += sycl::reduce_over_group(sg, hit, sycl::plus<size_t>());
+        empty |= slot < bucket_size && k == _empty_key;
+      }
+      if (sycl::any_of_group(sg, empty))
+        break;
+      bucket = (bucket + 1) & _mask;
+    }
+    return found;
+  }
+
+  bool has(const sycl::sub_group &sg, const Key &key) const {
+    const size_t lane = sg.get_local_id()[0];
+    const size_t lanes = sg.get_local_range()[0];
+    size_t bucket = _hasher(key) & _mask;
+    for (size_t step = 0; step <= _mask; ++step) {
+      bool hit = false;
+      bool empty = false;
+      for (size_t base = lane; base < bucket_size; base += lanes) {
+        const Key k = _keys[bucket * bucket_size + base];
+        hit |= k == key;
+        empty |= k == _empty_key;
+      }
+      if (sycl::any_of_group(sg, hit))
+        return true;
+      if (sycl::any_of_group(sg, empty))
+        return false;
+      bucket = (bucket + 1) & _mask;
+    }
+    return false;
+  }
+
+private:
+  sycl::global_ptr<Key> _keys;
+  sycl::global_ptr<T> _vals;
+  size_t _mask;
+  Hash _hasher;
+  Key _empty_key;
+
+  // Bit i is set if slot i of the bucket holds `key`. The bucket is loaded
+  // as one sycl::vec, so the compare is a single AVX2/AVX-512 instruction
+  // on CPUs.
+  uint32_t match(size_t bucket, Key key) const {
+    sycl::vec<Key, bucket_size> slots;
+    slots.load(bucket, _keys);
+    const auto equal = slots == sycl::vec<Key, bucket_size>(key);
+    uint32_t bits = 0;
+#pragma unroll
+    for (int i = 0; i < bucket_size; ++i) {
+      bits |= uint32_t(equal[i] != 0) << i;
+    }
+    return bits;
+  }
+};
@@ -1,10 +1,13 @@
+#pragma once
 #include <CL/sycl.hpp>
 #include <algorithm>
 
 #include "dpcpp_common.hpp"
 #include "hashfunctions.hpp"
+#include "probe_stats.hpp"
 
-template <class Key, class Val, class Hasher1, class Hasher2>
+template <class Key, class Val, class Hasher1, class Hasher2,
+          class Stats = NoProbeStats>
 class CuckooHashtable {
 private:
   sycl::global_ptr<Key> _keys;
@@ -13,6 +16,7 @@ private:
   const size_t _input_size;
   Hasher1 _hasher1;
   Hasher2 _hasher2;
+  Stats _stats;
   const Key _EMPTY_KEY = std::numeric_limits<Key>::max();
   sycl::global_ptr<uint32_t> _bitmask;
   static constexpr uint32_t elem_sz = CHAR_BIT * sizeof(uint32_t);
@@ -22,22 +26,27 @@ public:
   explicit CuckooHashtable(const size_t input_size, sycl::global_ptr<Key> keys,
                            sycl::global_ptr<Val> vals,
                            sycl::global_ptr<uint32_t> bitmask, Hasher1 hasher1,
-                           Hasher2 hasher2)
+                           Hasher2 hasher2, Stats stats = Stats())
       : _input_size(input_size), _keys(keys), _vals(vals), _bitmask(bitmask),
-        _hasher1(hasher1), _hasher2(hasher2) {}
+        _hasher1(hasher1), _hasher2(hasher2), _stats(stats) {}
 
   const std::pair<Val, bool> at(Key key) const {
     auto pos1 = _hasher1(key);
     auto pos2 = _hasher2(key);
-    if (_keys[pos1] == key)
+    if (_keys[pos1] == key) {
+      _stats.lookup(1);
       return {_vals[pos1], true};
+    }
+    _stats.lookup(2);
     if (_keys[pos2] == key)
       return {_vals[pos2], true};
     return {{}, false};
   }
 
   bool has(Key key) const {
-    return _keys[_hasher1(key)] == key || _keys[_hasher2(key)] == key;
+    const bool first = _keys[_hasher1(key)] == key;
+    _stats.lookup(first ? 1 : 2);
+    return first || _keys[_hasher2(key)] == key;
   }
 
   bool insert(Key key, Val value) {
@@ -49,16 +58,19 @@ public:
         _vals[pos] = value;
 
         unlock(pos);
+        _stats.insert(cnt + 1);
         return true;
       }
       std::swap(key, _keys[pos]);
       std::swap(value, _vals[pos]);
       unlock(pos);
+      _stats.eviction();
       if (pos == _hasher1(key))
         pos = _hasher2(key);
       else
         pos = _hasher1(key);
     }
+    _stats.insert(std::min(_input_size, max_iter));
     return false;
   }
 
@@ -69,6 +81,8 @@ public:
     uint32_t mask = uint32_t(1) << minor_idx;
     do {
       present = sycl::atomic<uint32_t>(_bitmask + major_idx).fetch_or(mask);
+      if (present & mask)
+        _stats.cas_failure();
     } while (present & mask);
   }
 
@@ -78,4 +92,126 @@ public:
     uint32_t mask = uint32_t(1) << minor_idx;
     sycl::atomic<uint32_t>(_bitmask + major_idx).fetch_and(~mask);
   }
-};
\ No newline at end of file
+};
+
+// Cuckoo hashing over buckets of a cache line of slots, to which the two
+// hash functions map keys. A key and its value are packed into one 64-bit
+// entry, so inserts claim empty slots with a compare-and-swap and evict with
+// an exchange instead of locking slots. An insert that still holds an entry
+// after max_evictions puts it into a small stash and, if that is full, gives
+// it back to the caller, which collects it for another attempt.
+template <class Hasher1, class Hasher2, class Stats = NoProbeStats>
+class BucketizedCuckooHashtable {
+public:
+  using Key = uint32_t;
+  using Val = uint32_t;
+
+  static constexpr size_t bucket_size = 8;
+  static constexpr size_t stash_size = 32;
+  static constexpr size_t max_evictions = 128;
+  static constexpr Key empty_key = std::numeric_limits<Key>::max();
+  static constexpr uint64_t empty_entry = std::numeric_limits<uint64_t>::max();
+
+  // Slots of a table of `buckets` buckets, the stash included.
+  static size_t slots_count(size_t buckets) {
+    return buckets * bucket_size + stash_size;
+  }
+
+  static uint64_t pack(Key key, Val val) {
+    return (uint64_t(key) << 32) | val;
+  }
+  static Key key_of(uint64_t entry) { return Key(entry >> 32); }
+  static Val val_of(uint64_t entry) { return Val(entry); }
+
+  // `slots` holds slots_count(buckets) entries set to empty_entry, and the
+  // hashers map keys to [0, buckets).
+  explicit BucketizedCuckooHashtable(size_t buckets,
+                                     sycl::global_ptr<uint64_t> slots,
+                                     Hasher1 hasher1, Hasher2 hasher2,
+                                     Stats stats = Stats())
+      : _slots(slots), _stash(slots + buckets * bucket_size),
+        _hasher1(hasher1), _hasher2(hasher2), _stats(stats) {}
+
+  // Inserts an entry made by pack(). Returns false if it gave up, leaving
+  // in `entry` the one it still holds, which may be another key evicted on
+  // the way.
+  bool insert(uint64_t &entry) {
+    size_t bucket = _hasher1(key_of(entry));
+    size_t probes = 1;
+    if (claim(_slots + bucket * bucket_size, bucket_size, entry))
+      return inserted(probes);
+    bucket = _hasher2(key_of(entry));
+    for (size_t step = 0; step < max_evictions; ++step) {
+      ++probes;
+      if (claim(_slots + bucket * bucket_size, bucket_size, entry))
+        return inserted(probes);
+      // The victim depends on the step, so that inserts evicting each other
+      // from a pair of full buckets move on to other slots.
+      const size_t victim = (key_of(entry) + step) % bucket_size;
+      entry = sycl::atomic<uint64_t>(_slots + bucket * bucket_size + victim)
+                  .exchange(entry);
+      _stats.eviction();
+      const size_t first = _hasher1(key_of(entry));
+      bucket = first == bucket ? _hasher2(key_of(entry)) : first;
+    }
+    if (claim(_stash, stash_size, entry))
+      return inserted(probes + 1);
+    _stats.insert(probes + 1);
+    return false;
+  }
+
+  // Looks up the two buckets of the key and then the stash.
+  const std::pair<Val, bool> at(Key key) const {
+    sycl::global_ptr<uint64_t> slots[] = {
+        _slots + _hasher1(key) * bucket_size,
+        _slots + _hasher2(key) * bucket_size, _stash};
+    const size_t counts[] = {bucket_size, bucket_size, stash_size};
+    for (size_t probes = 0; probes < 3; ++probes) {
+      const size_t i = find(slots[probes], counts[probes], key);
+      if (i < counts[probes]) {
+        _stats.lookup(probes + 1);
+        return {val_of(slots[probes][i]), true};
+      }
+    }
+    _stats.lookup(3);
+    return {{}, false};
+  }
+
+  bool has(Key key) const { return at(key).second; }
+
+private:
+  sycl::global_ptr<uint64_t> _slots;
+  sycl::global_ptr<uint64_t> _stash;
+  Hasher1 _hasher1;
+  Hasher2 _hasher2;
+  Stats _stats;
+
+  bool inserted(size_t probes) const {
+    _stats.insert(probes);
+    return true;
+  }
+
+  // Puts the entry into the first empty one of `count` slots.
+  bool claim(sycl::global_ptr<uint64_t> slots, size_t count,
+             uint64_t entry) const {
+    for (size_t i = 0; i < count; ++i) {
+      if (key_of(slots[i]) != empty_key)
+        continue;
+      uint64_t expected = empty_entry;
+      if (sycl::atomic<uint64_t>(slots + i).compare_exchange_strong(expected,
+                                                                    entry))
+        return true;
+      _stats.cas_failure();
+    }
+    return false;
+  }
+
+  // Index of the key among `count` slots, or `count` if it is absent.
+  size_t find(sycl::global_ptr<uint64_t> slots, size_t count, Key key) const {
+    size_t i = 0;
+    while (i < count && key_of(slots[i]) != key) {
+      ++i;
+    }
+    return i;
+  }
+};
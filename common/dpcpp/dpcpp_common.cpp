@@ -1,4 +1,6 @@
 #include "dpcpp_common.hpp"
+#include "queue_manager.hpp"
+#include <chrono>
 
 std::unique_ptr<cl::sycl::device_selector>
 get_device_selector(const RunOptions &opts) {
@@ -16,4 +18,60 @@ get_device_selector(const RunOptions &opts) {
   default:
     throw std::logic_error("Unsupported device type.");
   }
+}
+
+DeviceInfo get_device_info(const sycl::device &device) {
+  using namespace sycl::info;
+  DeviceInfo info;
+  info.name = device.get_info<device::name>();
+  info.vendor = device.get_info<device::vendor>();
+  info.driver_version = device.get_info<device::driver_version>();
+  info.compute_units = device.get_info<device::max_compute_units>();
+  info.max_work_group_size = device.get_info<device::max_work_group_size>();
+  info.global_mem_bytes = device.get_info<device::global_mem_size>();
+#ifdef __VERSION__
+  info.compiler = __VERSION__;
+#endif
+  return info;
+}
+
+void report_device(const sycl::queue &q, Meter &meter) {
+  DeviceInfo info = get_device_info(q.get_device());
+  std::cout << "Selected device: " << info.name << "\n";
+  meter.set_device_info(std::move(info));
+}
+
+double measure_peak_bandwidth(sycl::queue &q) {
+  constexpr size_t size = 1 << 26;
+  constexpr int repetitions = 5;
+  uint32_t *src = sycl::malloc_device<uint32_t>(size, q);
+  uint32_t *dst = sycl::malloc_device<uint32_t>(size, q);
+  q.fill(src, uint32_t(1), size).wait();
+
+  double best = 0;
+  // the first run pays for JIT compilation and is not counted
+  for (int rep = 0; rep <= repetitions; ++rep) {
+    auto start = std::chrono::steady_clock::now();
+    q.parallel_for<class peak_bandwidth_copy>(
+         sycl::range<1>{size}, [=](sycl::id<1> idx) { dst[idx] = src[idx]; })
+        .wait();
+    std::chrono::duration<double> secs =
+        std::chrono::steady_clock::now() - start;
+    if (rep > 0) {
+      best = std::max(best, 2.0 * size * sizeof(uint32_t) / secs.count() / 1e9);
+    }
+  }
+
+  sycl::free(src, q);
+  sycl::free(dst, q);
+  return best;
+}
+
+void calibrate_peak_bandwidth(sycl::queue &q, Meter &meter) {
+  const RunOptions &opts = meter.opts();
+  if (opts.measure_peak_bandwidth && !meter.has_peak_bandwidth()) {
+    meter.set_peak_bandwidth(opts.queues
+                                 ? opts.queues->peak_bandwidth(opts.device_ty)
+                                 : measure_peak_bandwidth(q));
+  }
 }
\ No newline at end of file
@@ -1,6 +1,19 @@
 #pragma once
+#include "common/meter.hpp"
 #include "common/options.hpp"
+#include "profiler.hpp"
+#include "queue_manager.hpp"
 #include <CL/sycl.hpp>
 
 std::unique_ptr<cl::sycl::device_selector>
-get_device_selector(const RunOptions &opts);
\ No newline at end of file
+get_device_selector(const RunOptions &opts);
+
+DeviceInfo get_device_info(const sycl::device &device);
+// Prints the selected device and records it for the reports.
+void report_device(const sycl::queue &q, Meter &meter);
+
+// Best-of device-to-device copy bandwidth in GB/s, counting read and write.
+double measure_peak_bandwidth(sycl::queue &q);
+// Measures the peak bandwidth of the queue's device once per meter if it was
+// requested with the options.
+void calibrate_peak_bandwidth(sycl::queue &q, Meter &meter);
@@ -0,0 +1,265 @@
+#pragma once
+#include "dpcpp_common.hpp"
+#include "hashfunctions.hpp"
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+// Linear probing over a power-of-two table, the device side of a
+// GrowableHashTable between two resizes. New keys take a slot only while
+// fewer than `limit` slots are used, at most all but one, so probing always
+// ends at an empty slot. Inserts of new keys past the limit fail and are
+// retried by the owner once the table has grown.
+template <class Key, class T, class Hash> class GrowableHashTableView {
+public:
+  GrowableHashTableView(size_t capacity, uint32_t limit,
+                        sycl::global_ptr<Key> keys, sycl::global_ptr<T> vals,
+                        sycl::global_ptr<uint32_t> used, Hash hash,
+                        Key empty_key)
+      : _keys(keys), _vals(vals), _used(used), _mask(capacity - 1),
+        _limit(limit), _hasher(capacity, hash), _empty_key(empty_key) {}
+
+  // Sets the value of `key`, last writer wins for duplicates.
+  bool insert(Key key, T val) { return update<false>(key, val); }
+
+  // Adds `val` to the value of `key`, which starts at 0.
+  bool add(Key key, T val) { return update<true>(key, val); }
+
+  const std::pair<T, bool> at(const Key &key) const {
+    for (size_t pos = _hasher(key);; pos = (pos + 1) & _mask) {
+      const Key k = _keys[pos];
+      if (k == key)
+        return {_vals[pos], true};
+      if (k == _empty_key)
+        return {{}, false};
+    }
+  }
+
+  bool has(const Key &key) const { return at(key).second; }
+
+private:
+  sycl::global_ptr<Key> _keys;
+  sycl::global_ptr<T> _vals;
+  sycl::global_ptr<uint32_t> _used;
+  size_t _mask;
+  uint32_t _limit;
+  Pow2Hasher<Hash> _hasher;
+  Key _empty_key;
+
+  template <bool Add> bool update(Key key, T val) {
+    for (size_t pos = _hasher(key);; pos = (pos + 1) & _mask) {
+      Key k = _keys[pos];
+      if (k == _empty_key) {
+        if (!reserve())
+          return false;
+        Key expected = _empty_key;
+        if (sycl::atomic<Key>(_keys + pos)
+                .compare_exchange_strong(expected, key)) {
+          k = key;
+        } else {
+          release();
+          k = expected;
+        }
+      }
+      if (k == key) {
+        if (Add)
+          sycl::atomic<T>(_vals + pos).fetch_add(val);
+        else
+          sycl::atomic<T>(_vals + pos).store(val);
+        return true;
+      }
+    }
+  }
+
+  bool reserve() {
+    if (sycl::atomic<uint32_t>(_used).fetch_add(1) < _limit)
+      return true;
+    release();
+    return false;
+  }
+  void release() { sycl::atomic<uint32_t>(_used).fetch_sub(1); }
+};
+
+template <class Key, class T, class Hash> class GrowableInsert;
+template <class Key, class T, class Hash> class GrowableAdd;
+template <class Key, class T, class Hash> class GrowableRehash;
+
+// Owning hash table in device memory for inputs of unknown cardinality. It
+// starts at `capacity` slots, at least two, and doubles once more than
+// `max_load_factor` of them would be used: rows whose key found no free slot
+// are collected by the insert kernel, the table is rehashed in parallel into
+// one of twice the size and the collected rows are inserted again, until
+// none is left.
+template <class Key, class T, class Hash> class GrowableHashTable {
+public:
+  using View = GrowableHashTableView<Key, T, Hash>;
+  static constexpr size_t MAX_CAPACITY = size_t(1) << 31;
+
+  GrowableHashTable(sycl::queue &q, size_t capacity, double max_load_factor,
+                    Hash hash = Hash(),
+                    Key empty_key = std::numeric_limits<Key>::max())
+      : _q(q), _hash(hash), _empty_key(empty_key),
+        _max_load_factor(max_load_factor) {
+    if (!(max_load_factor > 0 && max_load_factor < 1))
+      throw std::invalid_argument("Load factor must be in (0, 1)");
+    _used = sycl::malloc_device<uint32_t>(COUNTERS, _q);
+    _capacity = 2;
+    while (_capacity < capacity) {
+      _capacity <<= 1;
+    }
+    allocate(_capacity, _keys, _vals);
+  }
+  GrowableHashTable(const GrowableHashTable &) = delete;
+  GrowableHashTable &operator=(const GrowableHashTable &) = delete;
+  ~GrowableHashTable() {
+    sycl::free(_keys, _q);
+    sycl::free(_vals, _q);
+    sycl::free(_used, _q);
+    sycl::free(_pending[0], _q);
+    sycl::free(_pending[1], _q);
+  }
+
+  size_t capacity() const { return _capacity; }
+  size_t rehashes() const { return _rehashes; }
+  size_t bytes() const { return _capacity * (sizeof(Key) + sizeof(T)); }
+  size_t size() const {
+    uint32_t used = 0;
+    _q.memcpy(&used, _used + USED, sizeof(used)).wait();
+    return used;
+  }
+
+  // For lookups in kernels, valid until the next insert.
+  View view() const { return view(_capacity, _keys, _vals); }
+
+  // Rows keys[i], vals[i] of device memory. The kernels are recorded with
+  // `profiler` if one is given.
+  void insert(const Key *keys, const T *vals, size_t rows,
+              EventProfiler *profiler = nullptr) {
+    apply<false>(keys, vals, rows, profiler);
+  }
+  void add(const Key *keys, const T *vals, size_t rows,
+           EventProfiler *profiler = nullptr) {
+    apply<true>(keys, vals, rows, profiler);
+  }
+
+private:
+  enum Counter { USED, FAILED, COUNTERS };
+
+  sycl::queue &_q;
+  Hash _hash;
+  Key _empty_key;
+  double _max_load_factor;
+  size_t _capacity = 0;
+  size_t _rehashes = 0;
+  Key *_keys = nullptr;
+  T *_vals = nullptr;
+  uint32_t *_used = nullptr;
+  // Indices of the rows to retry, read and written alternately.
+  uint32_t *_pending[2] = {nullptr, nullptr};
+  size_t _pending_size = 0;
+
+  uint32_t limit(size_t capacity) const {
+    return std::min(capacity - 1,
+                    std::max<size_t>(1, capacity * _max_load_factor));
+  }
+
+  View view(size_t capacity, Key *keys, T *vals) const {
+    return View(capacity, limit(capacity), sycl::global_ptr<Key>(keys),
+                sycl::global_ptr<T>(vals), sycl::global_ptr<uint32_t>(_used),
+                _hash, _empty_key);
+  }
+
+  void allocate(size_t capacity, Key *&keys, T *&vals) {
+    keys = sycl::malloc_device<Key>(capacity, _q);
+    vals = sycl::malloc_device<T>(capacity, _q);
+    if (!keys || !vals) {
+      sycl::free(keys, _q);
+      sycl::free(vals, _q);
+      throw std::bad_alloc();
+    }
+    _q.fill(keys, _empty_key, capacity);
+    _q.fill(vals, T(0), capacity);
+    _q.memset(_used, 0, COUNTERS * sizeof(uint32_t));
+    _q.wait();
+  }
+
+  template <bool Add>
+  void apply(const Key *keys, const T *vals, size_t rows,
+             EventProfiler *profiler) {
+    if (rows > _pending_size) {
+      sycl::free(_pending[0], _q);
+      sycl::free(_pending[1], _q);
+      _pending[0] = sycl::malloc_device<uint32_t>(rows, _q);
+      _pending[1] = sycl::malloc_device<uint32_t>(rows, _q);
+      _pending_size = rows;
+    }
+
+    const uint32_t *in = nullptr;
+    size_t pending = rows;
+    for (int pass = 0; pending > 0; ++pass) {
+      uint32_t *out = _pending[pass % 2];
+      _q.memset(_used + FAILED, 0, sizeof(uint32_t)).wait();
+      const View ht = view();
+      sycl::global_ptr<uint32_t> failed(_used + FAILED);
+
+      sycl::event e;
+      if (Add) {
+        e = _q.parallel_for<GrowableAdd<Key, T, Hash>>(
+            pending, [=](sycl::id<1> i) {
+              const size_t row = in ? in[i] : i;
+              View table = ht;
+              if (!table.add(keys[row], vals[row]))
+                out[sycl::atomic<uint32_t>(failed).fetch_add(1)] = row;
+            });
+      } else {
+        e = _q.parallel_for<GrowableInsert<Key, T, Hash>>(
+            pending, [=](sycl::id<1> i) {
+              const size_t row = in ? in[i] : i;
+              View table = ht;
+              if (!table.insert(keys[row], vals[row]))
+                out[sycl::atomic<uint32_t>(failed).fetch_add(1)] = row;
+            });
+      }
+      if (profiler)
+        profiler->kernel(e, "growable_insert");
+
+      uint32_t failures = 0;
+      _q.memcpy(&failures, _used + FAILED, sizeof(failures), e).wait();
+      pending = failures;
+      in = out;
+      if (pending > 0)
+        grow(profiler);
+    }
+  }
+
+  void grow(EventProfiler *profiler) {
+    const size_t capacity = 2 * _capacity;
+    if (capacity > MAX_CAPACITY)
+      throw std::length_error("Growable hash table is full");
+    Key *keys;
+    T *vals;
+    allocate(capacity, keys, vals);
+
+    // Keys are distinct, so every one is stored as is at its new slot.
+    const View to = view(capacity, keys, vals);
+    const Key *old_keys = _keys;
+    const T *old_vals = _vals;
+    const Key empty_key = _empty_key;
+    sycl::event e = _q.parallel_for<GrowableRehash<Key, T, Hash>>(
+        _capacity, [=](sycl::id<1> i) {
+          View table = to;
+          if (old_keys[i] != empty_key)
+            table.insert(old_keys[i], old_vals[i]);
+        });
+    if (profiler)
+      profiler->kernel(e, "growable_rehash");
+    e.wait();
+
+    sycl::free(_keys, _q);
+    sycl::free(_vals, _q);
+    _keys = keys;
+    _vals = vals;
+    _capacity = capacity;
+    ++_rehashes;
+  }
+};
@@ -1,19 +1,28 @@
+#pragma once
+#include "common/hashers.hpp"
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <climits>
 #include <random>
+#include <stdexcept>
+#if defined(__SSE4_2__) && !defined(__SYCL_DEVICE_ONLY__)
+#include <nmmintrin.h>
+#endif
 
+// The base is drawn from `seed`, e.g. helpers::input_seed(opts, "hasher").
 struct PolynomialHasher {
-  PolynomialHasher(size_t sz) {
+  PolynomialHasher(size_t sz, uint64_t seed) {
     _sz = sz;
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937_64 gen(seed);
     std::uniform_int_distribution<int> dist(0, 13);
     p = possible_p[dist(gen)];
   }
 
-  size_t operator()(const uint32_t &v) const {
-    uint32_t v_copy = v;
-    int res = 0;
-    int pow_p = p;
+  template <class Key> size_t operator()(const Key &v) const {
+    Key v_copy = v;
+    uint64_t res = 0;
+    uint64_t pow_p = p;
     while (v_copy > 0) {
       res += ((v_copy % 10) * pow_p) % _sz;
       res = res % _sz;
@@ -31,11 +40,13 @@ private:
 };
 
 template <size_t Size> struct StaticSimpleHasher {
-  size_t operator()(const uint32_t &v) const { return v % Size; }
+  template <class Key> size_t operator()(const Key &v) const {
+    return v % Size;
+  }
 };
 
 template <size_t Size, size_t Offset> struct StaticSimpleHasherWithOffset {
-  size_t operator()(const uint32_t &v) const {
+  template <class Key> size_t operator()(const Key &v) const {
     return (v % Size + Offset) % Size;
   }
 };
@@ -51,7 +62,7 @@ private:
 struct SimpleHasherWithOffset {
   SimpleHasherWithOffset(size_t sz, size_t offset)
       : _sz(sz), _offset(offset % sz) {}
-  size_t operator()(const uint32_t &v) const {
+  template <class Key> size_t operator()(const Key &v) const {
     return (v % _sz + _offset) % _sz;
   }
   size_t get_offset() { return _offset; }
@@ -62,8 +73,7 @@ private:
 };
 
 struct MurmurHash3_x86_32 {
-  MurmurHash3_x86_32(size_t sz, int len, uint32_t seed)
-      : _sz(sz), _len(len), _seed(seed) {}
+  MurmurHash3_x86_32(size_t sz, uint32_t seed) : _sz(sz), _seed(seed) {}
 
   inline uint32_t rotl32(uint32_t x, int8_t r) const {
     return (x << r) | (x >> (32 - r));
@@ -84,10 +94,12 @@ struct MurmurHash3_x86_32 {
     return h;
   }
 
-  size_t operator()(const uint32_t &v) const {
+  // Hashes all bytes of the key and none past it.
+  template <class Key> size_t operator()(const Key &v) const {
     const void *key = &v;
     const uint8_t *data = (const uint8_t *)key;
-    const int nblocks = _len / 4;
+    const int len = sizeof(Key);
+    const int nblocks = len / 4;
 
     uint32_t h1 = _seed;
 
@@ -112,7 +124,7 @@ struct MurmurHash3_x86_32 {
 
     uint32_t k1 = 0;
 
-    switch (_len & 3) {
+    switch (len & 3) {
     case 3:
       k1 ^= tail[2] << 16;
     case 2:
@@ -125,13 +137,134 @@ struct MurmurHash3_x86_32 {
       h1 ^= k1;
     };
 
-    h1 ^= _len;
+    h1 ^= len;
     h1 = fmix32(h1);
     return h1 % _sz;
   }
 
 private:
   size_t _sz;
-  int _len;
   uint32_t _seed;
 };
+
+// 64-bit hashes of keys for power-of-two tables, next to Fibonacci of
+// common/hashers.hpp.
+namespace Hashes {
+struct MultiplyShift {
+  // The multiplier is a random odd number, mixed so that small seeds work.
+  explicit MultiplyShift(uint64_t seed)
+      : a(Fibonacci()(seed ^ (seed >> 29)) | 1) {}
+  template <class Key> uint64_t operator()(const Key &v) const {
+    return uint64_t(v) * a;
+  }
+  uint64_t a;
+};
+
+// CRC-32C, with the SSE 4.2 instruction on the host and bit by bit in
+// kernels, which give the same values.
+struct Crc32 {
+  template <class Key> uint64_t operator()(const Key &v) const {
+    uint32_t crc = ~0u;
+#if defined(__SSE4_2__) && !defined(__SYCL_DEVICE_ONLY__)
+    if (sizeof(Key) == sizeof(uint64_t))
+      crc = _mm_crc32_u64(crc, uint64_t(v));
+    else
+      crc = _mm_crc32_u32(crc, uint32_t(v));
+#else
+    const uint64_t x = uint64_t(v);
+    for (size_t i = 0; i < CHAR_BIT * sizeof(Key); ++i) {
+      crc ^= (x >> i) & 1;
+      crc = (crc >> 1) ^ (0x82f63b78u & (0u - (crc & 1)));
+    }
+#endif
+    // CRC is linear over the key bits, so its top bits alone would leave
+    // some slots of power-of-two tables unused.
+    return uint64_t(~crc) * 0x9e3779b97f4a7c15ull;
+  }
+};
+
+struct XxHash {
+  template <class Key> uint64_t operator()(const Key &v) const {
+    uint64_t h = uint64_t(v) * 0xc2b2ae3d27d4eb4full;
+    h ^= h >> 33;
+    h *= 0x165667b19e3779f9ull;
+    h ^= h >> 29;
+    h *= 0x85ebca77c2b2ae63ull;
+    return h ^ (h >> 32);
+  }
+};
+
+struct WyHash {
+  template <class Key> uint64_t operator()(const Key &v) const {
+    const uint64_t a = uint64_t(v) ^ 0xa0761d6478bd642full;
+    const uint64_t b = 0xe7037ed1a0b428dbull;
+    return (a * b) ^ sycl::mul_hi(a, b);
+  }
+};
+} // namespace Hashes
+
+// Index into a table of a power-of-two size from the upper bits of a 64-bit
+// hash, with a shift instead of a modulo. The shift is a constant when the
+// size is given at compile time.
+template <class Hash, size_t Size = 0> class Pow2Hasher {
+  static_assert((Size & (Size - 1)) == 0, "Size must be a power of two");
+
+public:
+  explicit Pow2Hasher(size_t size = Size, Hash hash = Hash())
+      : _shift(shift(size)), _hash(hash) {
+    if (size == 0 || (size & (size - 1)) != 0 || (Size && size != Size))
+      throw std::invalid_argument("Hash table size " + std::to_string(size) +
+                                  " is not a power of two");
+  }
+
+  template <class Key> size_t operator()(const Key &v) const {
+    // Two shifts, since a shift by 64 is undefined for tables of one slot.
+    return (_hash(v) >> 1) >> ((Size ? static_shift : _shift) - 1);
+  }
+
+private:
+  static constexpr unsigned shift(size_t size) {
+    unsigned bits = 0;
+    while ((size_t(1) << bits) < size) {
+      ++bits;
+    }
+    return 64 - bits;
+  }
+  static constexpr unsigned static_shift = shift(Size ? Size : 1);
+
+  unsigned _shift;
+  Hash _hash;
+};
+
+// Smallest table of at least `slots` slots that `kind` can index.
+inline size_t hashed_table_size(HasherKind kind, size_t slots) {
+  if (kind == HasherKind::Default)
+    return slots;
+  size_t size = 1;
+  while (size < slots) {
+    size <<= 1;
+  }
+  return size;
+}
+
+// Calls f(hasher) with the hasher of --hasher for a table of `size` slots
+// (see hashed_table_size), or with `fallback` for the default one.
+template <class Fallback, class F>
+void with_hasher(HasherKind kind, size_t size, uint64_t seed,
+                 Fallback fallback, F f) {
+  switch (kind) {
+  case HasherKind::MultiplyShift:
+    return f(Pow2Hasher<Hashes::MultiplyShift>(
+        size, Hashes::MultiplyShift(seed)));
+  case HasherKind::Fibonacci:
+    return f(Pow2Hasher<Hashes::Fibonacci>(size));
+  case HasherKind::Crc32:
+    return f(Pow2Hasher<Hashes::Crc32>(size));
+  case HasherKind::XxHash:
+    return f(Pow2Hasher<Hashes::XxHash>(size));
+  case HasherKind::WyHash:
+    return f(Pow2Hasher<Hashes::WyHash>(size));
+  default:
+    return f(fallback);
+  }
+}
@@ -1,18 +1,22 @@
 #pragma once
 #include "dpcpp_common.hpp"
 #include "hashfunctions.hpp"
+#include "probe_stats.hpp"
 
-template <class Key, class T, class Hash> class SimpleNonOwningHashTable {
+template <class Key, class T, class Hash, class Stats = NoProbeStats>
+class SimpleNonOwningHashTable {
 public:
   explicit SimpleNonOwningHashTable(size_t size, sycl::global_ptr<Key> keys,
                                     sycl::global_ptr<T> vals,
                                     sycl::global_ptr<uint32_t> bitmask,
-                                    Hash hash)
+                                    Hash hash, Stats stats = Stats())
       : _keys(keys), _vals(vals), _bitmask(bitmask), _size(size),
-        _hasher(hash) {}
+        _hasher(hash), _stats(stats) {}
 
   std::pair<uint32_t, bool> insert(Key key, T val) {
-    uint32_t pos = update_bitmask(_hasher(key));
+    const uint32_t start = _hasher(key);
+    uint32_t pos = update_bitmask(start);
+    _stats.insert((pos >= start ? pos - start : pos + _size - start) + 1);
     _keys[pos] = key;
     _vals[pos] = val;
     // todo
@@ -22,37 +26,70 @@ public:
   const std::pair<T, bool> at(const Key &key) const {
     uint32_t pos = _hasher(key);
     const auto start = pos;
+    size_t probes = 1;
     bool present = (_bitmask[pos / elem_sz] & (uint32_t(1) << pos % elem_sz));
     while (present) {
       if (_keys[pos] == key) {
+        _stats.lookup(probes);
         return {_vals[pos], true};
       }
 
-      pos = (++pos) % _size;
+      pos = pos + 1 == _size ? 0 : pos + 1;
       if (pos == start)
         break;
+      ++probes;
 
       present = (_bitmask[pos / elem_sz] & (uint32_t(1) << pos % elem_sz));
     }
 
+    _stats.lookup(probes);
     return {{}, false};
   }
 
-  bool has(const Key &key) const {
+  // Calls f(value, i) for the i-th entry with `key` (inserted more than once
+  // for joins with duplicates) and returns the number of entries.
+  template <class F> size_t find_all(const Key &key, F f) const {
     uint32_t pos = _hasher(key);
     const auto start = pos;
+    size_t probes = 1;
+    size_t found = 0;
     bool present = (_bitmask[pos / elem_sz] & (uint32_t(1) << pos % elem_sz));
     while (present) {
       if (_keys[pos] == key)
+        f(_vals[pos], found++);
+
+      pos = pos + 1 == _size ? 0 : pos + 1;
+      if (pos == start)
+        break;
+      ++probes;
+
+      present = (_bitmask[pos / elem_sz] & (uint32_t(1) << pos % elem_sz));
+    }
+
+    _stats.lookup(probes);
+    return found;
+  }
+
+  bool has(const Key &key) const {
+    uint32_t pos = _hasher(key);
+    const auto start = pos;
+    size_t probes = 1;
+    bool present = (_bitmask[pos / elem_sz] & (uint32_t(1) << pos % elem_sz));
+    while (present) {
+      if (_keys[pos] == key) {
+        _stats.lookup(probes);
         return true;
+      }
 
-      pos = (++pos) % _size;
+      pos = pos + 1 == _size ? 0 : pos + 1;
       if (pos == start)
         break;
+      ++probes;
 
       present = (_bitmask[pos / elem_sz] & (uint32_t(1) << pos % elem_sz));
     }
 
+    _stats.lookup(probes);
     return false;
   }
 
@@ -62,6 +99,7 @@ private:
   sycl::global_ptr<uint32_t> _bitmask;
   size_t _size;
   Hash _hasher;
+  Stats _stats;
 
   static constexpr uint32_t elem_sz = CHAR_BIT * sizeof(uint32_t);
 
@@ -71,52 +109,69 @@ private:
 
     while (true) {
       uint32_t mask = uint32_t(1) << minor_idx;
-      uint32_t present =
-          sycl::atomic<uint32_t>(_bitmask + major_idx).fetch_or(mask);
+      // Occupied slots are skipped without an atomic update, so a taken bit
+      // seen by fetch_or is a race lost to another work-item.
+      uint32_t present = sycl::atomic<uint32_t>(_bitmask + major_idx).load();
       if (!(present & mask)) {
-        return major_idx * elem_sz + minor_idx;
+        present = sycl::atomic<uint32_t>(_bitmask + major_idx).fetch_or(mask);
+        if (!(present & mask)) {
+          return major_idx * elem_sz + minor_idx;
+        }
+        _stats.cas_failure();
       }
 
-      minor_idx++;
-      uint32_t occupied =
-          sycl::ext::intel::ctz<uint32_t>(~(present >> minor_idx));
-      if (occupied + minor_idx == elem_sz) {
-        major_idx = (++major_idx) % _size;
-        minor_idx = 0;
+      // The next free slot of the word, or the first of the next one.
+      const uint32_t above =
+          minor_idx + 1 < elem_sz ? ~present >> (minor_idx + 1) : 0;
+      if (above) {
+        minor_idx += 1 + sycl::ext::intel::ctz<uint32_t>(above);
       } else {
-        minor_idx += occupied;
+        ++major_idx;
+        minor_idx = 0;
+      }
+      // Bits past the last slot are not slots of the table, so probing
+      // wraps around to the first one there.
+      if (major_idx * elem_sz + minor_idx >= _size) {
+        major_idx = 0;
+        minor_idx = 0;
       }
     }
   }
 };
 
-template <class Key, class T, class Hash> class NonOwningHashTableNonBitmask {
+template <class Key, class T, class Hash, class Stats = NoProbeStats>
+class NonOwningHashTableNonBitmask {
 public:
   explicit NonOwningHashTableNonBitmask(size_t size, sycl::global_ptr<Key> keys,
                                         sycl::global_ptr<T> vals, Hash hash,
-                                        Key empty_key)
+                                        Key empty_key, Stats stats = Stats())
       : _keys(keys), _vals(vals), _size(size), _hasher(hash),
-        _empty_key(empty_key) {}
+        _empty_key(empty_key), _stats(stats) {}
 
   bool add(Key key, T val) { return add_update(key, val); }
 
   bool insert(Key key, T val) { return insert_update(key, val); }
 
   const std::pair<T, bool> at(const Key &key) const {
-    uint32_t pos = _hasher(key);
+    const uint32_t start = _hasher(key);
+    uint32_t pos = start;
+    size_t probes = 1;
     bool present = !(_keys[pos] == _empty_key);
     while (present) {
       if (_keys[pos] == key) {
+        _stats.lookup(probes);
         return {_vals[pos], true};
       }
 
-      pos = (++pos) % _size;
-      if (pos == _hasher(key))
+      pos = pos + 1 == _size ? 0 : pos + 1;
+      if (pos == start)
         break;
+      ++probes;
 
       present = !(_keys[pos] == _empty_key);
     }
 
+    _stats.lookup(probes);
     return {{}, false};
   }
 
@@ -128,44 +183,61 @@ private:
   size_t _size;
   Hash _hasher;
   Key _empty_key;
+  Stats _stats;
 
   static constexpr uint32_t elem_sz = CHAR_BIT * sizeof(uint32_t);
 
+  // Whether slot `at` holds `key`, storing it if the slot is empty. Occupied
+  // slots are not compare-and-swapped, so failed ones are lost races.
+  bool take(uint32_t at, Key key) {
+    Key current = sycl::atomic<Key>(_keys + at).load();
+    if (current == _empty_key) {
+      if (sycl::atomic<Key>(_keys + at).compare_exchange_strong(current, key))
+        return true;
+      _stats.cas_failure();
+    }
+    return current == key;
+  }
+
   bool add_update(Key key, T val) {
-    uint32_t at = _hasher(key);
+    const uint32_t start = _hasher(key);
+    uint32_t at = start;
+    size_t probes = 1;
 
     while (true) {
-      Key expected_key = _empty_key;
-      bool success = sycl::atomic<uint32_t>(_keys + at)
-                         .compare_exchange_strong(expected_key, key);
-      if (success || expected_key == key) {
-        sycl::atomic<uint32_t>(_vals + at).fetch_add(val);
+      if (take(at, key)) {
+        sycl::atomic<T>(_vals + at).fetch_add(val);
+        _stats.insert(probes);
         return true;
       }
 
-      at = (++at) % _size;
-      if (at == _hasher(key)) {
+      at = at + 1 == _size ? 0 : at + 1;
+      if (at == start) {
+        _stats.insert(probes);
         return false;
       }
+      ++probes;
     }
   }
 
   bool insert_update(Key key, T val) {
-    uint32_t at = _hasher(key);
+    const uint32_t start = _hasher(key);
+    uint32_t at = start;
+    size_t probes = 1;
 
     while (true) {
-      Key expected_key = _empty_key;
-      bool success = sycl::atomic<uint32_t>(_keys + at)
-                         .compare_exchange_strong(expected_key, key);
-      if (success || expected_key == key) {
-        sycl::atomic<uint32_t>(_vals + at).store(val);
+      if (take(at, key)) {
+        sycl::atomic<T>(_vals + at).store(val);
+        _stats.insert(probes);
         return true;
       }
 
-      at = (++at) % _size;
-      if (at == _hasher(key)) {
+      at = at + 1 == _size ? 0 : at + 1;
+      if (at == start) {
+        _stats.insert(probes);
         return false;
       }
+      ++probes;
     }
   }
 };
@@ -182,15 +254,16 @@ public:
   bool insert(Key key, T val) { return insert_update(key, val); }
 
   const std::pair<T, bool> at(const Key &key) const {
-    uint32_t pos = _hasher(key);
+    const uint32_t start = _hasher(key);
+    uint32_t pos = start;
     bool present = !(_keys[pos] == _empty_key);
     while (present) {
       if (_keys[pos] == key) {
         return {_vals[pos], true};
       }
 
-      pos = (++pos) % _size;
-      if (pos == _hasher(key))
+      pos = pos + 1 == _size ? 0 : pos + 1;
+      if (pos == start)
         break;
 
       present = !(_keys[pos] == _empty_key);
@@ -211,7 +284,8 @@ private:
   static constexpr uint32_t elem_sz = CHAR_BIT * sizeof(uint32_t);
 
   bool add_update(Key key, T val) {
-    uint32_t at = _hasher(key);
+    const uint32_t start = _hasher(key);
+    uint32_t at = start;
 
     while (true) {
       if (_keys[at] == _empty_key) {
@@ -222,15 +296,16 @@ private:
         return true;
       }
 
-      at = (++at) % _size;
-      if (at == _hasher(key)) {
+      at = at + 1 == _size ? 0 : at + 1;
+      if (at == start) {
         return false;
       }
     }
   }
 
   bool insert_update(Key key, T val) {
-    uint32_t at = _hasher(key);
+    const uint32_t start = _hasher(key);
+    uint32_t at = start;
 
     while (true) {
       if (_keys[at] == _empty_key) {
@@ -241,8 +316,8 @@ private:
         return true;
       }
 
-      at = (++at) % _size;
-      if (at == _hasher(key)) {
+      at = at + 1 == _size ? 0 : at + 1;
+      if (at == start) {
         return false;
       }
     }
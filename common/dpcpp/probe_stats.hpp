@@ -0,0 +1,123 @@
+#pragma once
+#include "common/result.hpp"
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Instrumentation policies of the hash tables, a template parameter that
+// defaults to NoProbeStats, whose calls compile to nothing. Tables report
+// the slots (or slab nodes) visited by every insert and lookup, lost
+// compare-and-swaps, cuckoo evictions and allocated slab nodes.
+struct NoProbeStats {
+  NoProbeStats() = default;
+  explicit NoProbeStats(sycl::global_ptr<uint64_t>) {}
+
+  void insert(size_t) const {}
+  void lookup(size_t) const {}
+  void cas_failure() const {}
+  void eviction() const {}
+  void node_allocated() const {}
+};
+
+// Aggregates the events on the device with atomic increments of a
+// ProbeCounters buffer. The increments contend, so timings of instrumented
+// runs are only comparable with each other.
+class DeviceProbeStats {
+public:
+  static constexpr size_t histogram_size = ProbeStats::histogram_size;
+  static constexpr size_t inserts_at = 0;
+  static constexpr size_t lookups_at = histogram_size;
+  static constexpr size_t cas_failures_at = 2 * histogram_size;
+  static constexpr size_t evictions_at = cas_failures_at + 1;
+  static constexpr size_t nodes_at = cas_failures_at + 2;
+  static constexpr size_t size = cas_failures_at + 3;
+
+  DeviceProbeStats() = default;
+  explicit DeviceProbeStats(sycl::global_ptr<uint64_t> counters)
+      : _counters(counters) {}
+
+  void insert(size_t probes) const { add(inserts_at + bucket(probes)); }
+  void lookup(size_t probes) const { add(lookups_at + bucket(probes)); }
+  void cas_failure() const { add(cas_failures_at); }
+  void eviction() const { add(evictions_at); }
+  void node_allocated() const { add(nodes_at); }
+
+private:
+  sycl::global_ptr<uint64_t> _counters;
+
+  static size_t bucket(size_t probes) {
+    return std::min<size_t>(std::max<size_t>(probes, 1), histogram_size) - 1;
+  }
+
+  void add(size_t at) const {
+    sycl::atomic<uint64_t>(_counters + at).fetch_add(1);
+  }
+};
+
+// Kernel argument of a Stats policy, which kernels build with
+// Stats(acc.get_pointer()). It holds an accessor of the counters only for
+// DeviceProbeStats, so uninstrumented kernels neither copy the counters to
+// the device nor wait for them.
+template <class Stats> struct ProbeAccessor {
+  sycl::global_ptr<uint64_t> get_pointer() const { return {}; }
+};
+template <> struct ProbeAccessor<DeviceProbeStats> {
+  sycl::accessor<uint64_t, 1, sycl::access::mode::read_write> acc;
+  sycl::global_ptr<uint64_t> get_pointer() const { return acc.get_pointer(); }
+};
+
+// Device counters of one measured iteration, zeroed on construction and only
+// allocated if enabled.
+class ProbeCounters {
+public:
+  explicit ProbeCounters(bool enabled) {
+    if (!enabled)
+      return;
+    _host.assign(DeviceProbeStats::size, 0);
+    _buf.emplace(_host.data(), sycl::range<1>{_host.size()});
+  }
+  ProbeCounters(const ProbeCounters &) = delete;
+  ProbeCounters &operator=(const ProbeCounters &) = delete;
+
+  // The counters for the kernels of `h` with the policy Stats.
+  template <class Stats> ProbeAccessor<Stats> access(sycl::handler &h) {
+    if constexpr (std::is_same<Stats, DeviceProbeStats>::value) {
+      if (!_buf)
+        throw std::logic_error("Probe counters are disabled");
+      return {_buf->get_access<sycl::access::mode::read_write>(h)};
+    } else {
+      return {};
+    }
+  }
+
+  // Waits for the kernels and sets result.probes if enabled.
+  void fill(Result &result) {
+    if (!_buf)
+      return;
+    auto c = _buf->get_access<sycl::access::mode::read>();
+    ProbeStats &p = result.probes;
+    p.collected = true;
+    for (size_t i = 0; i < DeviceProbeStats::histogram_size; ++i) {
+      p.inserts[i] = c[DeviceProbeStats::inserts_at + i];
+      p.lookups[i] = c[DeviceProbeStats::lookups_at + i];
+    }
+    p.cas_failures = c[DeviceProbeStats::cas_failures_at];
+    p.evictions = c[DeviceProbeStats::evictions_at];
+    p.nodes_allocated = c[DeviceProbeStats::nodes_at];
+  }
+
+private:
+  std::vector<uint64_t> _host;
+  std::optional<sycl::buffer<uint64_t>> _buf;
+};
+
+// Calls f(NoProbeStats()) or, with --probe_stats, f(DeviceProbeStats()) to
+// instantiate a dwarf's kernels with the policy as decltype of the argument.
+template <class F> void with_probe_stats(bool enabled, F f) {
+  if (enabled)
+    return f(DeviceProbeStats());
+  return f(NoProbeStats());
+}
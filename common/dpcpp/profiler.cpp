@@ -0,0 +1,55 @@
+#include "profiler.hpp"
+#include <chrono>
+
+sycl::event EventProfiler::add(DeviceCommand::Kind kind, sycl::event e,
+                               const std::string &name) {
+  DeviceCommand cmd;
+  cmd.name = name;
+  cmd.kind = kind;
+  cmd.host_submit = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count();
+  events_.emplace_back(cmd, e);
+  return e;
+}
+
+sycl::event EventProfiler::h2d(sycl::event e, const std::string &name) {
+  return add(DeviceCommand::H2D, e, name);
+}
+
+sycl::event EventProfiler::kernel(sycl::event e, const std::string &name) {
+  return add(DeviceCommand::Kernel, e, name);
+}
+
+sycl::event EventProfiler::d2h(sycl::event e, const std::string &name) {
+  return add(DeviceCommand::D2H, e, name);
+}
+
+void EventProfiler::fill(Result &result) const {
+  using namespace sycl::info;
+  for (auto [cmd, e] : events_) {
+    e.wait();
+    cmd.submit = e.get_profiling_info<event_profiling::command_submit>();
+    cmd.start = e.get_profiling_info<event_profiling::command_start>();
+    cmd.end = e.get_profiling_info<event_profiling::command_end>();
+
+    unsigned long duration = cmd.end - cmd.start;
+    switch (cmd.kind) {
+    case DeviceCommand::H2D:
+      result.h2d_time += duration;
+      break;
+    case DeviceCommand::Kernel:
+      result.kernel_time += duration;
+      break;
+    case DeviceCommand::D2H:
+      result.d2h_time += duration;
+      break;
+    }
+    result.commands.push_back(cmd);
+  }
+
+  auto host_ns = static_cast<unsigned long>(result.host_time.count() * 1000);
+  unsigned long device_ns =
+      result.h2d_time + result.kernel_time + result.d2h_time;
+  result.queue_time = host_ns > device_ns ? host_ns - device_ns : 0;
+}
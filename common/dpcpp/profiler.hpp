@@ -0,0 +1,63 @@
+#pragma once
+#include "common/dataset.hpp"
+#include "common/result.hpp"
+#include <CL/sycl.hpp>
+#include <string>
+#include <vector>
+
+// Records the device commands of one measured iteration and splits its host
+// time into H2D transfers, kernels, D2H transfers and queue overhead. The
+// queue must have profiling enabled, which get_queue() queues do.
+class EventProfiler {
+public:
+  sycl::event h2d(sycl::event e, const std::string &name = "h2d");
+  sycl::event kernel(sycl::event e, const std::string &name = "kernel");
+  sycl::event d2h(sycl::event e, const std::string &name = "d2h");
+
+  // Explicit transfers, so that they can be timed. `dst` and `src` buffers
+  // are expected to be created without host memory.
+  template <class T>
+  sycl::event upload(sycl::queue &q, const T *src, sycl::buffer<T> &dst) {
+    return h2d(q.submit([&](sycl::handler &h) {
+      auto acc = dst.template get_access<sycl::access::mode::discard_write>(h);
+      h.copy(src, acc);
+    }));
+  }
+
+  template <class T>
+  sycl::event upload(sycl::queue &q, const std::vector<T> &src,
+                     sycl::buffer<T> &dst) {
+    return upload(q, src.data(), dst);
+  }
+
+  template <class T>
+  sycl::event upload(sycl::queue &q, const Column<T> &src,
+                     sycl::buffer<T> &dst) {
+    return upload(q, src.data(), dst);
+  }
+
+  template <class T>
+  sycl::event download(sycl::queue &q, sycl::buffer<T> &src, T *dst) {
+    return d2h(q.submit([&](sycl::handler &h) {
+      auto acc = src.template get_access<sycl::access::mode::read>(h);
+      h.copy(acc, dst);
+    }));
+  }
+
+  template <class T>
+  sycl::event download(sycl::queue &q, sycl::buffer<T> &src,
+                       std::vector<T> &dst) {
+    return download(q, src, dst.data());
+  }
+
+  // Adds device times of the recorded commands to `result`, host_time must
+  // be set already. Whatever host time is not spent in device commands is
+  // reported as queue overhead.
+  void fill(Result &result) const;
+
+private:
+  sycl::event add(DeviceCommand::Kind kind, sycl::event e,
+                  const std::string &name);
+
+  std::vector<std::pair<DeviceCommand, sycl::event>> events_;
+};
@@ -0,0 +1,72 @@
+#include "queue_manager.hpp"
+#include "dpcpp_common.hpp"
+#include <iostream>
+
+QueueManager::DeviceState::DeviceState(const sycl::device &dev)
+    : device(dev), context(dev),
+      queue(context, dev, {sycl::property::queue::enable_profiling{}}),
+      in_order_queue(context, dev,
+                     {sycl::property::queue::enable_profiling{},
+                      sycl::property::queue::in_order{}}) {}
+
+QueueManager::DeviceState &
+QueueManager::state(RunOptions::DeviceType device_ty) {
+  auto it = devices_.find(device_ty);
+  if (it != devices_.end())
+    return *it->second;
+
+  RunOptions opts;
+  opts.device_ty = device_ty;
+  sycl::device dev{*get_device_selector(opts)};
+  auto state = std::make_unique<DeviceState>(dev);
+  try {
+    state->bundle = std::make_unique<
+        sycl::kernel_bundle<sycl::bundle_state::executable>>(
+        sycl::get_kernel_bundle<sycl::bundle_state::executable>(
+            state->context, {dev}));
+  } catch (const sycl::exception &e) {
+    // Not fatal, kernels are then built on first use.
+    std::cerr << "Could not prebuild kernels for "
+              << dev.get_info<sycl::info::device::name>() << ": " << e.what()
+              << std::endl;
+  }
+  return *devices_.emplace(device_ty, std::move(state)).first->second;
+}
+
+sycl::queue QueueManager::queue(RunOptions::DeviceType device_ty) {
+  return state(device_ty).queue;
+}
+
+sycl::queue QueueManager::in_order_queue(RunOptions::DeviceType device_ty) {
+  return state(device_ty).in_order_queue;
+}
+
+sycl::context QueueManager::context(RunOptions::DeviceType device_ty) {
+  return state(device_ty).context;
+}
+
+double QueueManager::peak_bandwidth(RunOptions::DeviceType device_ty) {
+  DeviceState &s = state(device_ty);
+  if (s.peak_bandwidth == 0)
+    s.peak_bandwidth = measure_peak_bandwidth(s.queue);
+  return s.peak_bandwidth;
+}
+
+std::shared_ptr<QueueManager> make_queue_manager() {
+  return std::make_shared<QueueManager>();
+}
+
+sycl::queue get_queue(const RunOptions &opts) {
+  if (opts.queues)
+    return opts.queues->queue(opts.device_ty);
+  return sycl::queue{*get_device_selector(opts),
+                     {sycl::property::queue::enable_profiling{}}};
+}
+
+sycl::queue get_in_order_queue(const RunOptions &opts) {
+  if (opts.queues)
+    return opts.queues->in_order_queue(opts.device_ty);
+  return sycl::queue{*get_device_selector(opts),
+                     {sycl::property::queue::enable_profiling{},
+                      sycl::property::queue::in_order{}}};
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "common/options.hpp"
+#include <CL/sycl.hpp>
+#include <map>
+#include <memory>
+
+// Owns one context per device type for the whole process, so that context
+// creation and kernel JIT are paid once instead of on every dwarf run.
+// Queues are created with profiling enabled.
+class QueueManager {
+public:
+  sycl::queue queue(RunOptions::DeviceType device_ty);
+  sycl::queue in_order_queue(RunOptions::DeviceType device_ty);
+  sycl::context context(RunOptions::DeviceType device_ty);
+  // Copy bandwidth of the device, measured on first request.
+  double peak_bandwidth(RunOptions::DeviceType device_ty);
+
+private:
+  struct DeviceState {
+    explicit DeviceState(const sycl::device &dev);
+
+    sycl::device device;
+    sycl::context context;
+    sycl::queue queue;
+    sycl::queue in_order_queue;
+    // Executable bundle with every kernel of the application, built eagerly
+    // and kept alive so the runtime does not rebuild programs.
+    std::unique_ptr<sycl::kernel_bundle<sycl::bundle_state::executable>>
+        bundle;
+    double peak_bandwidth = 0;
+  };
+
+  DeviceState &state(RunOptions::DeviceType device_ty);
+
+  std::map<RunOptions::DeviceType, std::unique_ptr<DeviceState>> devices_;
+};
+
+std::shared_ptr<QueueManager> make_queue_manager();
+
+// Queue from the manager injected with the options, or a new one when the
+// dwarf runs without a manager (e.g. from tests).
+sycl::queue get_queue(const RunOptions &opts);
+sycl::queue get_in_order_queue(const RunOptions &opts);
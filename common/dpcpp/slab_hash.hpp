@@ -1,10 +1,13 @@
 #pragma once
 
 #include "dpcpp_common.hpp"
+#include "probe_stats.hpp"
 #include <CL/sycl.hpp>
 #include <algorithm>
 #include <cmath>
+#include <new>
 #include <optional>
+#include <stdexcept>
 
 namespace SlabHash {
 using sycl::access::address_space::global_device_space;
@@ -27,38 +30,24 @@ constexpr size_t BUCKETS_COUNT = 1024;
 
 constexpr size_t EMPTY_UINT32_T = std::numeric_limits<uint32_t>::max();
 
-int calculate_buckets_count(size_t input_size, int mem_util) {
-  float avg_bucket = 1.f;
-  switch (mem_util) {
-  case 20:
-    avg_bucket = 0.2;
-    break;
-  case 30:
-    avg_bucket = 0.3;
-    break;
-  case 40:
-    avg_bucket = 0.4;
-    break;
-  case 50:
-    avg_bucket = 0.55;
-    break;
-  case 60:
-    avg_bucket = 0.625;
-    break;
-  case 70:
-    avg_bucket = 0.875;
-    break;
-  case 80:
-    avg_bucket = 1.875;
-    break;
-  default:
-    break;
-  }
-  return (float)input_size / (SLAB_SIZE * avg_bucket);
+// Entries per slot of the first slabs of the lists by default.
+constexpr double DEFAULT_LOAD_FACTOR = 0.625;
+
+// Lists whose first slabs hold `input_size` entries at `load_factor`, which
+// may exceed 1 as the lists chain more slabs.
+inline size_t buckets_count(size_t input_size, double load_factor) {
+  return std::max<size_t>(1, std::ceil(input_size / (SLAB_SIZE * load_factor)));
+}
+
+// Slabs of the heap for `input_size` entries in `buckets` lists: a first
+// one per list and enough to chain all entries.
+inline size_t nodes_count(size_t input_size, size_t buckets) {
+  return buckets + (input_size + SLAB_SIZE - 1) / SLAB_SIZE;
 }
 
 template <size_t A, size_t B, size_t P> struct DefaultHasher {
-  size_t operator()(const uint32_t &k, int buckets_count = BUCKETS_COUNT) {
+  template <class Key>
+  size_t operator()(const Key &k, int buckets_count = BUCKETS_COUNT) {
     return ((A * k + B) % P) % buckets_count;
   };
 };
@@ -80,24 +69,154 @@ template <typename T> struct SlabList {
   sycl::device_ptr<SlabNode<T>> root;
 };
 
+// Device memory of `buckets` lists and a heap of `nodes` slabs.
+template <typename T> size_t memory_size(size_t buckets, size_t nodes) {
+  return buckets * sizeof(SlabList<T>) + nodes * sizeof(SlabNode<T>);
+}
+
+// Slabs of a heap, the ones holding entries and whether a kernel found no
+// free slab.
+struct HeapUsage {
+  size_t allocated = 0;
+  size_t used = 0;
+  bool overflowed = false;
+};
+
 namespace detail {
+constexpr size_t MAX_SUPER_BLOCKS = 32;
+
+// Super-blocks of the heap in device memory, so that kernels see the ones
+// added after the heap was copied to the device.
+template <typename T> struct HeapLayout {
+  uint32_t super_blocks = 0;
+  // Blocks before each super-block, and all blocks after the last one.
+  size_t first_block[MAX_SUPER_BLOCKS + 1] = {};
+  SlabNode<T> *nodes[MAX_SUPER_BLOCKS] = {};
+  uint32_t *bitmaps[MAX_SUPER_BLOCKS] = {};
+};
+
+// Slab allocator after SlabAlloc (Ashkiani et al.): super-blocks of blocks
+// of 32 slabs with a bitmap word each. A sub-group starts looking for a free
+// slab in the block picked by its id, so sub-groups mostly set bits of
+// different words, and freed slabs are reused. The host adds super-blocks
+// with reserve() between kernels, at least doubling the heap each time. A
+// kernel that finds the heap full gets no slab and flags the overflow
+// instead of writing past it.
 template <typename T> struct HeapMaster {
-  HeapMaster(size_t cluster_size, sycl::queue &q) : _q(q) {
-    _heap = sycl::malloc_device<SlabNode<T>>(cluster_size, q);
-    _offset = 0;
+  static constexpr size_t BLOCK_SLABS = UINT32_T_BIT;
+
+  HeapMaster(size_t cluster_size, sycl::queue &q)
+      : _host(new HeapLayout<T>()), _q(q) {
+    _layout = sycl::malloc_device<HeapLayout<T>>(1, q);
+    _counters = sycl::malloc_device<uint32_t>(COUNTERS, q);
+    q.memset(_counters.get(), 0, COUNTERS * sizeof(uint32_t)).wait();
+    reserve(std::max<size_t>(cluster_size, 1));
+  }
+
+  ~HeapMaster() {
+    for (uint32_t i = 0; i < _host->super_blocks; ++i) {
+      sycl::free(_host->nodes[i], _q);
+      sycl::free(_host->bitmaps[i], _q);
+    }
+    sycl::free(_layout, _q);
+    sycl::free(_counters, _q);
+    delete _host;
   }
 
-  ~HeapMaster() { sycl::free(_heap, _q); }
+  // Adds a super-block if the heap has less than `slabs` slabs. Throws if
+  // the device is out of memory or the heap out of super-blocks.
+  void reserve(size_t slabs) {
+    const size_t blocks = (slabs + BLOCK_SLABS - 1) / BLOCK_SLABS;
+    const size_t have = _host->first_block[_host->super_blocks];
+    if (blocks <= have)
+      return;
+    const uint32_t i = _host->super_blocks;
+    if (i == MAX_SUPER_BLOCKS)
+      throw std::length_error("Slab heap is out of super-blocks");
+
+    const size_t added = std::max(blocks - have, have);
+    _host->nodes[i] = sycl::malloc_device<SlabNode<T>>(added * BLOCK_SLABS, _q);
+    _host->bitmaps[i] = sycl::malloc_device<uint32_t>(added, _q);
+    if (!_host->nodes[i] || !_host->bitmaps[i]) {
+      sycl::free(_host->nodes[i], _q);
+      sycl::free(_host->bitmaps[i], _q);
+      throw std::bad_alloc();
+    }
+    _q.memset(_host->bitmaps[i], 0, added * sizeof(uint32_t)).wait();
+    _host->first_block[i + 1] = have + added;
+    _host->super_blocks = i + 1;
+    _q.memcpy(_layout.get(), _host, sizeof(*_host)).wait();
+  }
+
+  size_t capacity() const {
+    return _host->first_block[_host->super_blocks] * BLOCK_SLABS;
+  }
+
+  // Reads the counters of the device, so kernels using the heap must have
+  // finished.
+  HeapUsage usage() const {
+    uint32_t counters[COUNTERS];
+    _q.memcpy(counters, _counters.get(), sizeof(counters)).wait();
+    return {capacity(), counters[USED], counters[OVERFLOWED] != 0};
+  }
+
+  void clear_overflow() {
+    _q.memset(_counters.get() + OVERFLOWED, 0, sizeof(uint32_t)).wait();
+  }
+
+  // Returns nullptr if all slabs are taken.
+  sycl::device_ptr<SlabNode<T>> malloc_node(size_t hint) const {
+    const HeapLayout<T> &layout = *_layout;
+    const size_t blocks = layout.first_block[layout.super_blocks];
+    size_t block = hint % blocks;
+    for (size_t tried = 0; tried < blocks; ++tried) {
+      uint32_t super_block = 0;
+      while (block >= layout.first_block[super_block + 1]) {
+        ++super_block;
+      }
+      const size_t offset = block - layout.first_block[super_block];
+      uint32_t &word = layout.bitmaps[super_block][offset];
+      uint32_t taken = word;
+      while (~taken) {
+        const uint32_t slab = sycl::ctz(~taken);
+        const uint32_t bit = uint32_t(1) << slab;
+        taken = atomic_ref_device<uint32_t>(word).fetch_or(bit);
+        if (!(taken & bit)) {
+          atomic_ref_device<uint32_t>(_counters[USED]).fetch_add(1);
+          return layout.nodes[super_block] + offset * BLOCK_SLABS + slab;
+        }
+      }
+      block = block + 1 == blocks ? 0 : block + 1;
+    }
+    atomic_ref_device<uint32_t>(_counters[OVERFLOWED]).store(1);
+    return nullptr;
+  }
 
-  sycl::device_ptr<SlabNode<T>> malloc_node() {
-    uint32_t ret_offset =
-        sycl::atomic<uint32_t>(sycl::global_ptr<uint32_t>(&_offset))
-            .fetch_add(1);
-    return _heap + ret_offset;
+  // Returns a slab of the heap to its block for later allocations.
+  void free_node(sycl::device_ptr<SlabNode<T>> node) const {
+    const HeapLayout<T> &layout = *_layout;
+    for (uint32_t i = 0; i < layout.super_blocks; ++i) {
+      const size_t slabs =
+          (layout.first_block[i + 1] - layout.first_block[i]) * BLOCK_SLABS;
+      if (node.get() < layout.nodes[i] ||
+          node.get() >= layout.nodes[i] + slabs)
+        continue;
+      const size_t slab = node.get() - layout.nodes[i];
+      atomic_ref_device<uint32_t>(layout.bitmaps[i][slab / BLOCK_SLABS])
+          .fetch_and(~(uint32_t(1) << slab % BLOCK_SLABS));
+      atomic_ref_device<uint32_t>(_counters[USED]).fetch_sub(1);
+      return;
+    }
   }
 
-  sycl::device_ptr<SlabNode<T>> _heap;
-  uint32_t _offset;
+  enum Counter { USED, OVERFLOWED, COUNTERS };
+
+  sycl::device_ptr<HeapLayout<T>> _layout;
+  sycl::device_ptr<uint32_t> _counters;
+  // Host copy of the layout, which reserve() uploads. It is not a member,
+  // so buffers holding a copy of the heap do not overwrite it with a stale
+  // one when they write back.
+  HeapLayout<T> *_host;
   sycl::queue &_q;
 };
 } // namespace detail
@@ -106,15 +225,17 @@ template <typename T> struct AllocAdapter {
   AllocAdapter(size_t cluster_size, size_t work_size, size_t buckets_count,
                T empty, sycl::queue &q)
       : _q(q), _heap(cluster_size, q), _buckets_count(buckets_count) {
+    // A lock bit per list.
+    const size_t lock_words = (buckets_count + UINT32_T_BIT - 1) / UINT32_T_BIT;
     sycl::device_ptr<SlabList<T>> _data_tmp =
         sycl::malloc_device<SlabList<T>>(buckets_count, q);
-    sycl::device_ptr<uint32_t> _lock_tmp = sycl::malloc_device<uint32_t>(
-        ceil((float)buckets_count / sizeof(uint32_t)), q);
+    sycl::device_ptr<uint32_t> _lock_tmp =
+        sycl::malloc_device<uint32_t>(lock_words, q);
 
+    q.memset(_lock_tmp.get(), 0, lock_words * sizeof(uint32_t)).wait();
     q.parallel_for(buckets_count, [=](auto &i) {
-      *(_data_tmp + i) = SlabList<T>();
-      *(_lock_tmp + i) = 0;
-    });
+       *(_data_tmp + i) = SlabList<T>();
+     }).wait();
 
     _data = _data_tmp;
     _lock = _lock_tmp;
@@ -125,6 +246,22 @@ template <typename T> struct AllocAdapter {
     sycl::free(_lock, _q);
   }
 
+  // Grows the heap to at least `slabs` slabs before kernels inserting more
+  // entries.
+  void reserve(size_t slabs) { _heap.reserve(slabs); }
+  HeapUsage usage() const { return _heap.usage(); }
+
+  // If a kernel found no free slab, at least doubles the heap and clears
+  // the overflow, so that the inserts that failed can run again. Returns
+  // whether it did.
+  bool grow_if_overflowed() {
+    if (!usage().overflowed)
+      return false;
+    _heap.reserve(_heap.capacity() + 1);
+    _heap.clear_overflow();
+    return true;
+  }
+
   sycl::device_ptr<SlabList<T>> _data;
   sycl::device_ptr<uint32_t> _lock;
   detail::HeapMaster<T> _heap;
@@ -132,16 +269,24 @@ template <typename T> struct AllocAdapter {
   sycl::queue &_q;
 };
 
-template <typename K, typename T, typename Hash> class SlabHashTable {
+// Probe statistics count the nodes visited by an operation, reported by the
+// first lane of the sub-group. Erased entries keep the key `empty - 1` as a
+// tombstone until an insert reuses their slot, so neither key can be
+// inserted.
+template <typename K, typename T, typename Hash, typename Stats = NoProbeStats>
+class SlabHashTable {
 public:
   SlabHashTable() = default;
   SlabHashTable(K empty, sycl::nd_item<1> &it,
-                SlabHash::AllocAdapter<std::pair<K, T>> &adap)
+                SlabHash::AllocAdapter<std::pair<K, T>> &adap,
+                Stats stats = Stats())
       : _lists(adap._data), _gr(it.get_sub_group()), _empty(empty),
-        _ind(it.get_local_id()), _lock(adap._lock), _heap(adap._heap),
-        _buckets_count(adap._buckets_count){};
+        _tombstone(empty - 1), _ind(it.get_local_id()), _lock(adap._lock),
+        _heap(adap._heap), _buckets_count(adap._buckets_count), _stats(stats),
+        _hint(it.get_group_linear_id()){};
 
-  void insert(K key, T val) {
+  // Returns false if the heap has no slab left for the entry.
+  bool insert(K key, T val) {
     _key = key;
     _val = val;
 
@@ -150,13 +295,19 @@ public:
         alloc_node((_lists + _hasher(key, _buckets_count))->root);
       }
     }
-    _iter = (_lists + _hasher(key, _buckets_count))->root;
     sycl::group_barrier(_gr);
+    _iter = (_lists + _hasher(key, _buckets_count))->root;
+    if (_iter == nullptr)
+      return false;
 
+    size_t nodes = 0;
     while (1) {
       while (_iter != nullptr) {
+        ++nodes;
         if (insert_in_node()) {
-          return;
+          if (_ind == 0)
+            _stats.insert(nodes);
+          return true;
         } else {
           _prev = _iter;
           _iter = _iter->next;
@@ -169,9 +320,89 @@ public:
       }
       sycl::group_barrier(_gr);
       _iter = _prev->next;
+      if (_iter == nullptr)
+        return false;
+
+      sycl::group_barrier(_gr);
+    }
+  }
+
+  // Sets the value of the first entry with `key`, or inserts one if there is
+  // none. Upserts of the same missing key running at the same time may both
+  // insert it.
+  bool upsert(K key, T val) {
+    _key = key;
+    _val = val;
+
+    sycl::group_barrier(_gr);
+    _iter = (_lists + _hasher(key, _buckets_count))->root;
+
+    size_t nodes = 0;
+    while (_iter != nullptr) {
+      ++nodes;
+      if (update_in_node()) {
+        if (_ind == 0)
+          _stats.insert(nodes);
+        return true;
+      }
+      _iter = _iter->next;
+
+      sycl::group_barrier(_gr);
+    }
+    return insert(key, val);
+  }
+
+  // Replaces the first entry with `key` by a tombstone. Returns whether
+  // there was one.
+  bool erase(K key) {
+    _key = key;
+
+    sycl::group_barrier(_gr);
+    _iter = (_lists + _hasher(key, _buckets_count))->root;
+
+    size_t nodes = 0;
+    bool erased = false;
+    while (_iter != nullptr && !erased) {
+      ++nodes;
+      erased = erase_in_node();
+      _iter = _iter->next;
 
       sycl::group_barrier(_gr);
     }
+    if (_ind == 0)
+      _stats.lookup(nodes);
+    return erased;
+  }
+
+  // Unlinks the slabs of list `list` that erases left without entries and
+  // returns them to the heap for later inserts. No other operation may run
+  // on the table at the same time. Returns the number of slabs freed.
+  size_t compact(size_t list) {
+    sycl::device_ptr<SlabNode<std::pair<K, T>>> *link =
+        &(_lists + list)->root;
+
+    size_t freed = 0;
+    while (*link != nullptr) {
+      sycl::device_ptr<SlabNode<std::pair<K, T>>> node = *link;
+      bool live = false;
+      for (int i = _ind; i < SUBGROUP_SIZE * SLAB_SIZE_MULTIPLIER;
+           i += SUBGROUP_SIZE) {
+        K seen = node->data[i].first;
+        live = live || (seen != _empty && seen != _tombstone);
+      }
+      if (sycl::any_of_group(_gr, live)) {
+        link = &node->next;
+        continue;
+      }
+      sycl::group_barrier(_gr);
+      if (_ind == 0) {
+        *link = node->next;
+        _heap.free_node(node);
+      }
+      sycl::group_barrier(_gr);
+      ++freed;
+    }
+    return freed;
   }
 
   std::optional<T> find(K key) {
@@ -182,7 +413,9 @@ public:
 
     sycl::group_barrier(_gr);
 
+    size_t nodes = 0;
     while (_iter != nullptr) {
+      ++nodes;
       if (find_in_node()) {
         break;
       } else {
@@ -191,17 +424,51 @@ public:
 
       sycl::group_barrier(_gr);
     }
+    if (_ind == 0)
+      _stats.lookup(nodes);
     return _ans;
   }
 
+  // Calls f(value, i) in the lane holding the i-th entry with `key` (inserted
+  // more than once for joins with duplicates) and returns the number of
+  // entries to all lanes.
+  template <class F> size_t find_all(K key, F f) {
+    size_t found = 0;
+    _iter = (_lists + _hasher(key, _buckets_count))->root;
+
+    sycl::group_barrier(_gr);
+
+    size_t nodes = 0;
+    while (_iter != nullptr) {
+      ++nodes;
+      for (int i = _ind; i < SUBGROUP_SIZE * SLAB_SIZE_MULTIPLIER;
+           i += SUBGROUP_SIZE) {
+        size_t match = (_iter->data[i].first) == key;
+        size_t before =
+            sycl::exclusive_scan_over_group(_gr, match, sycl::plus<size_t>());
+        if (match)
+          f(_iter->data[i].second, found + before);
+        found += sycl::reduce_over_group(_gr, match, sycl::plus<size_t>());
+      }
+      _iter = _iter->next;
+
+      sycl::group_barrier(_gr);
+    }
+    if (_ind == 0)
+      _stats.lookup(nodes);
+    return found;
+  }
+
 private:
   void alloc_node(sycl::device_ptr<SlabNode<std::pair<K, T>>> &src) {
     lock();
     if (src == nullptr) {
-      auto allocated_pointer = _heap.malloc_node();
-      *allocated_pointer = SlabNode<std::pair<K, T>>({_empty, T()}); //!!!!!!
-
-      src = allocated_pointer;
+      auto allocated_pointer = _heap.malloc_node(_hint);
+      if (allocated_pointer != nullptr) {
+        *allocated_pointer = SlabNode<std::pair<K, T>>({_empty, T()});
+        src = allocated_pointer;
+        _stats.node_allocated();
+      }
     }
     unlock();
   }
@@ -221,18 +488,20 @@ private:
         .fetch_and(~(1 << (list_index % (UINT32_T_BIT))));
   }
 
+  // Takes an empty slot or the slot of an erased entry.
   bool insert_in_node() {
     bool total_found = false;
     bool find = false;
 
     for (int i = _ind; i < SUBGROUP_SIZE * SLAB_SIZE_MULTIPLIER;
          i += SUBGROUP_SIZE) {
-      find = ((_iter->data[i].first) == _empty);
+      K seen = _iter->data[i].first;
+      find = seen == _empty || seen == _tombstone;
       sycl::group_barrier(_gr);
       total_found = sycl::any_of_group(_gr, find);
 
       if (total_found) {
-        if (insert_in_subgroup(find, i)) {
+        if (insert_in_subgroup(find, i, seen)) {
           return true;
         }
       }
@@ -241,10 +510,10 @@ private:
     return false;
   }
 
-  bool insert_in_subgroup(bool find, int i) {
+  bool insert_in_subgroup(bool find, int i, K seen) {
     for (int j = 0; j < SUBGROUP_SIZE; j++) {
       if (cl::sycl::group_broadcast(_gr, find, j)) {
-        K tmp_empty = _empty;
+        K tmp_empty = seen;
         bool done = _ind == j ? atomic_ref_device<K>(_iter->data[i].first)
                                     .compare_exchange_strong(tmp_empty, _key)
                               : false;
@@ -261,6 +530,50 @@ private:
     return false;
   }
 
+  bool update_in_node() {
+    for (int i = _ind; i < SUBGROUP_SIZE * SLAB_SIZE_MULTIPLIER;
+         i += SUBGROUP_SIZE) {
+      bool match = (_iter->data[i].first) == _key;
+      sycl::group_barrier(_gr);
+      if (sycl::any_of_group(_gr, match)) {
+        for (int j = 0; j < SUBGROUP_SIZE; j++) {
+          if (cl::sycl::group_broadcast(_gr, match, j)) {
+            if (_ind == j)
+              _iter->data[i].second = _val;
+            return true;
+          }
+        }
+      }
+    }
+
+    return false;
+  }
+
+  bool erase_in_node() {
+    for (int i = _ind; i < SUBGROUP_SIZE * SLAB_SIZE_MULTIPLIER;
+         i += SUBGROUP_SIZE) {
+      bool match = (_iter->data[i].first) == _key;
+      sycl::group_barrier(_gr);
+      if (!sycl::any_of_group(_gr, match))
+        continue;
+      // Another erase may take a matching entry first, then the next lane
+      // with a match tries.
+      for (int j = 0; j < SUBGROUP_SIZE; j++) {
+        if (cl::sycl::group_broadcast(_gr, match, j)) {
+          K expected = _key;
+          bool done = _ind == j ? atomic_ref_device<K>(_iter->data[i].first)
+                                      .compare_exchange_strong(expected,
+                                                               _tombstone)
+                                : false;
+          if (cl::sycl::group_broadcast(_gr, done, j))
+            return true;
+        }
+      }
+    }
+
+    return false;
+  }
+
   bool find_in_node() {
     bool find = false;
     bool total_found = false;
@@ -304,7 +617,11 @@ private:
   size_t _buckets_count;
 
   K _empty;
+  K _tombstone;
   Hash _hasher;
+  Stats _stats;
+  // Picks the block of the heap this sub-group allocates from first.
+  size_t _hint;
 
   K _key;
   T _val;
@@ -1,7 +1,9 @@
 #pragma once
 #include "meter.hpp"
 #include "options.hpp"
+#include "perf_counters.hpp"
 #include "result.hpp"
+#include "trace.hpp"
 
 class Dwarf {
 public:
@@ -16,14 +18,22 @@ public:
   void report(const RunOptions &opts) {
     if (opts.report_path.empty()) {
       for (const auto &res : results_) {
-        std::cout << *res.result;
+        std::cout << res.result();
+        std::cout << "Host time stats (us): " << res.host_stats << "\n";
+        if (res.peak_bandwidth > 0) {
+          std::cout << "Peak bandwidth:  " << res.peak_bandwidth_pct()
+                    << " %\n";
+        }
       }
+    } else if (opts.report_json()) {
+      results_.write_json(opts.report_path);
     } else {
       results_.write_csv(opts.report_path);
     }
   }
 
   Meter &meter() { return meter_; }
+  const MeasureResults &results() const { return results_; }
 
 private:
   std::string name_;
@@ -0,0 +1,75 @@
+#include "environment.hpp"
+#include "json.hpp"
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+#if __has_include("git_sha.hpp")
+#include "git_sha.hpp"
+#endif
+#ifndef DWARF_BENCH_GIT_SHA
+#define DWARF_BENCH_GIT_SHA "unknown"
+#endif
+
+namespace {
+std::string cpu_model() {
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.rfind("model name", 0) == 0) {
+      auto pos = line.find(':');
+      if (pos != std::string::npos && pos + 2 <= line.size())
+        return line.substr(pos + 2);
+    }
+  }
+  return "unknown";
+}
+
+std::string hostname() {
+  char buf[256] = {};
+  if (gethostname(buf, sizeof(buf) - 1) != 0)
+    return "unknown";
+  return buf;
+}
+} // namespace
+
+Environment host_environment() {
+  Environment env;
+  env.git_sha = DWARF_BENCH_GIT_SHA;
+#ifdef __VERSION__
+  env.compiler = __VERSION__;
+#endif
+  env.cpu_model = cpu_model();
+  env.hostname = hostname();
+  env.hardware_threads = std::thread::hardware_concurrency();
+  return env;
+}
+
+DeviceInfo host_device_info() {
+  DeviceInfo info;
+  info.name = cpu_model();
+  info.compute_units = std::thread::hardware_concurrency();
+  return info;
+}
+
+void write_json(JsonWriter &json, const DeviceInfo &device) {
+  json.begin_object()
+      .field("name", device.name)
+      .field("vendor", device.vendor)
+      .field("driver_version", device.driver_version)
+      .field("compute_units", device.compute_units)
+      .field("max_work_group_size", device.max_work_group_size)
+      .field("global_mem_bytes", device.global_mem_bytes)
+      .field("compiler", device.compiler)
+      .end_object();
+}
+
+void write_json(JsonWriter &json, const Environment &env) {
+  json.begin_object()
+      .field("git_sha", env.git_sha)
+      .field("compiler", env.compiler)
+      .field("cpu_model", env.cpu_model)
+      .field("hostname", env.hostname)
+      .field("hardware_threads", env.hardware_threads)
+      .end_object();
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+
+class JsonWriter;
+
+// Device a dwarf ran on, filled in by the device-specific code.
+struct DeviceInfo {
+  std::string name;
+  std::string vendor;
+  std::string driver_version;
+  size_t compute_units = 0;
+  size_t max_work_group_size = 0;
+  size_t global_mem_bytes = 0;
+  // Compiler used for device code, if it differs from the host one.
+  std::string compiler;
+};
+
+// Build and host machine description, the same for every dwarf in a run.
+struct Environment {
+  std::string git_sha;
+  std::string compiler;
+  std::string cpu_model;
+  std::string hostname;
+  size_t hardware_threads = 0;
+};
+
+Environment host_environment();
+// Describes the host CPU for dwarfs that run on it directly (e.g. TBB).
+DeviceInfo host_device_info();
+
+void write_json(JsonWriter &json, const DeviceInfo &device);
+void write_json(JsonWriter &json, const Environment &env);
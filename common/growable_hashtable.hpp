@@ -0,0 +1,167 @@
+#pragma once
+#include <oneapi/tbb/blocked_range.h>
+#include <oneapi/tbb/parallel_for.h>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// GrowableHashTable of common/dpcpp on the host: linear probing over a
+// power-of-two table of atomics, filled and rehashed with TBB. Rows whose key
+// would push the used slots past `max_load_factor` are collected, the table
+// doubles and they are inserted again. At least one slot stays empty, so
+// tables have two or more. `Hash` gives 64-bit hashes, whose upper bits
+// index the table.
+template <class Key, class T, class Hash> class HostGrowableHashTable {
+public:
+  static constexpr size_t MAX_CAPACITY = size_t(1) << 31;
+
+  HostGrowableHashTable(size_t capacity, double max_load_factor,
+                        Hash hash = Hash(),
+                        Key empty_key = std::numeric_limits<Key>::max())
+      : _hash(hash), _empty_key(empty_key),
+        _max_load_factor(max_load_factor) {
+    if (!(max_load_factor > 0 && max_load_factor < 1))
+      throw std::invalid_argument("Load factor must be in (0, 1)");
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    allocate(size);
+  }
+
+  size_t capacity() const { return _mask + 1; }
+  size_t rehashes() const { return _rehashes; }
+  size_t bytes() const { return capacity() * (sizeof(Key) + sizeof(T)); }
+  size_t size() const { return _used; }
+
+  // Sets the value of every key, last writer wins for duplicates.
+  void insert(const Key *keys, const T *vals, size_t rows) {
+    apply<false>(keys, vals, rows);
+  }
+  // Adds the values to those of the keys, which start at 0.
+  void add(const Key *keys, const T *vals, size_t rows) {
+    apply<true>(keys, vals, rows);
+  }
+
+  std::pair<T, bool> at(const Key &key) const {
+    for (size_t pos = slot(key);; pos = (pos + 1) & _mask) {
+      const Key k = _keys[pos].load(std::memory_order_acquire);
+      if (k == key)
+        return {_vals[pos].load(std::memory_order_relaxed), true};
+      if (k == _empty_key)
+        return {{}, false};
+    }
+  }
+
+  bool has(const Key &key) const { return at(key).second; }
+
+private:
+  Hash _hash;
+  Key _empty_key;
+  double _max_load_factor;
+  std::unique_ptr<std::atomic<Key>[]> _keys;
+  std::unique_ptr<std::atomic<T>[]> _vals;
+  size_t _mask = 0;
+  unsigned _shift = 64;
+  size_t _limit = 0;
+  std::atomic<size_t> _used{0};
+  size_t _rehashes = 0;
+
+  size_t slot(const Key &key) const {
+    // Tables have two slots or more, so the shift is below 64.
+    return uint64_t(_hash(key)) >> _shift;
+  }
+
+  void allocate(size_t capacity) {
+    _keys.reset(new std::atomic<Key>[capacity]);
+    _vals.reset(new std::atomic<T>[capacity]);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, capacity),
+                      [&](const tbb::blocked_range<size_t> &r) {
+                        for (size_t i = r.begin(); i != r.end(); ++i) {
+                          _keys[i].store(_empty_key, std::memory_order_relaxed);
+                          _vals[i].store(T(0), std::memory_order_relaxed);
+                        }
+                      });
+    _mask = capacity - 1;
+    _shift = 64;
+    while ((size_t(1) << (64 - _shift)) < capacity) {
+      --_shift;
+    }
+    // Probing ends at an empty slot.
+    _limit = std::min(capacity - 1,
+                      std::max<size_t>(1, capacity * _max_load_factor));
+    _used = 0;
+  }
+
+  template <bool Add> bool update(Key key, T val) {
+    for (size_t pos = slot(key);; pos = (pos + 1) & _mask) {
+      Key k = _keys[pos].load(std::memory_order_acquire);
+      if (k == _empty_key) {
+        if (_used.fetch_add(1) >= _limit) {
+          _used.fetch_sub(1);
+          return false;
+        }
+        if (_keys[pos].compare_exchange_strong(k, key)) {
+          k = key;
+        } else {
+          _used.fetch_sub(1);
+        }
+      }
+      if (k == key) {
+        if (Add)
+          _vals[pos].fetch_add(val, std::memory_order_relaxed);
+        else
+          _vals[pos].store(val, std::memory_order_relaxed);
+        return true;
+      }
+    }
+  }
+
+  template <bool Add> void apply(const Key *keys, const T *vals, size_t rows) {
+    std::vector<size_t> pending[2];
+    const size_t *in = nullptr;
+    size_t count = rows;
+    for (int pass = 0; count > 0; ++pass) {
+      std::vector<size_t> &out = pending[pass % 2];
+      out.resize(count);
+      std::atomic<size_t> failed{0};
+      tbb::parallel_for(tbb::blocked_range<size_t>(0, count),
+                        [&](const tbb::blocked_range<size_t> &r) {
+                          for (size_t i = r.begin(); i != r.end(); ++i) {
+                            const size_t row = in ? in[i] : i;
+                            if (!update<Add>(keys[row], vals[row]))
+                              out[failed++] = row;
+                          }
+                        });
+      count = failed;
+      in = out.data();
+      if (count > 0)
+        grow();
+    }
+  }
+
+  void grow() {
+    const size_t capacity = 2 * this->capacity();
+    if (capacity > MAX_CAPACITY)
+      throw std::length_error("Growable hash table is full");
+    std::unique_ptr<std::atomic<Key>[]> keys = std::move(_keys);
+    std::unique_ptr<std::atomic<T>[]> vals = std::move(_vals);
+    const size_t old_capacity = this->capacity();
+    allocate(capacity);
+
+    // Keys are distinct, so every one is stored as is at its new slot.
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, old_capacity),
+                      [&](const tbb::blocked_range<size_t> &r) {
+                        for (size_t i = r.begin(); i != r.end(); ++i) {
+                          const Key k = keys[i].load(std::memory_order_relaxed);
+                          if (k != _empty_key)
+                            update<false>(k, vals[i].load());
+                        }
+                      });
+    ++_rehashes;
+  }
+};
@@ -0,0 +1,31 @@
+#include "hashers.hpp"
+#include <map>
+
+namespace {
+const std::map<std::string, HasherKind> hashers = {
+    {"default", HasherKind::Default},
+    {"multiply_shift", HasherKind::MultiplyShift},
+    {"fibonacci", HasherKind::Fibonacci},
+    {"crc32", HasherKind::Crc32},
+    {"xxhash", HasherKind::XxHash},
+    {"wyhash", HasherKind::WyHash}};
+} // namespace
+
+std::istream &operator>>(std::istream &in, HasherKind &h) {
+  std::string name;
+  in >> name;
+  auto it = hashers.find(name);
+  if (it == hashers.end())
+    in.setstate(std::ios::failbit);
+  else
+    h = it->second;
+  return in;
+}
+
+std::string to_string(HasherKind h) {
+  for (const auto &entry : hashers) {
+    if (entry.second == h)
+      return entry.first;
+  }
+  return "unknown";
+}
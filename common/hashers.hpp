@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <string>
+
+// Hash functions of the hash tables, parsed from --hasher. The default is
+// the dwarf's own modulo-based hasher, the others are multiplicative or
+// mixing hashers of power-of-two tables:
+//   default         the dwarf's hasher, e.g. key % size
+//   multiply_shift  (a * key) >> (64 - log2(size)) with a random odd a
+//   fibonacci       multiply-shift with a = 2^64 / golden ratio
+//   crc32           CRC-32C of the key, spread by a multiply
+//   xxhash          the xxHash64 avalanche finalizer
+//   wyhash          the wyhash 64x64 -> 128-bit multiply-fold mix
+enum class HasherKind {
+  Default,
+  MultiplyShift,
+  Fibonacci,
+  Crc32,
+  XxHash,
+  WyHash
+};
+
+std::istream &operator>>(std::istream &in, HasherKind &h);
+std::string to_string(HasherKind h);
+
+// 64-bit hashes of keys for power-of-two tables, which take the upper bits.
+// The ones needing SYCL are in common/dpcpp/hashfunctions.hpp.
+namespace Hashes {
+struct Fibonacci {
+  template <class Key> uint64_t operator()(const Key &v) const {
+    return uint64_t(v) * 0x9e3779b97f4a7c15ull;
+  }
+};
+} // namespace Hashes
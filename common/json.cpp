@@ -0,0 +1,114 @@
+#include "json.hpp"
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
+void JsonWriter::separate() {
+  if (after_key_) {
+    after_key_ = false;
+    return;
+  }
+  if (!first_.empty()) {
+    if (!first_.back())
+      os_ << ",";
+    first_.back() = false;
+  }
+}
+
+void JsonWriter::write_string(const std::string &s) {
+  os_ << '"';
+  for (char c : s) {
+    switch (c) {
+    case '"':
+      os_ << "\\\"";
+      break;
+    case '\\':
+      os_ << "\\\\";
+      break;
+    case '\n':
+      os_ << "\\n";
+      break;
+    case '\r':
+      os_ << "\\r";
+      break;
+    case '\t':
+      os_ << "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        os_ << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+            << static_cast<int>(c) << std::dec << std::setfill(' ');
+      } else {
+        os_ << c;
+      }
+    }
+  }
+  os_ << '"';
+}
+
+JsonWriter &JsonWriter::begin_object() {
+  separate();
+  os_ << "{";
+  first_.push_back(true);
+  return *this;
+}
+
+JsonWriter &JsonWriter::end_object() {
+  first_.pop_back();
+  os_ << "}";
+  return *this;
+}
+
+JsonWriter &JsonWriter::begin_array() {
+  separate();
+  os_ << "[";
+  first_.push_back(true);
+  return *this;
+}
+
+JsonWriter &JsonWriter::end_array() {
+  first_.pop_back();
+  os_ << "]";
+  return *this;
+}
+
+JsonWriter &JsonWriter::key(const std::string &name) {
+  separate();
+  write_string(name);
+  os_ << ":";
+  after_key_ = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(const std::string &v) {
+  separate();
+  write_string(v);
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(const char *v) { return value(std::string(v)); }
+
+JsonWriter &JsonWriter::value(double v) {
+  separate();
+  // JSON has no representation for nan and inf.
+  if (std::isfinite(v)) {
+    auto precision = os_.precision(std::numeric_limits<double>::digits10);
+    os_ << v;
+    os_.precision(precision);
+  } else {
+    os_ << "null";
+  }
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(size_t v) {
+  separate();
+  os_ << v;
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(bool v) {
+  separate();
+  os_ << (v ? "true" : "false");
+  return *this;
+}
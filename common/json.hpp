@@ -0,0 +1,36 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Minimal streaming JSON writer, enough for machine-readable reports.
+// Commas are inserted automatically, keys are only expected inside objects.
+class JsonWriter {
+public:
+  explicit JsonWriter(std::ostream &os) : os_(os) {}
+
+  JsonWriter &begin_object();
+  JsonWriter &end_object();
+  JsonWriter &begin_array();
+  JsonWriter &end_array();
+  JsonWriter &key(const std::string &name);
+
+  JsonWriter &value(const std::string &v);
+  JsonWriter &value(const char *v);
+  JsonWriter &value(double v);
+  JsonWriter &value(size_t v);
+  JsonWriter &value(bool v);
+
+  template <class T> JsonWriter &field(const std::string &name, const T &v) {
+    return key(name).value(v);
+  }
+
+private:
+  void separate();
+  void write_string(const std::string &s);
+
+  std::ostream &os_;
+  // One entry per open object/array, true until its first element.
+  std::vector<bool> first_;
+  bool after_key_ = false;
+};
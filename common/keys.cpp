@@ -0,0 +1,26 @@
+#include "keys.hpp"
+
+std::istream &operator>>(std::istream &in, KeyWidth &w) {
+  std::string width;
+  in >> width;
+  if (width == "32")
+    w = KeyWidth::Bits32;
+  else if (width == "64")
+    w = KeyWidth::Bits64;
+  else if (width == "2x32")
+    w = KeyWidth::Composite;
+  else
+    in.setstate(std::ios::failbit);
+  return in;
+}
+
+std::string to_string(KeyWidth w) {
+  switch (w) {
+  case KeyWidth::Bits64:
+    return "64";
+  case KeyWidth::Composite:
+    return "2x32";
+  default:
+    return "32";
+  }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+
+// Keys of join and group by dwarfs, parsed from --key_width:
+//   32    32-bit keys
+//   64    64-bit keys with both halves in use
+//   2x32  composite keys of two 32-bit columns, packed into 64 bits
+enum class KeyWidth { Bits32, Bits64, Composite };
+
+std::istream &operator>>(std::istream &in, KeyWidth &w);
+std::string to_string(KeyWidth w);
+
+// Composite keys keep the first column in the upper half, so both columns
+// take part in hashing and in a single 64-bit compare-and-swap. Wider tuples
+// would need 128-bit atomics, which devices do not have.
+inline uint64_t pack_key(uint32_t first, uint32_t second) {
+  return (uint64_t(first) << 32) | second;
+}
+inline size_t key_bytes(KeyWidth w) {
+  return w == KeyWidth::Bits32 ? sizeof(uint32_t) : sizeof(uint64_t);
+}
+inline uint32_t key_first(uint64_t key) { return key >> 32; }
+inline uint32_t key_second(uint64_t key) { return key & 0xffffffffu; }
+
+// Key of a dense id (e.g. a group or a row of unique keys) and back: 32-bit
+// keys are the id, 64-bit keys get a scrambled upper half so that hashers
+// have to use all bits, and composite keys have the id as the first column
+// and the scrambled id as the second, so that both of the 32-bit columns
+// vary over their whole range, like a (store, product) pair.
+inline uint64_t id_key(KeyWidth w, uint32_t id) {
+  switch (w) {
+  case KeyWidth::Bits64:
+    return pack_key((id * 0x9e3779b1u) >> 1, id);
+  case KeyWidth::Composite:
+    return pack_key(id, id * 0x9e3779b1u);
+  default:
+    return id;
+  }
+}
+inline uint32_t key_id(KeyWidth w, uint64_t key) {
+  switch (w) {
+  case KeyWidth::Composite:
+    return key_first(key);
+  default:
+    return key_second(key);
+  }
+}
@@ -1,4 +1,11 @@
 #include "meter.hpp"
+#include "dataset.hpp"
+#include "trace.hpp"
+#include <algorithm>
+
+// Samples taken before the confidence interval is tested, since that of a
+// single sample is 0 and that of two too wide to mean anything.
+constexpr size_t MIN_CI_SAMPLES = 3;
 
 DwarfParams concat(const DwarfParams &stable, DwarfParams &&incoming) {
   DwarfParams out = stable;
@@ -10,7 +17,65 @@ void Meter::add_result(DwarfParams &&params, std::unique_ptr<Result> result) {
   result_.add_result(concat(params_, std::move(params)), std::move(result));
 }
 
+void Meter::measure(DwarfParams &&params, const Iteration &iteration) {
+  const RunOptions &opts = *opts_;
+  TraceSpan point(opts.tracer, dwarf_name_, "dwarf");
+  // Iterations are traced as a whole, with the device commands they record.
+  auto traced = [&](const char *category) {
+    std::unique_ptr<Result> result;
+    {
+      TraceSpan span(opts.tracer, dwarf_name_, category);
+      result = iteration();
+    }
+    if (opts.tracer)
+      opts.tracer->device_commands(result->commands);
+    return result;
+  };
+
+  for (size_t it = 0; it < opts.warmup; ++it) {
+    traced("warmup");
+  }
+
+  const size_t min_iterations = std::max<size_t>(opts.iterations, 1);
+  const size_t max_iterations =
+      opts.target_ci > 0 ? std::max(opts.max_iterations, min_iterations)
+                         : min_iterations;
+
+  std::vector<std::unique_ptr<Result>> samples;
+  std::vector<double> host_times;
+  while (samples.size() < max_iterations) {
+    samples.push_back(traced("iteration"));
+    host_times.push_back(samples.back()->host_time.count());
+
+    if (samples.size() >= std::max(min_iterations, MIN_CI_SAMPLES) &&
+        opts.target_ci > 0) {
+      Stats s = stats::summarize(host_times, opts.outlier_threshold);
+      if (s.relative_ci() <= opts.target_ci)
+        break;
+    }
+  }
+
+  if (opts.dataset)
+    params["dataset"] = opts.dataset->path();
+  else
+    params["seed"] = std::to_string(opts.seed);
+  result_.add_result(concat(params_, std::move(params)), std::move(samples),
+                     opts.outlier_threshold);
+}
+
 void Meter::set_params(DwarfParams params) { params_ = params; }
 
-void Meter::set_opts(const RunOptions &opts) { opts_ = &opts; }
+void Meter::set_opts(const RunOptions &opts) {
+  opts_ = &opts;
+  // A dwarf may be re-initialized for another device, so the peak of the
+  // previous one is not carried over.
+  set_peak_bandwidth(opts.peak_bandwidth);
+}
 const RunOptions &Meter::opts() const { return *opts_; }
+
+void Meter::set_peak_bandwidth(double gbs) { result_.set_peak_bandwidth(gbs); }
+bool Meter::has_peak_bandwidth() const { return result_.peak_bandwidth() > 0; }
+
+void Meter::set_device_info(DeviceInfo device) {
+  result_.set_device_info(std::move(device));
+}
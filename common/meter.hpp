@@ -1,19 +1,30 @@
 #pragma once
+#include <functional>
+
 #include "options.hpp"
 #include "result.hpp"
 
 class Meter {
 public:
+  using Iteration = std::function<std::unique_ptr<Result>()>;
+
   Meter(const std::string &dwarf_name, MeasureResults &result)
       : dwarf_name_(dwarf_name), result_(result) {}
   void add_result(DwarfParams &&params, std::unique_ptr<Result> result);
+  // Runs warmup iterations, then measured ones until the iteration count and
+  // the confidence interval target from the options are met, and records
+  // the aggregated result for the parameter point.
+  void measure(DwarfParams &&params, const Iteration &iteration);
   void set_params(DwarfParams params);
   void set_opts(const RunOptions &opts);
   const RunOptions &opts() const;
+  void set_peak_bandwidth(double gbs);
+  bool has_peak_bandwidth() const;
+  void set_device_info(DeviceInfo device);
 
 private:
   const std::string dwarf_name_;
   MeasureResults &result_;
   DwarfParams params_;
   RunOptions const *opts_;
-};
\ No newline at end of file
+};
@@ -0,0 +1,26 @@
+#include "op_mix.hpp"
+#include <sstream>
+
+std::istream &operator>>(std::istream &in, OpMix &m) {
+  std::string spec;
+  in >> spec;
+  std::istringstream weights(spec);
+  OpMix parsed;
+  char colon1 = 0, colon2 = 0;
+  if (!(weights >> parsed.insert >> colon1 >> parsed.find >> colon2 >>
+        parsed.erase) ||
+      !weights.eof() || colon1 != ':' || colon2 != ':' || parsed.insert < 0 ||
+      parsed.find < 0 || parsed.erase < 0 ||
+      parsed.insert + parsed.find + parsed.erase <= 0) {
+    in.setstate(std::ios::failbit);
+    return in;
+  }
+  m = parsed;
+  return in;
+}
+
+std::string to_string(const OpMix &m) {
+  std::ostringstream os;
+  os << m.insert << ":" << m.find << ":" << m.erase;
+  return os.str();
+}
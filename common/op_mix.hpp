@@ -0,0 +1,16 @@
+#pragma once
+#include <istream>
+#include <string>
+
+// Shares of the operations of mixed workloads, parsed from
+// "<inserts>:<finds>:<erases>" weights such as "20:70:10". Inserts of a key
+// already present update its value.
+struct OpMix {
+  enum Op { Insert, Find, Erase };
+  double insert = 20;
+  double find = 70;
+  double erase = 10;
+};
+
+std::istream &operator>>(std::istream &in, OpMix &m);
+std::string to_string(const OpMix &m);
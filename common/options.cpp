@@ -17,6 +17,15 @@ std::istream &operator>>(std::istream &in, RunOptions::DeviceType &dt) {
   return in;
 }
 
+bool RunOptions::report_json() const {
+  auto ends_with = [&](const std::string &suffix) {
+    return report_path.size() >= suffix.size() &&
+           report_path.compare(report_path.size() - suffix.size(),
+                               suffix.size(), suffix) == 0;
+  };
+  return ends_with(".json") || ends_with(".jsonl");
+}
+
 std::string to_string(const RunOptions::DeviceType &dt) {
   switch (dt) {
   case RunOptions::DeviceType::CPU:
@@ -30,4 +39,35 @@ std::string to_string(const RunOptions::DeviceType &dt) {
   default:
     throw std::logic_error("Unsupported device type!");
   }
-}
\ No newline at end of file
+}
+
+std::istream &operator>>(std::istream &in, RunOptions::Verification &v) {
+  std::string mode;
+  in >> mode;
+  std::transform(mode.begin(), mode.end(), mode.begin(),
+                 [](char c) { return std::tolower(c); });
+  if (mode == "none")
+    v = RunOptions::Verification::None;
+  else if (mode == "sample")
+    v = RunOptions::Verification::Sample;
+  else if (mode == "full")
+    v = RunOptions::Verification::Full;
+  else
+    in.setstate(std::ios::failbit);
+
+  return in;
+}
+
+std::string to_string(const RunOptions::Verification &v) {
+  switch (v) {
+  case RunOptions::Verification::None:
+    return "none";
+  case RunOptions::Verification::Sample:
+    return "sample";
+  case RunOptions::Verification::Full:
+    return "full";
+
+  default:
+    throw std::logic_error("Unsupported verification mode!");
+  }
+}
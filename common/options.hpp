@@ -1,15 +1,81 @@
 #pragma once
+#include "distribution.hpp"
+#include "hashers.hpp"
+#include "keys.hpp"
+#include "op_mix.hpp"
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <vector>
 
+class Dataset;
+class QueueManager;
+class Tracer;
+
 struct RunOptions {
   enum DeviceType { CPU, GPU, iGPU, Default };
   DeviceType device_ty = DeviceType::Default;
+  // Result check of join dwarfs: none, the rows of a sample of probe keys,
+  // or all rows against a reference join.
+  enum Verification { None, Sample, Full };
+  Verification verify = Verification::Full;
   std::vector<size_t> input_size;
   size_t iterations = 1;
+  // Iterations run before measuring, their results are discarded.
+  size_t warmup = 0;
+  // Adaptive repetition: keep iterating (up to max_iterations) until the
+  // relative 95% confidence interval of host time is below target_ci.
+  double target_ci = 0;
+  size_t max_iterations = 100;
+  // In scaled median absolute deviations, 0 disables outlier rejection.
+  double outlier_threshold = 3;
   std::string root_path;
+  // A .json or .jsonl extension selects the JSON lines report, CSV otherwise.
   std::string report_path;
+  // Peak memory bandwidth in GB/s used as 100% in reports, 0 if unknown.
+  double peak_bandwidth = 0;
+  bool measure_peak_bandwidth = false;
+  // Distribution of generated keys for dwarfs that support it.
+  Distribution distribution;
+  // Generated join inputs: probe rows per build row (input_size is the build
+  // side), share of probe rows with a match, and rows per distinct key on
+  // each side for 1:N and N:M joins.
+  double probe_ratio = 1;
+  double match_rate = 0.1;
+  size_t build_duplicates = 1;
+  size_t probe_duplicates = 1;
+  // Radix partitioning of the partitioned joins: partitions per pass, a power
+  // of two or 0 to size the partitions for the cache, and number of passes.
+  size_t partition_fanout = 0;
+  size_t partition_passes = 1;
+  // Keys of join and group by dwarfs.
+  KeyWidth key_width = KeyWidth::Bits32;
+  // Hash function of HashBuild, Join and GroupBy tables.
+  HasherKind hasher = HasherKind::Default;
+  // Entries per slot of hash tables, each a separate point of every input
+  // size. Empty for the default of each dwarf.
+  std::vector<double> load_factor;
+  // Operations of SlabMixedOps, each mix a separate point of every input
+  // size. Empty for the default mix.
+  std::vector<OpMix> op_mix;
+  // Seed of all generated inputs, the same seed reproduces the same data.
+  uint64_t seed = 0;
+  // Collect hardware counters of the measured regions of CPU runs.
+  bool perf_counters = false;
+  // Instrument the hash tables of HashBuild, Join, GroupBy, CuckooHashBuild
+  // and SlabHashBuild with probe length histograms and contention counters.
+  bool probe_stats = false;
+
+  // Process-wide SYCL contexts and queues, shared by all dwarf runs. Null
+  // when the dwarfs should create their own (e.g. without DPC++).
+  std::shared_ptr<QueueManager> queues;
+  // Input columns mapped from --dataset, null to generate synthetic data.
+  std::shared_ptr<Dataset> dataset;
+  // Timeline of the run for --trace, null when tracing is off.
+  std::shared_ptr<Tracer> tracer;
+
+  bool report_json() const;
 };
 
 struct GroupByRunOptions : public RunOptions {
@@ -22,4 +88,8 @@ struct GroupByRunOptions : public RunOptions {
 
 std::istream &operator>>(std::istream &in, RunOptions::DeviceType &dt);
 
-std::string to_string(const RunOptions::DeviceType &dt);
\ No newline at end of file
+std::string to_string(const RunOptions::DeviceType &dt);
+
+std::istream &operator>>(std::istream &in, RunOptions::Verification &v);
+
+std::string to_string(const RunOptions::Verification &v);
\ No newline at end of file
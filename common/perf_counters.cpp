@@ -0,0 +1,142 @@
+#include "perf_counters.hpp"
+#include <iostream>
+
+#ifdef __linux__
+#include <cstring>
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+constexpr size_t counters_count = 5;
+
+uint64_t cache_event(uint64_t cache) {
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+// In the order of CounterValues fields.
+const std::pair<uint32_t, uint64_t> events[counters_count] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_LL)},
+    {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_DTLB)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}};
+
+int open_event(pid_t tid, int group_fd, uint32_t type, uint64_t config) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = group_fd == -1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return syscall(__NR_perf_event_open, &attr, tid, -1, group_fd, 0);
+}
+
+std::vector<pid_t> process_threads() {
+  std::vector<pid_t> tids;
+  if (DIR *dir = opendir("/proc/self/task")) {
+    while (dirent *entry = readdir(dir)) {
+      if (entry->d_name[0] != '.')
+        tids.push_back(std::stoi(entry->d_name));
+    }
+    closedir(dir);
+  }
+  return tids;
+}
+} // namespace
+
+PerfCounters::PerfCounters(bool enabled) {
+  if (!enabled)
+    return;
+  for (pid_t tid : process_threads()) {
+    std::vector<int> group;
+    for (const auto &e : events) {
+      int fd = open_event(tid, group.empty() ? -1 : group.front(), e.first,
+                          e.second);
+      if (fd < 0)
+        break;
+      group.push_back(fd);
+    }
+    if (group.size() == counters_count) {
+      groups_.push_back(std::move(group));
+    } else {
+      // The thread may have exited, or the counters are not available.
+      for (int fd : group) {
+        close(fd);
+      }
+    }
+  }
+
+  static bool warned = false;
+  if (groups_.empty() && !warned) {
+    std::cerr << "Could not open hardware counters, check "
+                 "/proc/sys/kernel/perf_event_paranoid"
+              << std::endl;
+    warned = true;
+  }
+}
+
+PerfCounters::~PerfCounters() {
+  for (const auto &group : groups_) {
+    for (int fd : group) {
+      close(fd);
+    }
+  }
+}
+
+void PerfCounters::start() {
+  for (const auto &group : groups_) {
+    ioctl(group.front(), PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group.front(), PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+}
+
+void PerfCounters::stop() {
+  for (const auto &group : groups_) {
+    ioctl(group.front(), PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  }
+}
+
+void PerfCounters::fill(Result &result) const {
+  if (groups_.empty())
+    return;
+  uint64_t totals[counters_count] = {};
+  for (const auto &group : groups_) {
+    // nr, time_enabled, time_running, then one value per counter.
+    uint64_t data[3 + counters_count];
+    if (read(group.front(), data, sizeof(data)) != sizeof(data))
+      continue;
+    // Scale up when the group was multiplexed with other users.
+    const double scale =
+        data[2] && data[2] < data[1] ? static_cast<double>(data[1]) / data[2]
+                                     : 1;
+    for (size_t i = 0; i < counters_count; ++i) {
+      totals[i] += static_cast<uint64_t>(data[3 + i] * scale);
+    }
+  }
+
+  CounterValues &c = result.counters;
+  c.collected = true;
+  c.cycles = totals[0];
+  c.instructions = totals[1];
+  c.llc_misses = totals[2];
+  c.dtlb_misses = totals[3];
+  c.branch_misses = totals[4];
+}
+#else
+PerfCounters::PerfCounters(bool enabled) {
+  if (enabled)
+    std::cerr << "Hardware counters are only supported on Linux" << std::endl;
+}
+PerfCounters::~PerfCounters() = default;
+void PerfCounters::start() {}
+void PerfCounters::stop() {}
+void PerfCounters::fill(Result &) const {}
+#endif
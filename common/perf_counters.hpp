@@ -0,0 +1,30 @@
+#pragma once
+#include "result.hpp"
+#include <vector>
+
+// Hardware counters of a measured region via Linux perf_event_open, counting
+// user space only. They are opened on every thread the process has when
+// constructed (TBB and SYCL CPU workers included), so dwarfs create one per
+// iteration before its timer starts. Threads spawned later are not counted:
+// pass --warmup so that worker pools are started before the first measured
+// iteration, which otherwise misses the workers it starts. Counters are
+// per-thread rather than inherited, since the kernel only adds the counts of
+// inherited ones to their parent when the child thread exits. Without
+// permission or outside Linux the counters are skipped with a warning on
+// stderr.
+class PerfCounters {
+public:
+  explicit PerfCounters(bool enabled);
+  ~PerfCounters();
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  void start();
+  void stop();
+  // Sets result.counters if the counters could be opened.
+  void fill(Result &result) const;
+
+private:
+  // One group of counters per thread, the leader fd first.
+  std::vector<std::vector<int>> groups_;
+};
@@ -1,26 +1,246 @@
 #include "result.hpp"
+#include "json.hpp"
+#include "keys.hpp"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
 #include <fstream>
+#include <sstream>
 
 std::ostream &operator<<(std::ostream &os, const Result &res) {
   return res.print_to_stream(os);
 }
 
+namespace {
+double gbs(size_t bytes, double us) { return us > 0 ? bytes / us / 1e3 : 0; }
+double mrows(size_t rows, double us) { return us > 0 ? rows / us : 0; }
+
+void write_stats(JsonWriter &json, const Stats &s) {
+  json.begin_object()
+      .field("samples", s.samples)
+      .field("outliers", s.outliers)
+      .field("min", s.min)
+      .field("max", s.max)
+      .field("mean", s.mean)
+      .field("median", s.median)
+      .field("p95", s.p95)
+      .field("p99", s.p99)
+      .field("stddev", s.stddev)
+      .field("ci95", s.ci95)
+      .end_object();
+}
+
+void print_probes(std::ostream &os, const char *label,
+                  const ProbeStats::Histogram &h) {
+  if (!ProbeStats::count(h))
+    return;
+  os << label << "mean " << ProbeStats::mean(h) << ", p99 "
+     << ProbeStats::quantile(h, 0.99) << ", histogram";
+  for (size_t i = 0; i < h.size(); ++i) {
+    os << " " << h[i];
+  }
+  os << "\n";
+}
+
+// <op>_ops, <op>_probes_mean, <op>_probes_p99 and <op>_probes_<n> for every
+// histogram entry, the last one <op>_probes_<n>_plus.
+void add_probe_fields(ResultFields &out, const std::string &op,
+                      const ProbeStats::Histogram &h) {
+  out.emplace_back(op + "_ops", static_cast<double>(ProbeStats::count(h)));
+  out.emplace_back(op + "_probes_mean", ProbeStats::mean(h));
+  out.emplace_back(op + "_probes_p99",
+                   static_cast<double>(ProbeStats::quantile(h, 0.99)));
+  for (size_t i = 0; i < h.size(); ++i) {
+    std::string name = op + "_probes_" + std::to_string(i + 1);
+    if (i + 1 == h.size())
+      name += "_plus";
+    out.emplace_back(name, static_cast<double>(h[i]));
+  }
+}
+
+// Bytes of the buf_size input keys, 32-bit unless the dwarf reports a
+// key_width.
+size_t input_bytes(const DwarfParams &params) {
+  KeyWidth width = KeyWidth::Bits32;
+  auto it = params.find("key_width");
+  if (it != params.end()) {
+    std::istringstream is(it->second);
+    is >> width;
+  }
+  return std::stoull(params.at("buf_size")) * key_bytes(width);
+}
+
+std::string utc_timestamp() {
+  std::time_t now = std::time(nullptr);
+  char buf[32];
+  std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+  return buf;
+}
+} // namespace
+
 std::ostream &Result::print_to_stream(std::ostream &os) const {
   os << "Kernel duration: " << ((double)kernel_time) / 1000.0 << " us\n"
      << "Host duration:   " << host_time.count() << " us\n";
+  if (h2d_time || d2h_time || queue_time) {
+    os << "H2D transfer:    " << h2d_time / 1000.0 << " us\n"
+       << "D2H transfer:    " << d2h_time / 1000.0 << " us\n"
+       << "Queue overhead:  " << queue_time / 1000.0 << " us\n";
+  }
+  if (counters.collected) {
+    os << "IPC:             " << counters.ipc() << "\n"
+       << "LLC MPKI:        " << counters.mpki(counters.llc_misses) << "\n"
+       << "dTLB MPKI:       " << counters.mpki(counters.dtlb_misses) << "\n"
+       << "Branch MPKI:     " << counters.mpki(counters.branch_misses) << "\n";
+  }
+  if (probes.collected) {
+    print_probes(os, "Insert probes:   ", probes.inserts);
+    print_probes(os, "Lookup probes:   ", probes.lookups);
+    os << "CAS failures:    " << probes.cas_failures << "\n";
+    if (probes.evictions)
+      os << "Evictions:       " << probes.evictions << "\n";
+    if (probes.nodes_allocated)
+      os << "Slab nodes:      " << probes.nodes_allocated << "\n";
+  }
+  if (table_bytes)
+    os << "Hash table:      " << table_bytes / 1024.0 << " KiB\n";
+  if (slabs_allocated)
+    os << "Slabs:           " << slabs_used << " of " << slabs_allocated
+       << " used\n";
+  if (rehashes)
+    os << "Rehashes:        " << rehashes << "\n";
+  if (rows) {
+    os << "Bandwidth:       " << bandwidth_gbs() << " GB/s\n"
+       << "Throughput:      " << mrows_per_sec() << " Mrows/s\n";
+  }
 
   return os;
 }
 
+double Result::bandwidth_gbs() const {
+  return gbs(bytes_read + bytes_written, host_time.count());
+}
+
+double Result::mrows_per_sec() const {
+  return mrows(rows, host_time.count());
+}
+
+ResultFields Result::fields() const {
+  ResultFields out = {{"host_time_us", host_time.count()},
+                      {"kernel_time_us", kernel_time / 1000.0},
+                      {"h2d_time_us", h2d_time / 1000.0},
+                      {"d2h_time_us", d2h_time / 1000.0},
+                      {"queue_time_us", queue_time / 1000.0},
+                      {"rows", static_cast<double>(rows)},
+                      {"bytes_read", static_cast<double>(bytes_read)},
+                      {"bytes_written", static_cast<double>(bytes_written)}};
+  if (table_bytes)
+    out.emplace_back("table_bytes", static_cast<double>(table_bytes));
+  if (slabs_allocated) {
+    out.emplace_back("slabs_allocated", static_cast<double>(slabs_allocated));
+    out.emplace_back("slabs_used", static_cast<double>(slabs_used));
+  }
+  if (rehashes)
+    out.emplace_back("rehashes", static_cast<double>(rehashes));
+  if (counters.collected) {
+    out.emplace_back("cycles", static_cast<double>(counters.cycles));
+    out.emplace_back("instructions",
+                     static_cast<double>(counters.instructions));
+    out.emplace_back("llc_misses", static_cast<double>(counters.llc_misses));
+    out.emplace_back("dtlb_misses", static_cast<double>(counters.dtlb_misses));
+    out.emplace_back("branch_misses",
+                     static_cast<double>(counters.branch_misses));
+    out.emplace_back("ipc", counters.ipc());
+  }
+  if (probes.collected) {
+    add_probe_fields(out, "insert", probes.inserts);
+    add_probe_fields(out, "lookup", probes.lookups);
+    out.emplace_back("cas_failures", static_cast<double>(probes.cas_failures));
+    out.emplace_back("evictions", static_cast<double>(probes.evictions));
+    out.emplace_back("nodes_allocated",
+                     static_cast<double>(probes.nodes_allocated));
+  }
+  return out;
+}
+
+double CounterValues::ipc() const {
+  return cycles ? static_cast<double>(instructions) / cycles : 0;
+}
+
+double CounterValues::mpki(uint64_t misses) const {
+  return instructions ? 1000.0 * misses / instructions : 0;
+}
+
+uint64_t ProbeStats::count(const Histogram &h) {
+  uint64_t n = 0;
+  for (uint64_t c : h) {
+    n += c;
+  }
+  return n;
+}
+
+double ProbeStats::mean(const Histogram &h) {
+  double sum = 0;
+  for (size_t i = 0; i < h.size(); ++i) {
+    sum += static_cast<double>(h[i]) * (i + 1);
+  }
+  const uint64_t n = count(h);
+  return n ? sum / n : 0;
+}
+
+size_t ProbeStats::quantile(const Histogram &h, double q) {
+  const double target = q * count(h);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < h.size(); ++i) {
+    seen += h[i];
+    if (seen > 0 && seen >= target)
+      return i + 1;
+  }
+  return 0;
+}
+
+ResultFields HashJoinResult::fields() const {
+  ResultFields out = Result::fields();
+  out.emplace_back("build_time_us", build_time.count());
+  out.emplace_back("probe_time_us", probe_time.count());
+  out.emplace_back("partition_time_us", partition_time.count());
+  return out;
+}
+
 std::ostream &HashJoinResult::print_to_stream(std::ostream &os) const {
   Result::print_to_stream(os);
 
+  if (partition_time.count())
+    os << "Partition time: " << partition_time.count() << " us\n";
   os << "Build time: " << build_time.count() << " us\n"
      << "Probe time: " << probe_time.count() << " us\n";
 
   return os;
 }
 
+ResultFields HashQualityResult::fields() const {
+  ResultFields out = Result::fields();
+  out.emplace_back("table_size", static_cast<double>(quality.table_size));
+  out.emplace_back("distinct_keys", static_cast<double>(quality.keys));
+  out.emplace_back("collisions", static_cast<double>(quality.collisions));
+  out.emplace_back("occupancy_variance", quality.occupancy_variance);
+  out.emplace_back("max_probe_length",
+                   static_cast<double>(quality.max_probe_length));
+  out.emplace_back("mean_probe_length", quality.mean_probe_length);
+  return out;
+}
+
+std::ostream &HashQualityResult::print_to_stream(std::ostream &os) const {
+  Result::print_to_stream(os);
+
+  os << "Collisions: " << quality.collisions << " of " << quality.keys
+     << " keys in " << quality.table_size << " slots\n"
+     << "Occupancy variance: " << quality.occupancy_variance << "\n"
+     << "Probe length: max " << quality.max_probe_length << ", mean "
+     << quality.mean_probe_length << "\n";
+
+  return os;
+}
+
 MeasureResults::const_iterator MeasureResults::begin() const {
   return results_.begin();
 }
@@ -29,9 +249,60 @@ MeasureResults::const_iterator MeasureResults::end() const {
   return results_.end();
 }
 
+bool DwarfRunResult::valid() const {
+  return std::all_of(samples.begin(), samples.end(),
+                     [](const auto &s) { return s->valid; });
+}
+
+double DwarfRunResult::bandwidth_gbs() const {
+  const Result &r = result();
+  return gbs(r.bytes_read + r.bytes_written, host_stats.median);
+}
+
+double DwarfRunResult::mrows_per_sec() const {
+  return mrows(result().rows, host_stats.median);
+}
+
+double DwarfRunResult::peak_bandwidth_pct() const {
+  return peak_bandwidth > 0 ? bandwidth_gbs() / peak_bandwidth * 100 : 0;
+}
+
 void MeasureResults::add_result(DwarfParams params,
                                 std::unique_ptr<Result> result) {
-  results_.push_back({params, std::move(result)});
+  std::vector<std::unique_ptr<Result>> samples;
+  samples.push_back(std::move(result));
+  add_result(std::move(params), std::move(samples), 0);
+}
+
+void MeasureResults::add_result(DwarfParams params,
+                                std::vector<std::unique_ptr<Result>> samples,
+                                double outlier_threshold) {
+  if (samples.empty())
+    throw std::logic_error("No samples to add for " + name_);
+
+  std::vector<double> host_times;
+  std::vector<double> kernel_times;
+  for (const auto &s : samples) {
+    host_times.push_back(s->host_time.count());
+    kernel_times.push_back(s->kernel_time / 1000.0);
+  }
+
+  DwarfRunResult run;
+  run.params = std::move(params);
+  run.device = device_;
+  run.peak_bandwidth = peak_bandwidth_;
+  run.host_stats = stats::summarize(host_times, outlier_threshold);
+  run.kernel_stats = stats::summarize(kernel_times, outlier_threshold);
+
+  auto closest = std::min_element(
+      host_times.begin(), host_times.end(), [&](double a, double b) {
+        return std::abs(a - run.host_stats.median) <
+               std::abs(b - run.host_stats.median);
+      });
+  run.median_idx = std::distance(host_times.begin(), closest);
+  run.samples = std::move(samples);
+
+  results_.push_back(std::move(run));
 }
 
 void MeasureResults::write_csv(const std::string &filename) const {
@@ -39,14 +310,70 @@ void MeasureResults::write_csv(const std::string &filename) const {
   std::ofstream of(filename, std::ios::app);
   if (of.is_open()) {
     if (!exists)
-      of << "device_type,buf_size_bytes,host_time_ms,kernel_time_ms\n";
+      of << "device_type,buf_size_bytes,host_time_ms,kernel_time_ms,"
+            "host_min_ms,host_p95_ms,host_p99_ms,host_stddev_ms,"
+            "host_ci95_ms,samples,outliers,bytes_read,bytes_written,rows,"
+            "bandwidth_gbs,mrows_per_s,peak_bandwidth_pct\n";
     for (const auto &res : results_) {
-      of << res.params.at("device_type") << ","
-         << std::stoi(res.params.at("buf_size")) * 4 << ",";
-      of << res.result->host_time.count() / 1000.0 << ","
-         << ((double)res.result->kernel_time) / (1000.0 * 1000.0) << "\n";
+      const auto &host = res.host_stats;
+      const Result &r = res.result();
+      of << res.params.at("device_type") << "," << input_bytes(res.params)
+         << ",";
+      of << host.median / 1000.0 << "," << res.kernel_stats.median / 1000.0
+         << "," << host.min / 1000.0 << "," << host.p95 / 1000.0 << ","
+         << host.p99 / 1000.0 << "," << host.stddev / 1000.0 << ","
+         << host.ci95 / 1000.0 << "," << host.samples << "," << host.outliers
+         << "," << r.bytes_read << "," << r.bytes_written << "," << r.rows
+         << "," << res.bandwidth_gbs() << "," << res.mrows_per_sec() << ","
+         << res.peak_bandwidth_pct() << "\n";
     }
   } else {
     throw std::runtime_error("Could not open the file at " + filename);
   }
-}
\ No newline at end of file
+}
+void MeasureResults::write_json(const std::string &filename) const {
+  std::ofstream of(filename, std::ios::app);
+  if (!of.is_open())
+    throw std::runtime_error("Could not open the file at " + filename);
+
+  const Environment env = host_environment();
+  const std::string timestamp = utc_timestamp();
+  for (const auto &res : results_) {
+    JsonWriter json(of);
+    json.begin_object().field("dwarf", name_).field("timestamp", timestamp);
+
+    json.key("params").begin_object();
+    for (const auto &p : res.params) {
+      json.field(p.first, p.second);
+    }
+    json.end_object();
+
+    json.field("valid", res.valid());
+    json.key("host_time_us");
+    write_stats(json, res.host_stats);
+    json.key("kernel_time_us");
+    write_stats(json, res.kernel_stats);
+    json.field("bandwidth_gbs", res.bandwidth_gbs())
+        .field("mrows_per_s", res.mrows_per_sec())
+        .field("peak_bandwidth_gbs", res.peak_bandwidth)
+        .field("peak_bandwidth_pct", res.peak_bandwidth_pct())
+        .field("median_sample", res.median_idx);
+
+    json.key("samples").begin_array();
+    for (const auto &sample : res.samples) {
+      json.begin_object();
+      for (const auto &f : sample->fields()) {
+        json.field(f.first, f.second);
+      }
+      json.field("valid", sample->valid).end_object();
+    }
+    json.end_array();
+
+    json.key("device");
+    ::write_json(json, res.device);
+    json.key("environment");
+    ::write_json(json, env);
+    json.end_object();
+    of << "\n";
+  }
+}
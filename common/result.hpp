@@ -1,15 +1,77 @@
 #pragma once
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "environment.hpp"
+#include "stats.hpp"
+
 using DwarfParams = std::map<std::string, std::string>;
 
 using Duration = std::chrono::duration<double, std::micro>;
+// Named numeric fields of a result for structured reports, durations in us.
+using ResultFields = std::vector<std::pair<std::string, double>>;
+
+// Device command of a measured iteration, timestamps are device ns.
+struct DeviceCommand {
+  enum Kind { H2D, Kernel, D2H };
+  std::string name;
+  Kind kind = Kernel;
+  uint64_t submit = 0;
+  uint64_t start = 0;
+  uint64_t end = 0;
+  // Host steady_clock ns when the command was recorded, right after its
+  // submission, to align the device clock with the host one in traces.
+  uint64_t host_submit = 0;
+};
+
+// Hardware counters of the measured region (user space, all threads of the
+// process), collected for CPU runs with --perf_counters.
+struct CounterValues {
+  bool collected = false;
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  uint64_t llc_misses = 0;
+  uint64_t dtlb_misses = 0;
+  uint64_t branch_misses = 0;
+
+  double ipc() const;
+  // Misses per thousand instructions.
+  double mpki(uint64_t misses) const;
+};
+
+// Hash table internals of the measured region, collected by the hash-based
+// dwarfs with --probe_stats. Histograms count operations by the number of
+// slots (or slab nodes) they visited: entry i is i + 1 of them, the last one
+// that many or more.
+struct ProbeStats {
+  static constexpr size_t histogram_size = 16;
+  using Histogram = std::array<uint64_t, histogram_size>;
+
+  bool collected = false;
+  Histogram inserts = {};
+  Histogram lookups = {};
+  // Lost compare-and-swaps on a slot or value.
+  uint64_t cas_failures = 0;
+  // Keys moved out of their slot by cuckoo insertions.
+  uint64_t evictions = 0;
+  uint64_t nodes_allocated = 0;
+
+  static uint64_t count(const Histogram &h);
+  // Mean probe length, counting the last entry as its lower bound.
+  static double mean(const Histogram &h);
+  // Smallest length at least `q` of the operations stay within.
+  static size_t quantile(const Histogram &h, double q);
+};
+
 struct Result {
+  virtual ~Result() = default;
   size_t thread_x = 1, thread_y = 1, tread_z = 1;
   size_t group_size = 1;
   size_t bytes = 0;
@@ -18,6 +80,32 @@ struct Result {
   unsigned long kernel_time = 0;
   Duration host_time;
   bool valid = true;
+  // Logical data volume touched by the measured region, used to normalize
+  // timings across dwarfs, element widths and devices.
+  size_t bytes_read = 0;
+  size_t bytes_written = 0;
+  size_t rows = 0;
+  // Device memory of the hash table of hash-based dwarfs, for footprint
+  // against throughput curves over --load_factor.
+  size_t table_bytes = 0;
+  // Slabs of the heap of slab hash tables and the ones holding entries.
+  size_t slabs_allocated = 0;
+  size_t slabs_used = 0;
+  // Resizes of growable hash tables on the way to the final table_bytes.
+  size_t rehashes = 0;
+  // Breakdown of host_time in ns: transfers and queue overhead (submission,
+  // scheduling and waits) next to kernel_time. Filled from event profiling.
+  unsigned long h2d_time = 0;
+  unsigned long d2h_time = 0;
+  unsigned long queue_time = 0;
+  std::vector<DeviceCommand> commands;
+  CounterValues counters;
+  ProbeStats probes;
+
+  double bandwidth_gbs() const;
+  double mrows_per_sec() const;
+
+  virtual ResultFields fields() const;
 
 protected:
   virtual std::ostream &print_to_stream(std::ostream &os) const;
@@ -27,6 +115,15 @@ protected:
 struct HashJoinResult : public Result {
   Duration probe_time;
   Duration build_time;
+  // Radix partitioning of both sides before the build, 0 for joins without.
+  Duration partition_time;
+  ResultFields fields() const override;
+  std::ostream &print_to_stream(std::ostream &os) const override;
+};
+
+struct HashQualityResult : public Result {
+  HashQuality quality;
+  ResultFields fields() const override;
   std::ostream &print_to_stream(std::ostream &os) const override;
 };
 
@@ -34,7 +131,24 @@ std::ostream &operator<<(std::ostream &os, const Result &res);
 
 struct DwarfRunResult {
   DwarfParams params;
-  std::unique_ptr<Result> result;
+  // All measured (non-warmup) iterations of a single parameter point.
+  std::vector<std::unique_ptr<Result>> samples;
+  Stats host_stats;
+  Stats kernel_stats;
+  // Sample with the host time closest to the median one.
+  size_t median_idx = 0;
+
+  // Device and peak bandwidth at the time the point was measured.
+  DeviceInfo device;
+  double peak_bandwidth = 0;
+
+  const Result &result() const { return *samples[median_idx]; }
+  bool valid() const;
+  // Throughput at the median host time.
+  double bandwidth_gbs() const;
+  double mrows_per_sec() const;
+  // 0 if the peak bandwidth is unknown.
+  double peak_bandwidth_pct() const;
 };
 
 using SingleRunResults = std::vector<DwarfRunResult>;
@@ -44,13 +158,29 @@ public:
   MeasureResults(const std::string &name) : name_(name) {}
 
   void add_result(DwarfParams params, std::unique_ptr<Result> result);
+  void add_result(DwarfParams params,
+                  std::vector<std::unique_ptr<Result>> samples,
+                  double outlier_threshold);
 
   const_iterator begin() const;
   const_iterator end() const;
 
   void write_csv(const std::string &filename) const;
+  // Appends one JSON object per parameter point (JSON lines) with all params,
+  // summary statistics, per-iteration samples and environment metadata.
+  void write_json(const std::string &filename) const;
+
+  // Applied to the points added afterwards.
+  void set_device_info(DeviceInfo device) { device_ = std::move(device); }
+  const DeviceInfo &device_info() const { return device_; }
+
+  // Measured or user-provided peak memory bandwidth in GB/s, 0 if unknown.
+  void set_peak_bandwidth(double gbs) { peak_bandwidth_ = gbs; }
+  double peak_bandwidth() const { return peak_bandwidth_; }
 
 private:
   SingleRunResults results_;
   const std::string name_;
+  double peak_bandwidth_ = 0;
+  DeviceInfo device_;
 };
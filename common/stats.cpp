@@ -0,0 +1,133 @@
+#include "stats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+
+namespace {
+// Two-sided 95% Student's t critical values for 1..30 degrees of freedom.
+constexpr double t_table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447,
+                              2.365,  2.306, 2.262, 2.228, 2.201, 2.179,
+                              2.160,  2.145, 2.131, 2.120, 2.110, 2.101,
+                              2.093,  2.086, 2.080, 2.074, 2.069, 2.064,
+                              2.060,  2.056, 2.052, 2.048, 2.045, 2.042};
+
+// Scales MAD to be a consistent estimator of the standard deviation for
+// normally distributed data.
+constexpr double mad_scale = 1.4826;
+} // namespace
+
+std::ostream &operator<<(std::ostream &os, const Stats &s) {
+  os << "min " << s.min << ", median " << s.median << ", p95 " << s.p95
+     << ", p99 " << s.p99 << ", stddev " << s.stddev << ", ci95 +-" << s.ci95
+     << " (" << s.samples << " samples, " << s.outliers << " outliers)";
+  return os;
+}
+
+namespace stats {
+double t_critical(size_t dof) {
+  constexpr size_t table_size = sizeof(t_table) / sizeof(t_table[0]);
+  if (dof == 0)
+    return 0;
+  return dof <= table_size ? t_table[dof - 1] : 1.96;
+}
+
+double median(std::vector<double> values) {
+  if (values.empty())
+    return 0;
+  std::sort(values.begin(), values.end());
+  return percentile(values, 50);
+}
+
+double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  double pos = p / 100.0 * (sorted.size() - 1);
+  size_t lo = static_cast<size_t>(std::floor(pos));
+  size_t hi = std::min(lo + 1, sorted.size() - 1);
+  double frac = pos - lo;
+  return sorted[lo] + (sorted[hi] - sorted[lo]) * frac;
+}
+
+std::vector<double> reject_outliers(const std::vector<double> &values,
+                                    double threshold) {
+  if (threshold <= 0 || values.size() < 3)
+    return values;
+
+  double med = median(values);
+  std::vector<double> deviations(values.size());
+  std::transform(values.begin(), values.end(), deviations.begin(),
+                 [med](double v) { return std::abs(v - med); });
+  double mad = median(deviations) * mad_scale;
+  if (mad == 0)
+    return values;
+
+  std::vector<double> kept;
+  std::copy_if(values.begin(), values.end(), std::back_inserter(kept),
+               [&](double v) { return std::abs(v - med) <= threshold * mad; });
+  return kept;
+}
+
+Stats summarize(const std::vector<double> &values, double outlier_threshold) {
+  Stats s;
+  std::vector<double> kept = reject_outliers(values, outlier_threshold);
+  if (kept.empty())
+    return s;
+
+  std::sort(kept.begin(), kept.end());
+  s.samples = kept.size();
+  s.outliers = values.size() - kept.size();
+  s.min = kept.front();
+  s.max = kept.back();
+  s.mean = std::accumulate(kept.begin(), kept.end(), 0.0) / kept.size();
+  s.median = percentile(kept, 50);
+  s.p95 = percentile(kept, 95);
+  s.p99 = percentile(kept, 99);
+
+  if (kept.size() > 1) {
+    double sq_sum = 0;
+    for (double v : kept) {
+      sq_sum += (v - s.mean) * (v - s.mean);
+    }
+    s.stddev = std::sqrt(sq_sum / (kept.size() - 1));
+    s.ci95 = t_critical(kept.size() - 1) * s.stddev / std::sqrt(kept.size());
+  }
+  return s;
+}
+
+HashQuality hash_quality(const std::vector<size_t> &slots, size_t table_size) {
+  HashQuality q;
+  q.keys = slots.size();
+  q.table_size = table_size;
+  if (table_size == 0)
+    return q;
+
+  std::vector<size_t> counts(table_size, 0);
+  for (size_t slot : slots) {
+    q.collisions += counts[slot]++ > 0;
+  }
+  const double mean = static_cast<double>(q.keys) / table_size;
+  for (size_t c : counts) {
+    q.occupancy_variance += (c - mean) * (c - mean);
+  }
+  q.occupancy_variance /= table_size;
+
+  // Keys beyond the table size would never find a free slot.
+  std::vector<bool> used(table_size, false);
+  size_t total = 0;
+  const size_t inserted = std::min(q.keys, table_size);
+  for (size_t i = 0; i < inserted; ++i) {
+    size_t at = slots[i];
+    size_t length = 1;
+    while (used[at]) {
+      at = at + 1 == table_size ? 0 : at + 1;
+      ++length;
+    }
+    used[at] = true;
+    total += length;
+    q.max_probe_length = std::max(q.max_probe_length, length);
+  }
+  q.mean_probe_length = inserted ? static_cast<double>(total) / inserted : 0;
+  return q;
+}
+} // namespace stats
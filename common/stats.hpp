@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+struct Stats {
+  size_t samples = 0;
+  size_t outliers = 0;
+  double min = 0;
+  double max = 0;
+  double mean = 0;
+  double median = 0;
+  double p95 = 0;
+  double p99 = 0;
+  double stddev = 0;
+  // Half-width of the 95% confidence interval of the mean.
+  double ci95 = 0;
+
+  double relative_ci() const { return mean != 0 ? ci95 / mean : 0; }
+};
+
+std::ostream &operator<<(std::ostream &os, const Stats &s);
+
+// Spread of distinct keys over the slots of a hash table by their hashes.
+struct HashQuality {
+  size_t keys = 0;
+  size_t table_size = 0;
+  // Keys whose slot already holds an earlier key.
+  size_t collisions = 0;
+  // Variance of the number of keys per slot, keys / size for ideal hashes.
+  double occupancy_variance = 0;
+  // Slots visited to insert a key with linear probing.
+  size_t max_probe_length = 0;
+  double mean_probe_length = 0;
+};
+
+namespace stats {
+// Two-sided 95% Student's t critical value.
+double t_critical(size_t dof);
+double median(std::vector<double> values);
+// Expects sorted values, p is in [0, 100].
+double percentile(const std::vector<double> &sorted, double p);
+// Drops values that are further than `threshold` scaled median absolute
+// deviations away from the median. Threshold of 0 disables rejection.
+std::vector<double> reject_outliers(const std::vector<double> &values,
+                                    double threshold);
+Stats summarize(const std::vector<double> &values, double outlier_threshold);
+// Takes the slots of distinct keys in insertion order.
+HashQuality hash_quality(const std::vector<size_t> &slots, size_t table_size);
+} // namespace stats
@@ -0,0 +1,259 @@
+#include "suite.hpp"
+#include "dataset.hpp"
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/property_tree/ini_parser.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace pt = boost::property_tree;
+
+namespace {
+using Settings = std::map<std::string, std::vector<std::string>>;
+
+bool ends_with(const std::string &s, const std::string &suffix) {
+  return s.size() >= suffix.size() &&
+         s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// A setting is either a scalar or a JSON array of scalars.
+bool is_setting(const pt::ptree &node) {
+  for (const auto &child : node) {
+    if (!child.first.empty() || !child.second.empty())
+      return false;
+  }
+  return true;
+}
+
+std::vector<std::string> values(const pt::ptree &node) {
+  std::vector<std::string> out;
+  if (node.empty()) {
+    boost::split(out, node.data(), boost::is_any_of(" ,\t"),
+                 boost::token_compress_on);
+    out.erase(std::remove(out.begin(), out.end(), ""), out.end());
+  } else {
+    for (const auto &child : node) {
+      out.push_back(child.second.data());
+    }
+  }
+  return out;
+}
+
+Settings read_settings(const pt::ptree &node) {
+  Settings out;
+  for (const auto &child : node) {
+    if (child.first != "runs" && is_setting(child.second))
+      out[child.first] = values(child.second);
+  }
+  return out;
+}
+
+template <class T> T to(const std::string &key, const std::string &value) {
+  try {
+    return boost::lexical_cast<T>(value);
+  } catch (const boost::bad_lexical_cast &) {
+    throw std::invalid_argument("Bad value '" + value + "' for " + key +
+                                " in the sweep file");
+  }
+}
+
+template <class T>
+T single(const std::string &key, const std::vector<std::string> &vals) {
+  if (vals.size() != 1)
+    throw std::invalid_argument("Expected a single value for " + key +
+                                " in the sweep file");
+  return to<T>(key, vals.front());
+}
+
+void apply(RunOptions &opts, const std::string &key,
+           const std::vector<std::string> &vals) {
+  if (key == "input_size") {
+    opts.input_size.clear();
+    for (const auto &v : vals) {
+      opts.input_size.push_back(to<size_t>(key, v));
+    }
+  } else if (key == "load_factor") {
+    opts.load_factor.clear();
+    for (const auto &v : vals) {
+      opts.load_factor.push_back(to<double>(key, v));
+    }
+  } else if (key == "op_mix") {
+    opts.op_mix.clear();
+    for (const auto &v : vals) {
+      std::istringstream is(v);
+      OpMix mix;
+      if (!(is >> mix))
+        throw std::invalid_argument("Bad value '" + v +
+                                    "' for op_mix in the sweep file");
+      opts.op_mix.push_back(mix);
+    }
+  } else if (key == "iterations") {
+    opts.iterations = single<size_t>(key, vals);
+  } else if (key == "warmup") {
+    opts.warmup = single<size_t>(key, vals);
+  } else if (key == "target_ci") {
+    opts.target_ci = single<double>(key, vals);
+  } else if (key == "max_iterations") {
+    opts.max_iterations = single<size_t>(key, vals);
+  } else if (key == "outlier_threshold") {
+    opts.outlier_threshold = single<double>(key, vals);
+  } else if (key == "peak_bandwidth") {
+    opts.peak_bandwidth = single<double>(key, vals);
+  } else if (key == "measure_peak_bandwidth") {
+    auto v = single<std::string>(key, vals);
+    opts.measure_peak_bandwidth = v == "true" || v == "1";
+  } else if (key == "distribution") {
+    std::istringstream is(single<std::string>(key, vals));
+    if (!(is >> opts.distribution))
+      throw std::invalid_argument("Bad value '" + is.str() +
+                                  "' for distribution in the sweep file");
+  } else if (key == "probe_ratio") {
+    opts.probe_ratio = single<double>(key, vals);
+  } else if (key == "match_rate") {
+    opts.match_rate = single<double>(key, vals);
+  } else if (key == "build_duplicates") {
+    opts.build_duplicates = single<size_t>(key, vals);
+  } else if (key == "probe_duplicates") {
+    opts.probe_duplicates = single<size_t>(key, vals);
+  } else if (key == "partition_fanout") {
+    opts.partition_fanout = single<size_t>(key, vals);
+  } else if (key == "partition_passes") {
+    opts.partition_passes = single<size_t>(key, vals);
+  } else if (key == "key_width") {
+    std::istringstream is(single<std::string>(key, vals));
+    if (!(is >> opts.key_width))
+      throw std::invalid_argument("Bad value '" + is.str() +
+                                  "' for key_width in the sweep file");
+  } else if (key == "hasher") {
+    std::istringstream is(single<std::string>(key, vals));
+    if (!(is >> opts.hasher))
+      throw std::invalid_argument("Bad value '" + is.str() +
+                                  "' for hasher in the sweep file");
+  } else if (key == "verify") {
+    std::istringstream is(single<std::string>(key, vals));
+    if (!(is >> opts.verify))
+      throw std::invalid_argument("Bad value '" + is.str() +
+                                  "' for verify in the sweep file");
+  } else if (key == "seed") {
+    opts.seed = single<uint64_t>(key, vals);
+  } else if (key == "dataset") {
+    opts.dataset = std::make_shared<Dataset>(single<std::string>(key, vals));
+  } else if (key == "perf_counters") {
+    auto v = single<std::string>(key, vals);
+    opts.perf_counters = v == "true" || v == "1";
+  } else if (key == "probe_stats") {
+    auto v = single<std::string>(key, vals);
+    opts.probe_stats = v == "true" || v == "1";
+  } else if (key != "dwarf" && key != "device" && key != "groups_count" &&
+             key != "executors" && key != "report_path") {
+    throw std::invalid_argument("Unknown setting '" + key +
+                                "' in the sweep file");
+  }
+}
+
+std::vector<size_t> sizes(const Settings &s, const std::string &key,
+                          size_t fallback) {
+  auto it = s.find(key);
+  if (it == s.end())
+    return {fallback};
+  std::vector<size_t> out;
+  for (const auto &v : it->second) {
+    out.push_back(to<size_t>(key, v));
+  }
+  return out;
+}
+
+void expand(const Settings &settings, const RunOptions &defaults,
+            size_t groups_count, size_t executors,
+            std::vector<SuitePoint> &points) {
+  auto dwarf = settings.find("dwarf");
+  if (dwarf == settings.end())
+    throw std::invalid_argument("A run in the sweep file has no dwarf");
+  const std::string name = single<std::string>("dwarf", dwarf->second);
+
+  RunOptions base = defaults;
+  for (const auto &s : settings) {
+    apply(base, s.first, s.second);
+  }
+
+  std::vector<RunOptions::DeviceType> devices = {defaults.device_ty};
+  auto dev = settings.find("device");
+  if (dev != settings.end()) {
+    devices.clear();
+    for (const auto &v : dev->second) {
+      std::istringstream is(v);
+      RunOptions::DeviceType ty;
+      is >> ty;
+      devices.push_back(ty);
+    }
+  }
+
+  for (auto device : devices) {
+    for (auto groups : sizes(settings, "groups_count", groups_count)) {
+      for (auto exec : sizes(settings, "executors", executors)) {
+        RunOptions opts = base;
+        opts.device_ty = device;
+        points.push_back({name, make_run_options(name, opts, groups, exec)});
+      }
+    }
+  }
+}
+} // namespace
+
+std::shared_ptr<RunOptions> make_run_options(const std::string &dwarf,
+                                             const RunOptions &opts,
+                                             size_t groups_count,
+                                             size_t executors) {
+  if (dwarf.find("GroupBy") != std::string::npos)
+    return std::make_shared<GroupByRunOptions>(opts, groups_count, executors);
+  return std::make_shared<RunOptions>(opts);
+}
+
+Suite load_suite(const std::string &path, const RunOptions &defaults,
+                 size_t groups_count, size_t executors) {
+  pt::ptree tree;
+  if (ends_with(path, ".json")) {
+    pt::read_json(path, tree);
+  } else if (ends_with(path, ".ini")) {
+    pt::read_ini(path, tree);
+  } else {
+    throw std::invalid_argument("Unsupported sweep file " + path +
+                                ", expected .json or .ini");
+  }
+
+  const Settings top = read_settings(tree);
+  Suite suite;
+  auto report = top.find("report_path");
+  suite.report_path = report != top.end()
+                          ? single<std::string>("report_path", report->second)
+                          : defaults.report_path;
+
+  std::vector<const pt::ptree *> runs;
+  if (auto json_runs = tree.get_child_optional("runs")) {
+    for (const auto &run : *json_runs) {
+      runs.push_back(&run.second);
+    }
+  } else {
+    for (const auto &section : tree) {
+      if (!is_setting(section.second))
+        runs.push_back(&section.second);
+    }
+  }
+
+  for (const auto *run : runs) {
+    Settings settings = top;
+    settings.erase("report_path");
+    for (auto &s : read_settings(*run)) {
+      if (s.first == "report_path")
+        throw std::invalid_argument(
+            "report_path is only allowed on the top level of a sweep file");
+      settings[s.first] = s.second;
+    }
+    expand(settings, defaults, groups_count, executors, suite.points);
+  }
+  return suite;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "options.hpp"
+
+// One dwarf run of a sweep: a dwarf name and fully resolved options.
+struct SuitePoint {
+  std::string dwarf;
+  std::shared_ptr<RunOptions> opts;
+};
+
+struct Suite {
+  // Consolidated report for all points, empty to print to stdout.
+  std::string report_path;
+  std::vector<SuitePoint> points;
+};
+
+// Creates GroupByRunOptions for groupby dwarfs, plain RunOptions otherwise.
+std::shared_ptr<RunOptions> make_run_options(const std::string &dwarf,
+                                             const RunOptions &opts,
+                                             size_t groups_count,
+                                             size_t executors);
+
+// Reads a sweep file (.json or .ini) and expands it into the Cartesian
+// product of devices, groups_count and executors of every run. Settings on
+// the top level are defaults for all runs, `defaults` fills the rest.
+//
+// JSON:
+//   {"iterations": 9, "report_path": "sweep.jsonl",
+//    "runs": [{"dwarf": "Radix", "device": ["cpu", "igpu"],
+//              "input_size": [256, 512, 1024]}]}
+// INI, one section per run, lists separated by spaces:
+//   iterations = 9
+//   [radix]
+//   dwarf = Radix
+//   device = cpu igpu
+//   input_size = 256 512 1024
+Suite load_suite(const std::string &path, const RunOptions &defaults,
+                 size_t groups_count, size_t executors);
@@ -0,0 +1,108 @@
+#include "trace.hpp"
+#include "json.hpp"
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+const char *category(DeviceCommand::Kind kind) {
+  switch (kind) {
+  case DeviceCommand::H2D:
+    return "h2d";
+  case DeviceCommand::D2H:
+    return "d2h";
+  default:
+    return "kernel";
+  }
+}
+} // namespace
+
+Tracer::Tracer() : origin_(Clock::now()) {}
+
+double Tracer::since_origin_us(Clock::time_point t) const {
+  return std::chrono::duration<double, std::micro>(t - origin_).count();
+}
+
+size_t Tracer::thread_id() {
+  auto it = threads_.emplace(std::this_thread::get_id(), threads_.size() + 1);
+  return it.first->second;
+}
+
+void Tracer::span(const std::string &name, const std::string &category,
+                  Clock::time_point start, Clock::time_point end) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.push_back({name, category, since_origin_us(start),
+                     since_origin_us(end) - since_origin_us(start),
+                     thread_id()});
+}
+
+void Tracer::device_commands(const std::vector<DeviceCommand> &commands) {
+  if (commands.empty())
+    return;
+  // Device ns of the first submission corresponds to its host timestamp.
+  const auto &first = commands.front();
+  const int64_t origin_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          origin_.time_since_epoch())
+          .count();
+  const int64_t offset_ns = static_cast<int64_t>(first.host_submit) -
+                            static_cast<int64_t>(first.submit) - origin_ns;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto &cmd : commands) {
+    events_.push_back({cmd.name, category(cmd.kind),
+                       (static_cast<int64_t>(cmd.start) + offset_ns) / 1000.0,
+                       (cmd.end - cmd.start) / 1000.0, 0});
+  }
+}
+
+void Tracer::write(const std::string &path) const {
+  std::ofstream of(path);
+  if (!of.is_open())
+    throw std::runtime_error("Could not open the file at " + path);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  JsonWriter json(of);
+  json.begin_object().key("traceEvents").begin_array();
+
+  // Track names, the device first.
+  std::vector<std::pair<size_t, std::string>> tracks = {{0, "device"}};
+  for (const auto &t : threads_) {
+    tracks.emplace_back(t.second, "host " + std::to_string(t.second));
+  }
+  for (const auto &t : tracks) {
+    json.begin_object()
+        .field("name", "thread_name")
+        .field("ph", "M")
+        .field("pid", size_t(1))
+        .field("tid", t.first);
+    json.key("args").begin_object().field("name", t.second).end_object();
+    json.end_object();
+  }
+
+  for (const auto &e : events_) {
+    json.begin_object()
+        .field("name", e.name)
+        .field("cat", e.category)
+        .field("ph", "X")
+        .field("ts", e.ts_us)
+        .field("dur", e.dur_us)
+        .field("pid", size_t(1))
+        .field("tid", e.tid)
+        .end_object();
+  }
+  json.end_array().end_object();
+  of << "\n";
+}
+
+TraceSpan::TraceSpan(const std::shared_ptr<Tracer> &tracer, std::string name,
+                     std::string category)
+    : tracer_(tracer.get()), name_(std::move(name)),
+      category_(std::move(category)) {
+  if (tracer_)
+    start_ = Tracer::Clock::now();
+}
+
+TraceSpan::~TraceSpan() {
+  if (tracer_)
+    tracer_->span(name_, category_, start_, Tracer::Clock::now());
+}
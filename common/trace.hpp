@@ -0,0 +1,63 @@
+#pragma once
+#include "result.hpp"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Collects a timeline of host spans and device commands of a whole run and
+// writes it in the Chrome trace event format (chrome://tracing, Perfetto).
+// Spans may be recorded from several threads.
+class Tracer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  Tracer();
+
+  // Host span on the calling thread, timestamps from Clock.
+  void span(const std::string &name, const std::string &category,
+            Clock::time_point start, Clock::time_point end);
+  // Device commands of one iteration, placed on the device track. Device
+  // timestamps are aligned to the host clock with the first command.
+  void device_commands(const std::vector<DeviceCommand> &commands);
+
+  void write(const std::string &path) const;
+
+private:
+  struct Event {
+    std::string name;
+    std::string category;
+    double ts_us;
+    double dur_us;
+    size_t tid;
+  };
+
+  double since_origin_us(Clock::time_point t) const;
+  size_t thread_id();
+
+  const Clock::time_point origin_;
+  mutable std::mutex mutex_;
+  std::vector<Event> events_;
+  // Host threads get tracks 1..N, track 0 is the device.
+  std::map<std::thread::id, size_t> threads_;
+};
+
+// Records the enclosing scope as a span, does nothing without a tracer.
+class TraceSpan {
+public:
+  TraceSpan(const std::shared_ptr<Tracer> &tracer, std::string name,
+            std::string category = "phase");
+  ~TraceSpan();
+
+  TraceSpan(const TraceSpan &) = delete;
+  TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+  Tracer *tracer_;
+  std::string name_;
+  std::string category_;
+  Tracer::Clock::time_point start_;
+};
@@ -11,14 +11,12 @@ void _run_constant(const size_t buf_size, Meter &meter) {
 
   using namespace cl::sycl;
 
-  auto sel = get_device_selector(opts);
-
   constexpr int num = 16;
   auto rng = range<1>{num};
 
   buffer<int> src{rng};
 
-  queue q{*sel.get()};
+  queue q = get_queue(opts);
   std::cout << "Selected device: "
             << q.get_device().get_info<info::device::name>() << "\n";
 
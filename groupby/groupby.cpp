@@ -19,101 +19,173 @@ std::vector<uint32_t> expected_GroupBy(const std::vector<uint32_t> &keys,
 }
 } // namespace
 
+template <class Key, class Hash, class Stats> class GroupByBuild;
+template <class Key, class Hash, class Stats> class GroupByCollect;
+
 GroupBy::GroupBy() : Dwarf("GroupBy") {}
 
-void GroupBy::_run(const size_t buf_size, Meter &meter) {
-  constexpr uint32_t empty_element = std::numeric_limits<uint32_t>::max();
+void GroupBy::_run(const size_t buf_size, double load_factor, Meter &meter) {
+  if (meter.opts().key_width == KeyWidth::Bits32) {
+    _run_keys<uint32_t>(buf_size, load_factor, meter);
+  } else {
+    _run_keys<uint64_t>(buf_size, load_factor, meter);
+  }
+}
+
+template <class Key>
+void GroupBy::_run_keys(const size_t buf_size, double load_factor,
+                        Meter &meter) {
+  const auto &opts = static_cast<const GroupByRunOptions &>(meter.opts());
+  // Sized by the groups, the entries of the table, not by the rows.
+  const size_t ht_size = hashed_table_size(
+      opts.hasher, helpers::table_capacity(opts.groups_count, load_factor));
+  const uint64_t seed = helpers::input_seed(opts, "hasher");
+  with_hasher(opts.hasher, ht_size, seed, PolynomialHasher(ht_size, seed),
+              [&](auto hasher) {
+                with_probe_stats(opts.probe_stats, [&](auto stats) {
+                  _run_hashed<Key, decltype(hasher), decltype(stats)>(
+                      buf_size, load_factor, meter, hasher);
+                });
+              });
+}
+
+template <class Key, class Hash, class Stats>
+void GroupBy::_run_hashed(const size_t buf_size, double load_factor,
+                          Meter &meter, Hash hasher) {
+  constexpr Key empty_element = std::numeric_limits<Key>::max();
   auto opts = static_cast<const GroupByRunOptions &>(meter.opts());
+  const KeyWidth key_width = opts.key_width;
 
   const int groups_count = opts.groups_count;
   const std::vector<uint32_t> host_src_vals =
-      helpers::make_random<uint32_t>(buf_size);
-  const std::vector<uint32_t> host_src_keys =
-      helpers::make_random<uint32_t>(buf_size, 0, groups_count - 1);
+      helpers::make_random<uint32_t>(opts, "values", buf_size);
+  const std::vector<uint32_t> host_src_groups =
+      helpers::make_keys<uint32_t>(opts, "keys", buf_size, 0,
+                                   groups_count - 1);
+  // Groups are found by their keys and collected back by id.
+  const std::vector<Key> host_src_keys =
+      helpers::make_keys_of_ids<Key>(opts, host_src_groups);
 
   std::vector<uint32_t> expected =
-      expected_GroupBy(host_src_keys, host_src_vals, groups_count,
+      expected_GroupBy(host_src_groups, host_src_vals, groups_count,
                        [](uint32_t x, uint32_t y) { return x + y; });
 
-  auto sel = get_device_selector(opts);
-  sycl::queue q{*sel};
-  std::cout << "Selected device: "
-            << q.get_device().get_info<sycl::info::device::name>() << "\n";
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
 
-  PolynomialHasher hasher(buf_size);
+  const size_t ht_size = hashed_table_size(
+      opts.hasher, helpers::table_capacity(groups_count, load_factor));
 
-  for (auto it = 0; it < opts.iterations; ++it) {
-    std::vector<uint32_t> data(buf_size, 0);
-    std::vector<uint32_t> keys(buf_size, empty_element);
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  meter.measure(std::move(params), [&]() {
+    std::vector<uint32_t> data(ht_size, 0);
+    std::vector<Key> keys(ht_size, empty_element);
     std::vector<uint32_t> output(groups_count, 0);
 
-    sycl::buffer<uint32_t> data_buf(data);
-    sycl::buffer<uint32_t> keys_buf(keys);
-    sycl::buffer<uint32_t> src_vals(host_src_vals);
-    sycl::buffer<uint32_t> src_keys(host_src_keys);
+    sycl::buffer<uint32_t> data_buf{sycl::range<1>{ht_size}};
+    sycl::buffer<Key> keys_buf{sycl::range<1>{ht_size}};
+    sycl::buffer<uint32_t> src_vals{sycl::range<1>{buf_size}};
+    sycl::buffer<Key> src_keys{sycl::range<1>{buf_size}};
+    sycl::buffer<uint32_t> out_buf{sycl::range<1>{output.size()}};
+    ProbeCounters probes(opts.probe_stats);
 
+    EventProfiler profiler;
+    PerfCounters counters(opts.perf_counters && q.get_device().is_cpu());
+    counters.start();
     auto host_start = std::chrono::steady_clock::now();
-    q.submit([&](sycl::handler &h) {
-       auto sv = src_vals.get_access(h);
-       auto sk = src_keys.get_access(h);
-
-       auto data_acc = data_buf.get_access(h);
-       auto keys_acc = keys_buf.get_access(h);
-
-       h.parallel_for<class hash_build>(buf_size, [=](auto &idx) {
-         NonOwningHashTableNonBitmask<uint32_t, uint32_t, PolynomialHasher> ht(
-             buf_size, keys_acc.get_pointer(), data_acc.get_pointer(), hasher,
-             empty_element);
-
-         ht.add(sk[idx], sv[idx]);
-       });
-     }).wait();
-
-    sycl::buffer<uint32_t> out_buf(output);
-
-    q.submit([&](sycl::handler &h) {
-       auto sv = src_vals.get_access(h);
-       auto sk = src_keys.get_access(h);
-       auto o = out_buf.get_access(h);
-
-       auto data_acc = data_buf.get_access(h);
-       auto keys_acc = keys_buf.get_access(h);
-
-       h.parallel_for<class hash_build_check>(buf_size, [=](auto &idx) {
-         NonOwningHashTableNonBitmask<uint32_t, uint32_t, PolynomialHasher> ht(
-             buf_size, keys_acc.get_pointer(), data_acc.get_pointer(), hasher,
-             empty_element);
-
-         std::pair<uint32_t, bool> sum_for_group = ht.at(sk[idx]);
-         sycl::atomic<uint32_t>(o.get_pointer() + sk[idx])
-             .store(sum_for_group.first);
-       });
-     }).wait();
+    profiler.upload(q, data, data_buf);
+    profiler.upload(q, keys, keys_buf);
+    profiler.upload(q, host_src_vals, src_vals);
+    profiler.upload(q, host_src_keys, src_keys);
+    sycl::event build = q.submit([&](sycl::handler &h) {
+      auto sv = src_vals.get_access(h);
+      auto sk = src_keys.get_access(h);
+
+      auto data_acc = data_buf.get_access(h);
+      auto keys_acc = keys_buf.get_access(h);
+      auto probes_acc = probes.access<Stats>(h);
+
+      h.parallel_for<GroupByBuild<Key, Hash, Stats>>(buf_size, [=](auto &idx) {
+        NonOwningHashTableNonBitmask<Key, uint32_t, Hash, Stats> ht(
+            ht_size, keys_acc.get_pointer(), data_acc.get_pointer(), hasher,
+            empty_element, Stats(probes_acc.get_pointer()));
+
+        ht.add(sk[idx], sv[idx]);
+      });
+    });
+    profiler.kernel(build, "groupby_build").wait();
+    auto build_end = std::chrono::steady_clock::now();
+
+    profiler.upload(q, output, out_buf);
+    sycl::event collect = q.submit([&](sycl::handler &h) {
+      auto sv = src_vals.get_access(h);
+      auto sk = src_keys.get_access(h);
+      auto o = out_buf.get_access(h);
+
+      auto data_acc = data_buf.get_access(h);
+      auto keys_acc = keys_buf.get_access(h);
+      auto probes_acc = probes.access<Stats>(h);
+
+      h.parallel_for<GroupByCollect<Key, Hash, Stats>>(
+          buf_size, [=](auto &idx) {
+            NonOwningHashTableNonBitmask<Key, uint32_t, Hash, Stats> ht(
+                ht_size, keys_acc.get_pointer(), data_acc.get_pointer(),
+                hasher, empty_element, Stats(probes_acc.get_pointer()));
+
+            std::pair<uint32_t, bool> sum_for_group = ht.at(sk[idx]);
+            sycl::atomic<uint32_t>(o.get_pointer() +
+                                   key_id(key_width, sk[idx]))
+                .store(sum_for_group.first);
+          });
+    });
+    profiler.kernel(collect, "groupby_collect");
+    profiler.download(q, out_buf, output).wait();
     auto host_end = std::chrono::steady_clock::now();
+    counters.stop();
     auto host_exe_time = std::chrono::duration_cast<std::chrono::microseconds>(
                              host_end - host_start)
                              .count();
     std::unique_ptr<Result> result = std::make_unique<Result>();
     result->host_time = host_end - host_start;
-    out_buf.get_access<sycl::access::mode::read>();
+    profiler.fill(*result);
+    counters.fill(*result);
+    probes.fill(*result);
+    if (opts.tracer) {
+      opts.tracer->span("build", "phase", host_start, build_end);
+      opts.tracer->span("collect", "phase", build_end, host_end);
+    }
+    result->rows = buf_size;
+    result->bytes_read = buf_size * (sizeof(Key) + sizeof(uint32_t));
+    result->bytes_written = groups_count * sizeof(uint32_t);
+    result->table_bytes = ht_size * (sizeof(Key) + sizeof(uint32_t));
 
+    TraceSpan check(opts.tracer, "check");
     if (output != expected) {
       std::cerr << "Incorrect results" << std::endl;
       result->valid = false;
     }
 
-    DwarfParams params{{"buf_size", std::to_string(buf_size)}};
-    meter.add_result(std::move(params), std::move(result));
-  }
+    return result;
+  });
 }
 
 void GroupBy::run(const RunOptions &opts) {
   for (auto size : opts.input_size) {
-    _run(size, meter());
+    for (double load_factor : helpers::load_factors(opts, 0.5)) {
+      _run(size, load_factor, meter());
+    }
   }
 }
 void GroupBy::init(const RunOptions &opts) {
   meter().set_opts(opts);
-  DwarfParams params = {{"device_type", to_string(opts.device_ty)}};
+  const auto &gb_opts = static_cast<const GroupByRunOptions &>(opts);
+  DwarfParams params = {{"device_type", to_string(opts.device_ty)},
+                        {"distribution", to_string(opts.distribution)},
+                        {"groups_count", std::to_string(gb_opts.groups_count)},
+                        {"key_width", to_string(opts.key_width)},
+                        {"hasher", to_string(opts.hasher)}};
+  if (opts.probe_stats)
+    params["probe_stats"] = "true";
   meter().set_params(params);
 }
\ No newline at end of file
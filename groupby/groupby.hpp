@@ -8,5 +8,10 @@ public:
   void init(const RunOptions &opts) override;
 
 private:
-  void _run(const size_t buffer_size, Meter &meter);
+  void _run(const size_t buffer_size, double load_factor, Meter &meter);
+  template <class Key>
+  void _run_keys(const size_t buffer_size, double load_factor, Meter &meter);
+  template <class Key, class Hash, class Stats>
+  void _run_hashed(const size_t buffer_size, double load_factor, Meter &meter,
+                   Hash hasher);
 };
\ No newline at end of file
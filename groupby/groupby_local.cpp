@@ -21,119 +21,151 @@ std::vector<uint32_t> expected_GroupBy(const std::vector<uint32_t> &keys,
 
 GroupByLocal::GroupByLocal() : Dwarf("GroupByLocal") {}
 
-void GroupByLocal::_run(const size_t buf_size, Meter &meter) {
+void GroupByLocal::_run(const size_t buf_size, double load_factor,
+                        Meter &meter) {
   constexpr uint32_t empty_element = std::numeric_limits<uint32_t>::max();
   auto opts = static_cast<const GroupByRunOptions &>(meter.opts());
 
   const int groups_count = opts.groups_count;
   const int executors = opts.executors;
+  // Slots of the table of each executor.
+  const size_t local_size = helpers::table_capacity(groups_count, load_factor);
   const std::vector<uint32_t> host_src_vals =
-      helpers::make_random<uint32_t>(buf_size);
+      helpers::make_random<uint32_t>(opts, "values", buf_size);
   const std::vector<uint32_t> host_src_keys =
-      helpers::make_random<uint32_t>(buf_size, 0, groups_count - 1);
+      helpers::make_keys<uint32_t>(opts, "keys", buf_size, 0,
+                                   groups_count - 1);
 
   std::vector<uint32_t> expected =
       expected_GroupBy(host_src_keys, host_src_vals, groups_count,
                        [](uint32_t x, uint32_t y) { return x + y; });
 
-  auto sel = get_device_selector(opts);
-  sycl::queue q{*sel};
-  std::cout << "Selected device: "
-            << q.get_device().get_info<sycl::info::device::name>() << "\n";
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
 
-  SimpleHasher<uint32_t> hasher(groups_count);
+  SimpleHasher<uint32_t> hasher(local_size);
 
-  for (auto it = 0; it < opts.iterations; ++it) {
-    std::vector<uint32_t> data(groups_count * executors, 0);
-    std::vector<uint32_t> keys(groups_count * executors, empty_element);
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  meter.measure(std::move(params), [&]() {
+    std::vector<uint32_t> data(local_size * executors, 0);
+    std::vector<uint32_t> keys(local_size * executors, empty_element);
     std::vector<uint32_t> output(groups_count, 0);
 
-    sycl::buffer<uint32_t> data_buf(data);
-    sycl::buffer<uint32_t> keys_buf(keys);
-    sycl::buffer<uint32_t> src_vals(host_src_vals);
-    sycl::buffer<uint32_t> src_keys(host_src_keys);
-    sycl::buffer<uint32_t> out_buf(output);
+    sycl::buffer<uint32_t> data_buf{sycl::range<1>{data.size()}};
+    sycl::buffer<uint32_t> keys_buf{sycl::range<1>{keys.size()}};
+    sycl::buffer<uint32_t> src_vals{sycl::range<1>{buf_size}};
+    sycl::buffer<uint32_t> src_keys{sycl::range<1>{buf_size}};
+    sycl::buffer<uint32_t> out_buf{sycl::range<1>{output.size()}};
 
+    EventProfiler profiler;
+    PerfCounters counters(opts.perf_counters && q.get_device().is_cpu());
+    counters.start();
     auto host_start = std::chrono::steady_clock::now();
-    q.submit([&](sycl::handler &h) {
-       auto sv = src_vals.get_access(h);
-       auto sk = src_keys.get_access(h);
-
-       auto data_acc = data_buf.get_access(h);
-       auto keys_acc = keys_buf.get_access(h);
-
-       const size_t work_per_executor = buf_size / executors;
-
-       h.parallel_for<class groupby_local_hash_build>(
-           executors, [=](auto &idx) {
-             size_t hash_table_ptr_offset = (idx * groups_count);
-             auto executor_keys_ptr =
-                 keys_acc.get_pointer() + hash_table_ptr_offset;
-             auto executor_vals_ptr =
-                 data_acc.get_pointer() + hash_table_ptr_offset;
-
-             LinearHashtable<uint32_t, uint32_t, SimpleHasher<uint32_t>> ht(
-                 groups_count, executor_keys_ptr, executor_vals_ptr, hasher,
-                 empty_element);
-
-             for (size_t i = work_per_executor * idx;
-                  i < work_per_executor * (idx + 1); i++)
-               ht.add(sk[i], sv[i]);
-           });
-     }).wait();
-
-    q.submit([&](sycl::handler &h) {
-       auto sv = src_vals.get_access(h);
-       auto sk = src_keys.get_access(h);
-
-       auto data_acc = data_buf.get_access(h);
-       auto keys_acc = keys_buf.get_access(h);
-
-       auto o = out_buf.get_access(h);
-
-       h.single_task<class groupby_local_collect>([=]() {
-         for (int idx = 0; idx < executors; idx++) {
-           size_t hash_table_ptr_offset = (idx * groups_count);
-           auto executor_keys_ptr =
-               keys_acc.get_pointer() + hash_table_ptr_offset;
-           auto executor_vals_ptr =
-               data_acc.get_pointer() + hash_table_ptr_offset;
-
-           LinearHashtable<uint32_t, uint32_t, SimpleHasher<uint32_t>> ht(
-               groups_count, executor_keys_ptr, executor_vals_ptr, hasher,
-               empty_element);
-
-           for (int j = 0; j < groups_count; j++)
-             o[j] += ht.at(j).first;
-         }
-       });
-     }).wait();
+    profiler.upload(q, data, data_buf);
+    profiler.upload(q, keys, keys_buf);
+    profiler.upload(q, host_src_vals, src_vals);
+    profiler.upload(q, host_src_keys, src_keys);
+    profiler.upload(q, output, out_buf);
+    sycl::event build = q.submit([&](sycl::handler &h) {
+      auto sv = src_vals.get_access(h);
+      auto sk = src_keys.get_access(h);
+
+      auto data_acc = data_buf.get_access(h);
+      auto keys_acc = keys_buf.get_access(h);
+
+      const size_t work_per_executor = buf_size / executors;
+
+      h.parallel_for<class groupby_local_hash_build>(
+          executors, [=](auto &idx) {
+            size_t hash_table_ptr_offset = (idx * local_size);
+            auto executor_keys_ptr =
+                keys_acc.get_pointer() + hash_table_ptr_offset;
+            auto executor_vals_ptr =
+                data_acc.get_pointer() + hash_table_ptr_offset;
+
+            LinearHashtable<uint32_t, uint32_t, SimpleHasher<uint32_t>> ht(
+                local_size, executor_keys_ptr, executor_vals_ptr, hasher,
+                empty_element);
+
+            for (size_t i = work_per_executor * idx;
+                 i < work_per_executor * (idx + 1); i++)
+              ht.add(sk[i], sv[i]);
+          });
+    });
+    profiler.kernel(build, "groupby_local_build").wait();
+    auto build_end = std::chrono::steady_clock::now();
+
+    sycl::event collect = q.submit([&](sycl::handler &h) {
+      auto sv = src_vals.get_access(h);
+      auto sk = src_keys.get_access(h);
+
+      auto data_acc = data_buf.get_access(h);
+      auto keys_acc = keys_buf.get_access(h);
+
+      auto o = out_buf.get_access(h);
+
+      h.single_task<class groupby_local_collect>([=]() {
+        for (int idx = 0; idx < executors; idx++) {
+          size_t hash_table_ptr_offset = (idx * local_size);
+          auto executor_keys_ptr =
+              keys_acc.get_pointer() + hash_table_ptr_offset;
+          auto executor_vals_ptr =
+              data_acc.get_pointer() + hash_table_ptr_offset;
+
+          LinearHashtable<uint32_t, uint32_t, SimpleHasher<uint32_t>> ht(
+              local_size, executor_keys_ptr, executor_vals_ptr, hasher,
+              empty_element);
+
+          for (int j = 0; j < groups_count; j++)
+            o[j] += ht.at(j).first;
+        }
+      });
+    });
+    profiler.kernel(collect, "groupby_local_collect");
+    profiler.download(q, out_buf, output).wait();
 
     auto host_end = std::chrono::steady_clock::now();
+    counters.stop();
     auto host_exe_time = std::chrono::duration_cast<std::chrono::microseconds>(
                              host_end - host_start)
                              .count();
     std::unique_ptr<Result> result = std::make_unique<Result>();
     result->host_time = host_end - host_start;
-    out_buf.get_access<sycl::access::mode::read>();
+    profiler.fill(*result);
+    counters.fill(*result);
+    if (opts.tracer) {
+      opts.tracer->span("build", "phase", host_start, build_end);
+      opts.tracer->span("collect", "phase", build_end, host_end);
+    }
+    result->rows = buf_size;
+    result->bytes_read = 2 * buf_size * sizeof(uint32_t);
+    result->bytes_written = groups_count * sizeof(uint32_t);
+    result->table_bytes = 2 * local_size * executors * sizeof(uint32_t);
 
+    TraceSpan check(opts.tracer, "check");
     if (output != expected) {
       std::cerr << "Incorrect results" << std::endl;
       result->valid = false;
     }
 
-    DwarfParams params{{"buf_size", std::to_string(buf_size)}};
-    meter.add_result(std::move(params), std::move(result));
-  }
+    return result;
+  });
 }
 
 void GroupByLocal::run(const RunOptions &opts) {
   for (auto size : opts.input_size) {
-    _run(size, meter());
+    for (double load_factor : helpers::load_factors(opts, 1)) {
+      _run(size, load_factor, meter());
+    }
   }
 }
 void GroupByLocal::init(const RunOptions &opts) {
   meter().set_opts(opts);
-  DwarfParams params = {{"device_type", to_string(opts.device_ty)}};
+  const auto &gb_opts = static_cast<const GroupByRunOptions &>(opts);
+  DwarfParams params = {{"device_type", to_string(opts.device_ty)},
+                        {"distribution", to_string(opts.distribution)},
+                        {"groups_count", std::to_string(gb_opts.groups_count)},
+                        {"executors", std::to_string(gb_opts.executors)}};
   meter().set_params(params);
 }
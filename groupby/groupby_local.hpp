@@ -8,5 +8,5 @@ public:
   void init(const RunOptions &opts) override;
 
 private:
-  void _run(const size_t buffer_size, Meter &meter);
+  void _run(const size_t buffer_size, double load_factor, Meter &meter);
 };
@@ -0,0 +1,133 @@
+#include "bucket_hash_build.hpp"
+
+#include "common/dpcpp/bucket_hashtable.hpp"
+#include <limits>
+
+class BucketBuild;
+class BucketBuildCheck;
+
+BucketHashBuild::BucketHashBuild() : Dwarf("BucketHashBuild") {}
+void BucketHashBuild::_run(const size_t buf_size, double load_factor,
+                           Meter &meter) {
+  auto opts = meter.opts();
+  const Column<uint32_t> host_src =
+      helpers::input_column<uint32_t>(opts, "keys", buf_size, [&] {
+        return helpers::make_keys<uint32_t>(opts, "keys", buf_size, 1, 10000);
+      });
+  const uint32_t empty_element = std::numeric_limits<uint32_t>::max();
+
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
+
+  using Table =
+      BucketizedHashTable<uint32_t, uint32_t, SimpleHasher<uint32_t>>;
+  // Vector compares on CPUs, sub-groups on other devices.
+  const bool cooperative = !q.get_device().is_cpu();
+  const size_t buckets =
+      BucketHash::buckets_count(buf_size, Table::bucket_size, load_factor);
+  const size_t ht_size = buckets * Table::bucket_size;
+  SimpleHasher<uint32_t> hasher(buckets);
+
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  params["probing"] = cooperative ? "sub_group" : "vector";
+  meter.measure(std::move(params), [&]() {
+    std::vector<uint32_t> data(ht_size, 0);
+    std::vector<uint32_t> keys(ht_size, empty_element);
+    std::vector<uint32_t> output(buf_size, 0);
+    std::vector<uint32_t> expected(buf_size, 1);
+
+    sycl::buffer<uint32_t> data_buf{sycl::range<1>{ht_size}};
+    sycl::buffer<uint32_t> keys_buf{sycl::range<1>{ht_size}};
+    sycl::buffer<uint32_t> src{sycl::range<1>{buf_size}};
+
+    EventProfiler profiler;
+    PerfCounters counters(opts.perf_counters && q.get_device().is_cpu());
+    counters.start();
+    auto host_start = std::chrono::steady_clock::now();
+    profiler.upload(q, data, data_buf);
+    profiler.upload(q, keys, keys_buf);
+    profiler.upload(q, host_src, src);
+    sycl::event build = q.submit([&](sycl::handler &h) {
+      auto s = src.get_access(h);
+      auto data_acc = data_buf.get_access(h);
+      auto keys_acc = keys_buf.get_access(h);
+
+      BucketHash::parallel_for<BucketBuild>(
+          h, buf_size, cooperative,
+          [=](sycl::nd_item<1> it, auto cooperative) {
+            const size_t idx = BucketHash::key_index(it, cooperative);
+            if (idx >= buf_size)
+              return;
+            Table ht(buckets, keys_acc.get_pointer(), data_acc.get_pointer(),
+                     hasher, empty_element);
+
+            if constexpr (decltype(cooperative)::value) {
+              ht.insert(it.get_sub_group(), s[idx], s[idx]);
+            } else {
+              ht.insert(s[idx], s[idx]);
+            }
+          });
+    });
+    profiler.kernel(build, "hash_build").wait();
+
+    auto host_end = std::chrono::steady_clock::now();
+    counters.stop();
+    std::unique_ptr<Result> result = std::make_unique<Result>();
+    result->host_time = host_end - host_start;
+    profiler.fill(*result);
+    counters.fill(*result);
+    result->rows = buf_size;
+    result->bytes_read = buf_size * sizeof(uint32_t);
+    result->bytes_written = 2 * buf_size * sizeof(uint32_t);
+    result->table_bytes = 2 * ht_size * sizeof(uint32_t);
+
+    TraceSpan check(opts.tracer, "check");
+    sycl::buffer<uint32_t> out_buf(output);
+
+    q.submit([&](sycl::handler &h) {
+       auto s = src.get_access(h);
+       auto o = out_buf.get_access(h);
+       auto data_acc = data_buf.get_access(h);
+       auto keys_acc = keys_buf.get_access(h);
+
+       BucketHash::parallel_for<BucketBuildCheck>(
+           h, buf_size, cooperative,
+           [=](sycl::nd_item<1> it, auto cooperative) {
+             const size_t idx = BucketHash::key_index(it, cooperative);
+             if (idx >= buf_size)
+               return;
+             Table ht(buckets, keys_acc.get_pointer(), data_acc.get_pointer(),
+                      hasher, empty_element);
+
+             if constexpr (decltype(cooperative)::value) {
+               o[idx] = ht.has(it.get_sub_group(), s[idx]);
+             } else {
+               o[idx] = ht.has(s[idx]);
+             }
+           });
+     }).wait();
+
+    out_buf.get_access<sycl::access::mode::read>();
+    if (output != expected) {
+      std::cerr << "Incorrect results" << std::endl;
+      result->valid = false;
+    }
+
+    return result;
+  });
+}
+
+void BucketHashBuild::run(const RunOptions &opts) {
+  for (auto size : opts.input_size) {
+    for (double load_factor : helpers::load_factors(opts, 0.5)) {
+      _run(size, load_factor, meter());
+    }
+  }
+}
+void BucketHashBuild::init(const RunOptions &opts) {
+  meter().set_opts(opts);
+  DwarfParams params = {{"device_type", to_string(opts.device_ty)},
+                        {"distribution", to_string(opts.distribution)}};
+  meter().set_params(params);
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include "common/common.hpp"
+
+class BucketHashBuild : public Dwarf {
+public:
+  BucketHashBuild();
+  void run(const RunOptions &opts) override;
+  void init(const RunOptions &opts) override;
+
+private:
+  void _run(const size_t buffer_size, double load_factor, Meter &meter);
+};
@@ -1,114 +1,172 @@
 #include "cuckoo_hash_build.hpp"
 #include "common/dpcpp/cuckoo_hashtable.hpp"
 
+template <class Stats> class CuckooClearTable;
+template <class Stats> class CuckooBuild;
+template <class Stats> class CuckooRetry;
+template <class Stats> class CuckooBuildCheck;
+
 CuckooHashBuild::CuckooHashBuild() : Dwarf("CuckooHashBuild") {}
-const uint32_t EMPTY_KEY = std::numeric_limits<uint32_t>::max();
-const uint32_t WORKGROUP_SIZE = 1;
-const uint32_t SCALE = 2;
 
-void CuckooHashBuild::_run(const size_t buf_size, Meter &meter) {
+namespace {
+using Hasher = MurmurHash3_x86_32;
+template <class Stats>
+using Table = BucketizedCuckooHashtable<Hasher, Hasher, Stats>;
+
+// Insert passes of one build: the first inserts all keys and every next one
+// only the entries the previous pass failed to insert. A pass that fails on
+// all its entries rebuilds the table with new hash functions.
+constexpr size_t MAX_PASSES = 32;
+
+// Entries that a pass failed to insert are appended to `failed`, and their
+// number is counted in `failures`, which the host reads back.
+template <class HashTable>
+void insert_or_collect(HashTable &ht, uint64_t entry,
+                       sycl::global_ptr<uint64_t> failed,
+                       sycl::global_ptr<uint32_t> failures) {
+  if (!ht.insert(entry))
+    failed[sycl::atomic<uint32_t>(failures).fetch_add(1)] = entry;
+}
+} // namespace
+
+void CuckooHashBuild::_run(const size_t buf_size, double load_factor,
+                           Meter &meter) {
+  with_probe_stats(meter.opts().probe_stats, [&](auto stats) {
+    _run_stats<decltype(stats)>(buf_size, load_factor, meter);
+  });
+}
+
+template <class Stats>
+void CuckooHashBuild::_run_stats(const size_t buf_size, double load_factor,
+                                 Meter &meter) {
   auto opts = meter.opts();
 
-  const std::vector<uint32_t> host_src = helpers::make_unique_random(buf_size);
+  const Column<uint32_t> host_src =
+      helpers::input_column<uint32_t>(opts, "keys", buf_size, [&] {
+        return helpers::make_unique_random(opts, "keys", buf_size);
+      });
 
-  const size_t ht_size = buf_size * 4;
+  const size_t bucket_size = Table<Stats>::bucket_size;
+  const size_t buckets =
+      (helpers::table_capacity(buf_size, load_factor) + bucket_size - 1) /
+      bucket_size;
+  const size_t slots = Table<Stats>::slots_count(buckets);
 
-  auto sel = get_device_selector(opts);
-  sycl::queue q{*sel};
-  std::cout << "Selected device: "
-            << q.get_device().get_info<sycl::info::device::name>() << "\n";
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
 
-  for (auto it = 0; it < opts.iterations; ++it) {
+  // The hashers of every rebuild pass are seeded from --seed, so that the
+  // table layout, evictions and passes are reproduced by it.
+  const uint64_t seed = helpers::input_seed(opts, "hasher");
+  auto make_hasher = [&](size_t pass, size_t i) {
+    return Hasher(buckets, uint32_t(seed + 2 * pass + i));
+  };
 
-    MurmurHash3_x86_32 hasher1(ht_size, sizeof(uint32_t),
-                               helpers::make_random()),
-        hasher2(ht_size, sizeof(uint32_t), helpers::make_random());
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  meter.measure(std::move(params), [&]() {
+    Hasher hasher1 = make_hasher(0, 0);
+    Hasher hasher2 = make_hasher(0, 1);
 
     std::vector<uint32_t> output(buf_size, 0);
     std::vector<uint32_t> expected(buf_size, 1);
-
-    size_t bitmask_sz = (ht_size / 32) ? (ht_size / 32) : 1;
-    std::vector<uint32_t> bitmask(bitmask_sz, 0);
-    std::vector<uint32_t> keys(ht_size, EMPTY_KEY);
-    std::vector<uint32_t> vals(ht_size, 0);
-
-    sycl::buffer<uint32_t> bitmask_buf(bitmask);
-    sycl::buffer<uint32_t> vals_buf(vals);
-    sycl::buffer<uint32_t> keys_buf(keys);
-    sycl::buffer<uint32_t> src(host_src);
-    sycl::buffer<bool, 1> insertion_result_buf{sycl::range{buf_size}};
-
+    std::vector<uint32_t> failures(MAX_PASSES, 0);
+
+    sycl::buffer<uint64_t> table_buf{sycl::range<1>{slots}};
+    sycl::buffer<uint32_t> src{sycl::range<1>{buf_size}};
+    // Failed entries of even and odd passes, so that a pass retries the
+    // ones of the pass before it.
+    sycl::buffer<uint64_t> failed_even{sycl::range<1>{buf_size}};
+    sycl::buffer<uint64_t> failed_odd{sycl::range<1>{buf_size}};
+    sycl::buffer<uint32_t> failures_buf{sycl::range<1>{MAX_PASSES}};
+    // Counts the inserts of all passes, failed ones included.
+    ProbeCounters probes(opts.probe_stats);
+
+    EventProfiler profiler;
     auto host_start = std::chrono::steady_clock::now();
-
-    while (true) {
-      uint32_t hasher1_offset = helpers::make_random();
-      uint32_t hasher2_offset = helpers::make_random();
-
-      hasher1 = MurmurHash3_x86_32(ht_size, sizeof(uint32_t), hasher1_offset);
-      hasher2 = MurmurHash3_x86_32(ht_size, sizeof(uint32_t), hasher2_offset);
-
-      auto clear_keys = q.submit([&](sycl::handler &h) {
-        auto keys_acc = keys_buf.get_access(h);
-        auto bitmask_acc = bitmask_buf.get_access(h);
-
-        h.parallel_for<class clear_keys>(
-            ht_size, [=](auto &idx) { keys_acc[idx] = EMPTY_KEY; });
-      });
-
-      q.submit([&](sycl::handler &h) {
-         h.depends_on(clear_keys);
-         auto s = src.get_access(h);
-         auto bitmask_acc = bitmask_buf.get_access(h);
-         auto keys_acc = keys_buf.get_access(h);
-         auto vals_acc = vals_buf.get_access(h);
-         auto insertion_acc = insertion_result_buf.get_access(h);
-
-         h.parallel_for<class hash_build>(
-             sycl::nd_range<1>{buf_size, WORKGROUP_SIZE},
-             [=](sycl::nd_item<1> it) {
-               CuckooHashtable<uint32_t, uint32_t, MurmurHash3_x86_32,
-                               MurmurHash3_x86_32>
-                   ht(buf_size, keys_acc.get_pointer(), vals_acc.get_pointer(),
-                      bitmask_acc.get_pointer(), hasher1, hasher2);
-
-               size_t idx = it.get_global_id();
-               if (idx % 2 == 0) {
-                 for (int i = idx; i < idx + SCALE && i < buf_size; i++)
-                   insertion_acc[i] = ht.insert(s[i], s[i]);
-               }
-             });
-       }).wait();
-
-      auto result = insertion_result_buf.get_access<sycl::access::mode::read>();
-
-      bool flag = false;
-      for (int i = 0; i < buf_size; i++) {
-        if (result[i] == false) {
-          flag = true;
-          break;
+    profiler.upload(q, host_src, src);
+    profiler.upload(q, failures, failures_buf);
+
+    bool rebuild = true;
+    size_t pending = buf_size;
+    for (size_t pass = 0; pass < MAX_PASSES; ++pass) {
+      sycl::buffer<uint64_t> &failed = pass % 2 ? failed_odd : failed_even;
+      sycl::buffer<uint64_t> &retried = pass % 2 ? failed_even : failed_odd;
+      sycl::event insert;
+      if (rebuild) {
+        if (pass > 0) {
+          hasher1 = make_hasher(pass, 0);
+          hasher2 = make_hasher(pass, 1);
         }
+        sycl::event clear = q.submit([&](sycl::handler &h) {
+          auto table_acc =
+              table_buf.get_access<sycl::access::mode::discard_write>(h);
+          h.parallel_for<CuckooClearTable<Stats>>(slots, [=](auto &idx) {
+            table_acc[idx] = Table<Stats>::empty_entry;
+          });
+        });
+        profiler.kernel(clear, "clear_table");
+
+        insert = q.submit([&](sycl::handler &h) {
+          auto s = src.get_access(h);
+          auto table_acc = table_buf.get_access(h);
+          auto failed_acc = failed.get_access(h);
+          auto failures_acc = failures_buf.get_access(h);
+          auto probes_acc = probes.access<Stats>(h);
+
+          h.parallel_for<CuckooBuild<Stats>>(buf_size, [=](auto &idx) {
+            Table<Stats> ht(buckets, table_acc.get_pointer(), hasher1,
+                            hasher2, Stats(probes_acc.get_pointer()));
+            insert_or_collect(ht, Table<Stats>::pack(s[idx], s[idx]),
+                              failed_acc.get_pointer(),
+                              failures_acc.get_pointer() + pass);
+          });
+        });
+        profiler.kernel(insert, "hash_build");
+      } else {
+        insert = q.submit([&](sycl::handler &h) {
+          auto r = retried.get_access(h);
+          auto table_acc = table_buf.get_access(h);
+          auto failed_acc = failed.get_access(h);
+          auto failures_acc = failures_buf.get_access(h);
+          auto probes_acc = probes.access<Stats>(h);
+
+          h.parallel_for<CuckooRetry<Stats>>(pending, [=](auto &idx) {
+            Table<Stats> ht(buckets, table_acc.get_pointer(), hasher1,
+                            hasher2, Stats(probes_acc.get_pointer()));
+            insert_or_collect(ht, r[idx], failed_acc.get_pointer(),
+                              failures_acc.get_pointer() + pass);
+          });
+        });
+        profiler.kernel(insert, "retry_failed");
       }
-      if (!flag)
+      // Reads back only the failure counters instead of a flag per key.
+      profiler.download(q, failures_buf, failures).wait();
+
+      const size_t failed_count = failures[pass];
+      if (failed_count == 0)
         break;
+      rebuild = failed_count == pending;
+      pending = rebuild ? buf_size : failed_count;
     }
     auto host_end = std::chrono::steady_clock::now();
-    auto host_exe_time = std::chrono::duration_cast<std::chrono::microseconds>(
-                             host_end - host_start)
-                             .count();
     std::unique_ptr<Result> result = std::make_unique<Result>();
     result->host_time = host_end - host_start;
+    profiler.fill(*result);
+    probes.fill(*result);
+    result->rows = buf_size;
+    result->bytes_read = buf_size * sizeof(uint32_t);
+    result->bytes_written = buf_size * sizeof(uint64_t);
+    result->table_bytes = slots * sizeof(uint64_t);
+    TraceSpan check(opts.tracer, "check");
     sycl::buffer<uint32_t> out_buf(output);
     q.submit([&](sycl::handler &h) {
        auto s = src.get_access(h);
        auto o = out_buf.get_access(h);
-       auto bitmask_acc = bitmask_buf.get_access(h);
-       auto vals_acc = vals_buf.get_access(h);
-       auto keys_acc = keys_buf.get_access(h);
-       h.parallel_for<class hash_build_check>(buf_size, [=](auto &idx) {
-         CuckooHashtable<uint32_t, uint32_t, MurmurHash3_x86_32,
-                         MurmurHash3_x86_32>
-             ht(buf_size, keys_acc.get_pointer(), vals_acc.get_pointer(),
-                bitmask_acc.get_pointer(), hasher1, hasher2);
+       auto table_acc = table_buf.get_access(h);
+       h.parallel_for<CuckooBuildCheck<Stats>>(buf_size, [=](auto &idx) {
+         Table<NoProbeStats> ht(buckets, table_acc.get_pointer(), hasher1,
+                                hasher2);
          o[idx] = ht.has(s[idx]);
        });
      }).wait();
@@ -117,18 +175,21 @@ void CuckooHashBuild::_run(const size_t buf_size, Meter &meter) {
       std::cerr << "Incorrect results" << std::endl;
       result->valid = false;
     }
-    DwarfParams params{{"buf_size", std::to_string(buf_size)}};
-    meter.add_result(std::move(params), std::move(result));
-  }
+    return result;
+  });
 }
 
 void CuckooHashBuild::run(const RunOptions &opts) {
   for (auto size : opts.input_size) {
-    _run(size, meter());
+    for (double load_factor : helpers::load_factors(opts, 0.5, 0.95)) {
+      _run(size, load_factor, meter());
+    }
   }
 }
 void CuckooHashBuild::init(const RunOptions &opts) {
   meter().set_opts(opts);
   DwarfParams params = {{"device_type", to_string(opts.device_ty)}};
+  if (opts.probe_stats)
+    params["probe_stats"] = "true";
   meter().set_params(params);
 }
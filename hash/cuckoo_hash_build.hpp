@@ -8,5 +8,7 @@ public:
   void init(const RunOptions &opts) override;
 
 private:
-  void _run(const size_t buffer_size, Meter &meter);
+  void _run(const size_t buffer_size, double load_factor, Meter &meter);
+  template <class Stats>
+  void _run_stats(const size_t buffer_size, double load_factor, Meter &meter);
 };
\ No newline at end of file
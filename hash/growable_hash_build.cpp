@@ -0,0 +1,107 @@
+#include "growable_hash_build.hpp"
+#include "common/dpcpp/growable_hashtable.hpp"
+#include <unordered_map>
+
+namespace {
+// Slots of the table before the first row, far fewer than any input.
+constexpr size_t INITIAL_CAPACITY = 1024;
+
+// Count of every row's key in the input.
+std::vector<uint32_t> expected_counts(const Column<uint32_t> &keys,
+                                      size_t &distinct) {
+  std::unordered_map<uint32_t, uint32_t> counts;
+  for (uint32_t key : keys) {
+    ++counts[key];
+  }
+  distinct = counts.size();
+  std::vector<uint32_t> out(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    out[i] = counts[keys[i]];
+  }
+  return out;
+}
+} // namespace
+
+GrowableHashBuild::GrowableHashBuild() : Dwarf("GrowableHashBuild") {}
+
+void GrowableHashBuild::_run(const size_t buf_size, double load_factor,
+                             Meter &meter) {
+  using Table = GrowableHashTable<uint32_t, uint32_t, Hashes::Fibonacci>;
+  auto opts = meter.opts();
+  // Keys over as many values as rows, so the number of distinct ones follows
+  // the distribution.
+  const Column<uint32_t> host_src =
+      helpers::input_column<uint32_t>(opts, "keys", buf_size, [&] {
+        return helpers::make_keys<uint32_t>(opts, "keys", buf_size, 1,
+                                            std::max<size_t>(buf_size, 1));
+      });
+  const std::vector<uint32_t> ones(buf_size, 1);
+  size_t distinct = 0;
+  const std::vector<uint32_t> expected = expected_counts(host_src, distinct);
+
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
+
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  meter.measure(std::move(params), [&]() {
+    uint32_t *keys = sycl::malloc_device<uint32_t>(buf_size, q);
+    uint32_t *vals = sycl::malloc_device<uint32_t>(buf_size, q);
+    Table ht(q, INITIAL_CAPACITY, load_factor);
+    std::vector<uint32_t> output(buf_size, 0);
+
+    EventProfiler profiler;
+    auto host_start = std::chrono::steady_clock::now();
+    profiler.h2d(q.memcpy(keys, host_src.data(), buf_size * sizeof(uint32_t)));
+    profiler.h2d(q.memcpy(vals, ones.data(), buf_size * sizeof(uint32_t)));
+    q.wait();
+    ht.add(keys, vals, buf_size, &profiler);
+
+    auto host_end = std::chrono::steady_clock::now();
+    std::unique_ptr<Result> result = std::make_unique<Result>();
+    result->host_time = host_end - host_start;
+    profiler.fill(*result);
+    result->rows = buf_size;
+    result->bytes_read = 2 * buf_size * sizeof(uint32_t);
+    result->bytes_written = 2 * distinct * sizeof(uint32_t);
+    result->table_bytes = ht.bytes();
+    result->rehashes = ht.rehashes();
+
+    TraceSpan check(opts.tracer, "check");
+    {
+      sycl::buffer<uint32_t> out_buf(output);
+      const Table::View view = ht.view();
+      q.submit([&](sycl::handler &h) {
+         auto o = out_buf.get_access(h);
+
+         h.parallel_for<class growable_hash_build_check>(
+             buf_size,
+             [=](sycl::id<1> i) { o[i] = view.at(keys[i[0]]).first; });
+       }).wait();
+    }
+
+    if (ht.size() != distinct || output != expected) {
+      std::cerr << "Incorrect results" << std::endl;
+      result->valid = false;
+    }
+    sycl::free(keys, q);
+    sycl::free(vals, q);
+
+    return result;
+  });
+}
+
+void GrowableHashBuild::run(const RunOptions &opts) {
+  for (auto size : opts.input_size) {
+    for (double load_factor : helpers::load_factors(opts, 0.5, 0.95)) {
+      _run(size, load_factor, meter());
+    }
+  }
+}
+
+void GrowableHashBuild::init(const RunOptions &opts) {
+  meter().set_opts(opts);
+  DwarfParams params = {{"device_type", to_string(opts.device_ty)},
+                        {"distribution", to_string(opts.distribution)}};
+  meter().set_params(params);
+}
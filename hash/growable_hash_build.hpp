@@ -0,0 +1,14 @@
+#pragma once
+#include "common/common.hpp"
+
+// Builds a GrowableHashTable of key counts from a small initial table, for
+// inputs whose number of distinct keys is not known up front.
+class GrowableHashBuild : public Dwarf {
+public:
+  GrowableHashBuild();
+  void run(const RunOptions &opts) override;
+  void init(const RunOptions &opts) override;
+
+private:
+  void _run(const size_t buffer_size, double load_factor, Meter &meter);
+};
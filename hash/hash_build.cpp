@@ -2,56 +2,100 @@
 
 #include "common/dpcpp/hashtable.hpp"
 
+template <class Hash, class Stats> class HashBuildKernel;
+template <class Hash, class Stats> class HashBuildCheck;
+
 HashBuild::HashBuild() : Dwarf("HashBuild") {}
-void HashBuild::_run(const size_t buf_size, Meter &meter) {
+void HashBuild::_run(const size_t buf_size, double load_factor,
+                     Meter &meter) {
+  const RunOptions &opts = meter.opts();
+  const size_t ht_size = hashed_table_size(
+      opts.hasher, helpers::table_capacity(buf_size, load_factor));
+  with_hasher(opts.hasher, ht_size, helpers::input_seed(opts, "hasher"),
+              SimpleHasher<uint32_t>(ht_size),
+              [&](auto hasher) {
+                with_probe_stats(opts.probe_stats, [&](auto stats) {
+                  _run_hashed<decltype(hasher), decltype(stats)>(
+                      buf_size, load_factor, meter, hasher);
+                });
+              });
+}
+
+template <class Hash, class Stats>
+void HashBuild::_run_hashed(const size_t buf_size, double load_factor,
+                            Meter &meter, Hash hasher) {
   auto opts = meter.opts();
-  const std::vector<uint32_t> host_src =
-      helpers::make_random<uint32_t>(buf_size);
+  const Column<uint32_t> host_src =
+      helpers::input_column<uint32_t>(opts, "keys", buf_size, [&] {
+        return helpers::make_keys<uint32_t>(opts, "keys", buf_size, 1, 10000);
+      });
 
-  auto sel = get_device_selector(opts);
-  sycl::queue q{*sel};
-  std::cout << "Selected device: "
-            << q.get_device().get_info<sycl::info::device::name>() << "\n";
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
 
-  SimpleHasher<uint32_t> hasher(buf_size);
+  const size_t ht_size = hashed_table_size(
+      opts.hasher, helpers::table_capacity(buf_size, load_factor));
 
-  for (auto it = 0; it < opts.iterations; ++it) {
-    size_t bitmask_sz = (buf_size / 32) ? (buf_size / 32) : 1;
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  meter.measure(std::move(params), [&]() {
+    size_t bitmask_sz = ht_size / 32 + 1;
     std::vector<uint32_t> bitmask(bitmask_sz, 0);
-    std::vector<uint32_t> data(buf_size, 0);
-    std::vector<uint32_t> keys(buf_size, 0);
+    std::vector<uint32_t> data(ht_size, 0);
+    std::vector<uint32_t> keys(ht_size, 0);
     std::vector<uint32_t> output(buf_size, 0);
     std::vector<uint32_t> expected(buf_size, 1);
 
-    sycl::buffer<uint32_t> bitmask_buf(bitmask);
-    sycl::buffer<uint32_t> data_buf(data);
-    sycl::buffer<uint32_t> keys_buf(keys);
-    sycl::buffer<uint32_t> src(host_src);
+    sycl::buffer<uint32_t> bitmask_buf{sycl::range<1>{bitmask_sz}};
+    sycl::buffer<uint32_t> data_buf{sycl::range<1>{ht_size}};
+    sycl::buffer<uint32_t> keys_buf{sycl::range<1>{ht_size}};
+    sycl::buffer<uint32_t> src{sycl::range<1>{buf_size}};
+    ProbeCounters probes(opts.probe_stats);
 
+    EventProfiler profiler;
+    PerfCounters counters(opts.perf_counters && q.get_device().is_cpu());
+    counters.start();
     auto host_start = std::chrono::steady_clock::now();
-    q.submit([&](sycl::handler &h) {
-       auto s = src.get_access(h);
-
-       auto bitmask_acc = bitmask_buf.get_access(h);
-       auto data_acc = data_buf.get_access(h);
-       auto keys_acc = keys_buf.get_access(h);
-
-       h.parallel_for<class hash_build>(buf_size, [=](auto &idx) {
-         SimpleNonOwningHashTable<uint32_t, uint32_t, SimpleHasher<uint32_t>>
-             ht(buf_size, keys_acc.get_pointer(), data_acc.get_pointer(),
-                bitmask_acc.get_pointer(), hasher);
-
-         ht.insert(s[idx], s[idx]);
-       });
-     }).wait();
+    profiler.upload(q, bitmask, bitmask_buf);
+    profiler.upload(q, data, data_buf);
+    profiler.upload(q, keys, keys_buf);
+    profiler.upload(q, host_src, src);
+    sycl::event build = q.submit([&](sycl::handler &h) {
+      auto s = src.get_access(h);
+
+      auto bitmask_acc = bitmask_buf.get_access(h);
+      auto data_acc = data_buf.get_access(h);
+      auto keys_acc = keys_buf.get_access(h);
+      auto probes_acc = probes.access<Stats>(h);
+
+      h.parallel_for<HashBuildKernel<Hash, Stats>>(buf_size, [=](auto &idx) {
+        SimpleNonOwningHashTable<uint32_t, uint32_t, Hash, Stats> ht(
+            ht_size, keys_acc.get_pointer(), data_acc.get_pointer(),
+            bitmask_acc.get_pointer(), hasher,
+            Stats(probes_acc.get_pointer()));
+
+        ht.insert(s[idx], s[idx]);
+      });
+    });
+    profiler.kernel(build, "hash_build").wait();
 
     auto host_end = std::chrono::steady_clock::now();
+    counters.stop();
     auto host_exe_time = std::chrono::duration_cast<std::chrono::microseconds>(
                              host_end - host_start)
                              .count();
     std::unique_ptr<Result> result = std::make_unique<Result>();
     result->host_time = host_end - host_start;
-
+    profiler.fill(*result);
+    counters.fill(*result);
+    probes.fill(*result);
+    result->rows = buf_size;
+    result->bytes_read = buf_size * sizeof(uint32_t);
+    result->bytes_written = 2 * buf_size * sizeof(uint32_t);
+    result->table_bytes = 2 * ht_size * sizeof(uint32_t) +
+                          bitmask_sz * sizeof(uint32_t);
+
+    TraceSpan check(opts.tracer, "check");
     sycl::buffer<uint32_t> out_buf(output);
 
     q.submit([&](sycl::handler &h) {
@@ -62,10 +106,10 @@ void HashBuild::_run(const size_t buf_size, Meter &meter) {
        auto data_acc = data_buf.get_access(h);
        auto keys_acc = keys_buf.get_access(h);
 
-       h.parallel_for<class hash_build_check>(buf_size, [=](auto &idx) {
-         SimpleNonOwningHashTable<uint32_t, uint32_t, SimpleHasher<uint32_t>>
-             ht(buf_size, keys_acc.get_pointer(), data_acc.get_pointer(),
-                bitmask_acc.get_pointer(), hasher);
+       h.parallel_for<HashBuildCheck<Hash, Stats>>(buf_size, [=](auto &idx) {
+         SimpleNonOwningHashTable<uint32_t, uint32_t, Hash> ht(
+             ht_size, keys_acc.get_pointer(), data_acc.get_pointer(),
+             bitmask_acc.get_pointer(), hasher);
 
          o[idx] = ht.has(s[idx]);
        });
@@ -77,18 +121,23 @@ void HashBuild::_run(const size_t buf_size, Meter &meter) {
       result->valid = false;
     }
 
-    DwarfParams params{{"buf_size", std::to_string(buf_size)}};
-    meter.add_result(std::move(params), std::move(result));
-  }
+    return result;
+  });
 }
 
 void HashBuild::run(const RunOptions &opts) {
   for (auto size : opts.input_size) {
-    _run(size, meter());
+    for (double load_factor : helpers::load_factors(opts, 1)) {
+      _run(size, load_factor, meter());
+    }
   }
 }
 void HashBuild::init(const RunOptions &opts) {
   meter().set_opts(opts);
-  DwarfParams params = {{"device_type", to_string(opts.device_ty)}};
+  DwarfParams params = {{"device_type", to_string(opts.device_ty)},
+                        {"distribution", to_string(opts.distribution)},
+                        {"hasher", to_string(opts.hasher)}};
+  if (opts.probe_stats)
+    params["probe_stats"] = "true";
   meter().set_params(params);
 }
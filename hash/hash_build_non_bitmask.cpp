@@ -4,44 +4,53 @@
 #include <limits>
 
 HashBuildNonBitmask::HashBuildNonBitmask() : Dwarf("HashBuildNonBitmask") {}
-void HashBuildNonBitmask::_run(const size_t buf_size, Meter &meter) {
+void HashBuildNonBitmask::_run(const size_t buf_size, double load_factor,
+                               Meter &meter) {
   auto opts = meter.opts();
-  const std::vector<uint32_t> host_src =
-      helpers::make_random<uint32_t>(buf_size);
+  const Column<uint32_t> host_src =
+      helpers::input_column<uint32_t>(opts, "keys", buf_size, [&] {
+        return helpers::make_keys<uint32_t>(opts, "keys", buf_size, 1, 10000);
+      });
   const uint32_t empty_element = std::numeric_limits<uint32_t>::max();
 
-  auto sel = get_device_selector(opts);
-  sycl::queue q{*sel};
-  std::cout << "Selected device: "
-            << q.get_device().get_info<sycl::info::device::name>() << "\n";
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
 
-  SimpleHasher<uint32_t> hasher(buf_size);
+  const size_t ht_size = helpers::table_capacity(buf_size, load_factor);
+  SimpleHasher<uint32_t> hasher(ht_size);
 
-  for (auto it = 0; it < opts.iterations; ++it) {
-    std::vector<uint32_t> data(buf_size, 0);
-    std::vector<uint32_t> keys(buf_size, empty_element);
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  meter.measure(std::move(params), [&]() {
+    std::vector<uint32_t> data(ht_size, 0);
+    std::vector<uint32_t> keys(ht_size, empty_element);
     std::vector<uint32_t> output(buf_size, 0);
     std::vector<uint32_t> expected(buf_size, 1);
 
-    sycl::buffer<uint32_t> data_buf(data);
-    sycl::buffer<uint32_t> keys_buf(keys);
-    sycl::buffer<uint32_t> src(host_src);
+    sycl::buffer<uint32_t> data_buf{sycl::range<1>{ht_size}};
+    sycl::buffer<uint32_t> keys_buf{sycl::range<1>{ht_size}};
+    sycl::buffer<uint32_t> src{sycl::range<1>{buf_size}};
 
+    EventProfiler profiler;
     auto host_start = std::chrono::steady_clock::now();
-    q.submit([&](sycl::handler &h) {
-       auto s = src.get_access(h);
-       auto data_acc = data_buf.get_access(h);
-       auto keys_acc = keys_buf.get_access(h);
-
-       h.parallel_for<class hash_build>(buf_size, [=](auto &idx) {
-         NonOwningHashTableNonBitmask<uint32_t, uint32_t,
-                                      SimpleHasher<uint32_t>>
-             ht(buf_size, keys_acc.get_pointer(), data_acc.get_pointer(),
-                hasher, empty_element);
-
-         ht.insert(s[idx], s[idx]);
-       });
-     }).wait();
+    profiler.upload(q, data, data_buf);
+    profiler.upload(q, keys, keys_buf);
+    profiler.upload(q, host_src, src);
+    sycl::event build = q.submit([&](sycl::handler &h) {
+      auto s = src.get_access(h);
+      auto data_acc = data_buf.get_access(h);
+      auto keys_acc = keys_buf.get_access(h);
+
+      h.parallel_for<class hash_build>(buf_size, [=](auto &idx) {
+        NonOwningHashTableNonBitmask<uint32_t, uint32_t,
+                                     SimpleHasher<uint32_t>>
+            ht(ht_size, keys_acc.get_pointer(), data_acc.get_pointer(),
+               hasher, empty_element);
+
+        ht.insert(s[idx], s[idx]);
+      });
+    });
+    profiler.kernel(build, "hash_build").wait();
 
     auto host_end = std::chrono::steady_clock::now();
     auto host_exe_time = std::chrono::duration_cast<std::chrono::microseconds>(
@@ -49,7 +58,13 @@ void HashBuildNonBitmask::_run(const size_t buf_size, Meter &meter) {
                              .count();
     std::unique_ptr<Result> result = std::make_unique<Result>();
     result->host_time = host_end - host_start;
+    profiler.fill(*result);
+    result->rows = buf_size;
+    result->bytes_read = buf_size * sizeof(uint32_t);
+    result->bytes_written = 2 * buf_size * sizeof(uint32_t);
+    result->table_bytes = 2 * ht_size * sizeof(uint32_t);
 
+    TraceSpan check(opts.tracer, "check");
     sycl::buffer<uint32_t> out_buf(output);
 
     q.submit([&](sycl::handler &h) {
@@ -61,7 +76,7 @@ void HashBuildNonBitmask::_run(const size_t buf_size, Meter &meter) {
        h.parallel_for<class hash_build_check>(buf_size, [=](auto &idx) {
          NonOwningHashTableNonBitmask<uint32_t, uint32_t,
                                       SimpleHasher<uint32_t>>
-             ht(buf_size, keys_acc.get_pointer(), data_acc.get_pointer(),
+             ht(ht_size, keys_acc.get_pointer(), data_acc.get_pointer(),
                 hasher, empty_element);
 
          o[idx] = ht.has(s[idx]);
@@ -74,18 +89,20 @@ void HashBuildNonBitmask::_run(const size_t buf_size, Meter &meter) {
       result->valid = false;
     }
 
-    DwarfParams params{{"buf_size", std::to_string(buf_size)}};
-    meter.add_result(std::move(params), std::move(result));
-  }
+    return result;
+  });
 }
 
 void HashBuildNonBitmask::run(const RunOptions &opts) {
   for (auto size : opts.input_size) {
-    _run(size, meter());
+    for (double load_factor : helpers::load_factors(opts, 1)) {
+      _run(size, load_factor, meter());
+    }
   }
 }
 void HashBuildNonBitmask::init(const RunOptions &opts) {
   meter().set_opts(opts);
-  DwarfParams params = {{"device_type", to_string(opts.device_ty)}};
+  DwarfParams params = {{"device_type", to_string(opts.device_ty)},
+                        {"distribution", to_string(opts.distribution)}};
   meter().set_params(params);
 }
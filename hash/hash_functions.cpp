@@ -0,0 +1,137 @@
+#include "hash_functions.hpp"
+
+#include "common/dpcpp/hashfunctions.hpp"
+#include "common/dpcpp/slab_hash.hpp"
+#include <limits>
+#include <unordered_set>
+
+namespace {
+// SlabHash::DefaultHasher with the parameters of the slab dwarfs, indexing
+// a table of `size` slots instead of buckets.
+struct SlabDefaultHasher {
+  explicit SlabDefaultHasher(size_t size) : _size(size) {}
+  template <class Key> size_t operator()(const Key &v) const {
+    return SlabHash::DefaultHasher<242792921, 653019598, 2147483647>()(v,
+                                                                       _size);
+  }
+
+private:
+  size_t _size;
+};
+
+// Rows of the first occurrence of every key.
+std::vector<size_t> distinct_rows(const Column<uint32_t> &keys) {
+  std::unordered_set<uint32_t> seen;
+  std::vector<size_t> rows;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (seen.insert(keys[i]).second)
+      rows.push_back(i);
+  }
+  return rows;
+}
+} // namespace
+
+template <class Hash> class HashKeys;
+
+HashFunctions::HashFunctions() : Dwarf("HashFunctions") {}
+
+void HashFunctions::_run(const size_t buf_size, Meter &meter) {
+  auto opts = meter.opts();
+  const uint32_t hi = std::min<uint64_t>(
+      buf_size * 10, std::numeric_limits<uint32_t>::max() - 1);
+  const Column<uint32_t> keys =
+      helpers::input_column<uint32_t>(opts, "keys", buf_size, [&] {
+        return helpers::make_keys<uint32_t>(opts, "keys", buf_size, 1, hi);
+      });
+  const std::vector<size_t> distinct = distinct_rows(keys);
+
+  // Every hasher indexes the same power-of-two table, at most half full.
+  size_t table_size = 1;
+  while (table_size < 2 * buf_size) {
+    table_size <<= 1;
+  }
+
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
+
+  // Measures one hasher, with the quality of its slots for distinct keys.
+  auto run = [&](const std::string &name, auto hasher) {
+    using Hash = decltype(hasher);
+    DwarfParams params{{"buf_size", std::to_string(buf_size)},
+                       {"hasher", name}};
+    meter.measure(std::move(params), [&]() {
+      std::vector<size_t> slots(buf_size, 0);
+      std::unique_ptr<HashQualityResult> result =
+          std::make_unique<HashQualityResult>();
+      {
+        sycl::buffer<uint32_t> keys_buf{sycl::range<1>{buf_size}};
+        sycl::buffer<size_t> slots_buf{sycl::range<1>{buf_size}};
+
+        EventProfiler profiler;
+        PerfCounters counters(opts.perf_counters && q.get_device().is_cpu());
+        counters.start();
+        auto host_start = std::chrono::steady_clock::now();
+        profiler.upload(q, keys, keys_buf);
+        sycl::event hash = q.submit([&](sycl::handler &h) {
+          auto k = keys_buf.get_access(h);
+          auto s = slots_buf.get_access(h);
+
+          h.parallel_for<HashKeys<Hash>>(buf_size, [=](auto &idx) {
+            s[idx] = hasher(k[idx]);
+          });
+        });
+        profiler.kernel(hash, "hash");
+        profiler.download(q, slots_buf, slots).wait();
+        auto host_end = std::chrono::steady_clock::now();
+        counters.stop();
+
+        result->host_time = host_end - host_start;
+        profiler.fill(*result);
+        counters.fill(*result);
+      }
+      result->rows = buf_size;
+      result->bytes_read = buf_size * sizeof(uint32_t);
+      result->bytes_written = buf_size * sizeof(size_t);
+
+      TraceSpan check(opts.tracer, "check");
+      std::vector<size_t> distinct_slots(distinct.size());
+      for (size_t i = 0; i < distinct.size(); ++i) {
+        distinct_slots[i] = slots[distinct[i]];
+        if (distinct_slots[i] >= table_size) {
+          std::cerr << "Hash out of the table" << std::endl;
+          result->valid = false;
+          return result;
+        }
+      }
+      result->quality = stats::hash_quality(distinct_slots, table_size);
+
+      return result;
+    });
+  };
+  run("simple", SimpleHasher<uint32_t>(table_size));
+  run("simple_offset", SimpleHasherWithOffset(table_size, 1));
+  run("polynomial",
+      PolynomialHasher(table_size, helpers::input_seed(opts, "hasher")));
+  run("murmur3", MurmurHash3_x86_32(table_size, 0));
+  run("slab_default", SlabDefaultHasher(table_size));
+  for (auto kind : {HasherKind::MultiplyShift, HasherKind::Fibonacci,
+                    HasherKind::Crc32, HasherKind::XxHash,
+                    HasherKind::WyHash}) {
+    with_hasher(kind, table_size, helpers::input_seed(opts, "hasher"),
+                SimpleHasher<uint32_t>(table_size),
+                [&](auto hasher) { run(to_string(kind), hasher); });
+  }
+}
+
+void HashFunctions::run(const RunOptions &opts) {
+  for (auto size : opts.input_size) {
+    _run(size, meter());
+  }
+}
+void HashFunctions::init(const RunOptions &opts) {
+  meter().set_opts(opts);
+  DwarfParams params = {{"device_type", to_string(opts.device_ty)},
+                        {"distribution", to_string(opts.distribution)}};
+  meter().set_params(params);
+}
@@ -1,27 +1,41 @@
 #include "slab_hash_build.hpp"
 #include "common/dpcpp/slab_hash.hpp"
 #include <cmath>
+#include <limits>
 
 using std::pair;
 
+template <class Stats> class SlabHashBuildKernel;
+template <class Stats> class SlabHashBuildCheck;
+
 SlabHashBuild::SlabHashBuild() : Dwarf("SlabHashBuild") {}
 
-void SlabHashBuild::_run(const size_t buf_size, Meter &meter) {
+void SlabHashBuild::_run(const size_t buf_size, double load_factor,
+                         Meter &meter) {
+  with_probe_stats(meter.opts().probe_stats, [&](auto stats) {
+    _run_stats<decltype(stats)>(buf_size, load_factor, meter);
+  });
+}
+
+template <class Stats>
+void SlabHashBuild::_run_stats(const size_t buf_size, double load_factor,
+                               Meter &meter) {
   const int scale = 16; // todo how to get through options
-  int mem_util = 60;
-  size_t buckets_count = SlabHash::calculate_buckets_count(buf_size, mem_util);
-  size_t cluster_size = 2 * buckets_count;
+  size_t buckets_count = SlabHash::buckets_count(buf_size, load_factor);
+  size_t cluster_size = SlabHash::nodes_count(buf_size, buckets_count);
 
   auto opts = meter.opts();
-  const std::vector<uint32_t> host_src =
-      helpers::make_random<uint32_t>(buf_size);
+  const Column<uint32_t> host_src =
+      helpers::input_column<uint32_t>(opts, "keys", buf_size, [&] {
+        return helpers::make_random<uint32_t>(opts, "keys", buf_size);
+      });
 
-  auto sel = get_device_selector(opts);
-  sycl::queue q{*sel};
-  std::cout << "Selected device: "
-            << q.get_device().get_info<sycl::info::device::name>() << "\n";
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
 
-  for (auto it = 0; it < opts.iterations; ++it) {
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  meter.measure(std::move(params), [&]() {
     int num_of_groups = ceil((float)buf_size / scale);
 
     sycl::nd_range<1> r{SlabHash::SUBGROUP_SIZE * num_of_groups,
@@ -36,29 +50,51 @@ void SlabHashBuild::_run(const size_t buf_size, Meter &meter) {
     {
       sycl::buffer<SlabHash::AllocAdapter<std::pair<uint32_t, uint32_t>>>
           adap_buf(&adap, sycl::range<1>{1});
-      sycl::buffer<uint32_t> src(host_src);
-      auto host_start = std::chrono::steady_clock::now();
-
-      q.submit([&](sycl::handler &h) {
-         auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
-         auto s = sycl::accessor(src, h, sycl::read_only);
+      sycl::buffer<uint32_t> src{sycl::range<1>{buf_size}};
+      // Rows whose insert found no free slab, inserted again once the heap
+      // grew.
+      sycl::buffer<uint8_t> failed{sycl::range<1>{buf_size}};
+      ProbeCounters probes(opts.probe_stats);
 
-         h.parallel_for<class slab_hash_build>(
-             r, [=](sycl::nd_item<1> it) [
-                    [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
-               size_t ind = it.get_group().get_id();
-
-               SlabHash::SlabHashTable<
-                   uint32_t, uint32_t,
-                   SlabHash::DefaultHasher<242792921, 653019598, 2147483647>>
-                   ht(SlabHash::EMPTY_UINT32_T, it, *(adap_acc.get_pointer()));
-
-               for (int i = ind * scale; i < (ind + 1) * scale && i < buf_size;
-                    i++) {
-                 ht.insert(s[i], s[i]);
-               }
-             });
-       }).wait();
+      EventProfiler profiler;
+      auto host_start = std::chrono::steady_clock::now();
+      profiler.upload(q, host_src, src);
+
+      auto build = [&](bool retry) {
+        return q.submit([&](sycl::handler &h) {
+          auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
+          auto s = sycl::accessor(src, h, sycl::read_only);
+          auto f = sycl::accessor(failed, h, sycl::read_write);
+          auto probes_acc = probes.access<Stats>(h);
+
+          h.parallel_for<SlabHashBuildKernel<Stats>>(
+              r, [=](sycl::nd_item<1> it) [
+                     [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
+                size_t ind = it.get_group().get_id();
+
+                SlabHash::SlabHashTable<
+                    uint32_t, uint32_t,
+                    SlabHash::DefaultHasher<242792921, 653019598, 2147483647>,
+                    Stats>
+                    ht(SlabHash::EMPTY_UINT32_T, it,
+                       *(adap_acc.get_pointer()),
+                       Stats(probes_acc.get_pointer()));
+
+                for (int i = ind * scale;
+                     i < (ind + 1) * scale && i < buf_size; i++) {
+                  if (retry && !f[i])
+                    continue;
+                  bool inserted = ht.insert(s[i], s[i]);
+                  if (it.get_local_id() == 0)
+                    f[i] = !inserted;
+                }
+              });
+        });
+      };
+      profiler.kernel(build(false), "slab_hash_build").wait();
+      while (adap.grow_if_overflowed()) {
+        profiler.kernel(build(true), "slab_hash_build").wait();
+      }
 
       auto host_end = std::chrono::steady_clock::now();
       auto host_exe_time =
@@ -67,7 +103,18 @@ void SlabHashBuild::_run(const size_t buf_size, Meter &meter) {
               .count();
       std::unique_ptr<Result> result = std::make_unique<Result>();
       result->host_time = host_end - host_start;
-
+      profiler.fill(*result);
+      probes.fill(*result);
+      result->rows = buf_size;
+      result->bytes_read = buf_size * sizeof(uint32_t);
+      result->bytes_written = 2 * buf_size * sizeof(uint32_t);
+      const SlabHash::HeapUsage heap = adap.usage();
+      result->table_bytes = SlabHash::memory_size<pair<uint32_t, uint32_t>>(
+          buckets_count, heap.allocated);
+      result->slabs_allocated = heap.allocated;
+      result->slabs_used = heap.used;
+
+      TraceSpan check(opts.tracer, "check");
       sycl::buffer<uint32_t> out_buf(output);
 
       q.submit([&](sycl::handler &h) {
@@ -75,7 +122,7 @@ void SlabHashBuild::_run(const size_t buf_size, Meter &meter) {
          auto s = sycl::accessor(src, h, sycl::read_only);
          auto o = sycl::accessor(out_buf, h, sycl::read_write);
 
-         h.parallel_for<class slab_hash_build_check>(
+         h.parallel_for<SlabHashBuildCheck<Stats>>(
              r, [=](sycl::nd_item<1> it) [
                     [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
                size_t ind = it.get_group().get_id();
@@ -101,19 +148,24 @@ void SlabHashBuild::_run(const size_t buf_size, Meter &meter) {
         result->valid = false;
       }
 
-      DwarfParams params{{"buf_size", std::to_string(buf_size)}};
-      meter.add_result(std::move(params), std::move(result));
+      return result;
     }
-  }
+  });
 }
 
 void SlabHashBuild::run(const RunOptions &opts) {
   for (auto size : opts.input_size) {
-    _run(size, meter());
+    for (double load_factor :
+         helpers::load_factors(opts, SlabHash::DEFAULT_LOAD_FACTOR,
+                               std::numeric_limits<double>::infinity())) {
+      _run(size, load_factor, meter());
+    }
   }
 }
 void SlabHashBuild::init(const RunOptions &opts) {
   meter().set_opts(opts);
   DwarfParams params = {{"device_type", to_string(opts.device_ty)}};
+  if (opts.probe_stats)
+    params["probe_stats"] = "true";
   meter().set_params(params);
 }
@@ -0,0 +1,232 @@
+#include "slab_mixed_ops.hpp"
+#include "common/dpcpp/slab_hash.hpp"
+#include <cmath>
+#include <limits>
+#include <random>
+
+using std::pair;
+
+namespace {
+using Hasher = SlabHash::DefaultHasher<242792921, 653019598, 2147483647>;
+using Table = SlabHash::SlabHashTable<uint32_t, uint32_t, Hasher>;
+using Adapter = SlabHash::AllocAdapter<pair<uint32_t, uint32_t>>;
+
+// Keys in the table have themselves as values and inserted ones the next
+// key, so finds tell them apart.
+uint32_t inserted_value(uint32_t key) { return key + 1; }
+} // namespace
+
+SlabMixedOps::SlabMixedOps() : Dwarf("SlabMixedOps") {}
+
+void SlabMixedOps::_run(const size_t buf_size, double load_factor,
+                        const OpMix &mix, Meter &meter) {
+  const int scale = 16;
+  auto opts = meter.opts();
+
+  // The table starts with the first buf_size keys. The operations take the
+  // buf_size keys from buf_size / 2 on, so half of them are in the table,
+  // and touch every key once, so that their results do not depend on the
+  // order in which they run.
+  const size_t first_op = buf_size / 2;
+  const uint32_t keys_hi = std::min<uint64_t>(
+      20 * buf_size, std::numeric_limits<uint32_t>::max() - 2);
+  const std::vector<uint32_t> host_keys =
+      helpers::make_unique_random(opts, "keys", 2 * buf_size, keys_hi);
+
+  std::vector<uint32_t> host_ops(buf_size);
+  std::mt19937_64 gen(helpers::input_seed(opts, "ops"));
+  std::discrete_distribution<uint32_t> pick({mix.insert, mix.find, mix.erase});
+  std::generate(host_ops.begin(), host_ops.end(), [&]() { return pick(gen); });
+
+  // Results of the operations (whether an insert or erase succeeded, the
+  // value a find got or 0) and the value of every key afterwards.
+  std::vector<uint32_t> expected(buf_size, 0);
+  std::vector<uint32_t> expected_after(buf_size, 0);
+  size_t inserts = 0;
+  for (size_t i = 0; i < buf_size; ++i) {
+    const uint32_t key = host_keys[first_op + i];
+    const bool present = first_op + i < buf_size;
+    switch (host_ops[i]) {
+    case OpMix::Insert:
+      expected[i] = 1;
+      expected_after[i] = inserted_value(key);
+      ++inserts;
+      break;
+    case OpMix::Find:
+      expected[i] = present ? key : 0;
+      expected_after[i] = expected[i];
+      break;
+    case OpMix::Erase:
+      expected[i] = present;
+      break;
+    }
+  }
+
+  const size_t buckets_count = SlabHash::buckets_count(buf_size, load_factor);
+  const size_t cluster_size = SlabHash::nodes_count(buf_size, buckets_count);
+
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
+
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  params["op_mix"] = to_string(mix);
+  meter.measure(std::move(params), [&]() {
+    int num_of_groups = ceil((float)buf_size / scale);
+    sycl::nd_range<1> r{SlabHash::SUBGROUP_SIZE * num_of_groups,
+                        SlabHash::SUBGROUP_SIZE};
+    Adapter adap(cluster_size, num_of_groups, buckets_count,
+                 {SlabHash::EMPTY_UINT32_T, 0}, q);
+
+    std::vector<uint32_t> output(buf_size, 0);
+    std::vector<uint32_t> output_after(buf_size, 0);
+
+    {
+      sycl::buffer<Adapter> adap_buf(&adap, sycl::range<1>{1});
+      sycl::buffer<uint32_t> keys{host_keys.data(),
+                                  sycl::range<1>{host_keys.size()}};
+      sycl::buffer<uint32_t> ops{sycl::range<1>{buf_size}};
+      sycl::buffer<uint32_t> out_buf{sycl::range<1>{buf_size}};
+
+      q.submit([&](sycl::handler &h) {
+         auto k = sycl::accessor(keys, h, sycl::read_only);
+         auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
+
+         h.parallel_for<class slab_mixed_ops_fill>(
+             r, [=](sycl::nd_item<1> it) [
+                    [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
+               size_t ind = it.get_group().get_id();
+               Table ht(SlabHash::EMPTY_UINT32_T, it, *adap_acc.get_pointer());
+
+               for (int i = ind * scale; i < (ind + 1) * scale && i < buf_size;
+                    i++) {
+                 ht.insert(k[i], k[i]);
+               }
+             });
+       }).wait();
+      // Slabs for the inserts, as the table grows.
+      adap.reserve(SlabHash::nodes_count(buf_size + inserts, buckets_count));
+
+      EventProfiler profiler;
+      auto host_start = std::chrono::steady_clock::now();
+      profiler.upload(q, host_ops, ops);
+      sycl::event mixed = q.submit([&](sycl::handler &h) {
+        auto k = sycl::accessor(keys, h, sycl::read_only);
+        auto op = sycl::accessor(ops, h, sycl::read_only);
+        auto o = sycl::accessor(out_buf, h, sycl::write_only);
+        auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
+
+        h.parallel_for<class slab_mixed_ops>(
+            r, [=](sycl::nd_item<1> it) [
+                   [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
+              size_t ind = it.get_group().get_id();
+              Table ht(SlabHash::EMPTY_UINT32_T, it, *adap_acc.get_pointer());
+
+              for (int i = ind * scale; i < (ind + 1) * scale && i < buf_size;
+                   i++) {
+                const uint32_t key = k[first_op + i];
+                uint32_t res = 0;
+                switch (op[i]) {
+                case OpMix::Insert:
+                  res = ht.upsert(key, inserted_value(key));
+                  break;
+                case OpMix::Find:
+                  res = ht.find(key).value_or(0);
+                  break;
+                case OpMix::Erase:
+                  res = ht.erase(key);
+                  break;
+                }
+                if (it.get_local_id() == 0)
+                  o[i] = res;
+              }
+            });
+      });
+      profiler.kernel(mixed, "slab_mixed_ops");
+      profiler.download(q, out_buf, output).wait();
+
+      auto host_end = std::chrono::steady_clock::now();
+
+      // Returns the slabs the erases emptied to the heap, so that the slabs
+      // in use count live entries only. The finds below check that the
+      // lists stay intact.
+      q.submit([&](sycl::handler &h) {
+         auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
+
+         h.parallel_for<class slab_mixed_ops_compact>(
+             sycl::nd_range<1>{SlabHash::SUBGROUP_SIZE * buckets_count,
+                               SlabHash::SUBGROUP_SIZE},
+             [=](sycl::nd_item<1> it) [
+                 [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
+               Table ht(SlabHash::EMPTY_UINT32_T, it, *adap_acc.get_pointer());
+               ht.compact(it.get_group_linear_id());
+             });
+       }).wait();
+
+      std::unique_ptr<Result> result = std::make_unique<Result>();
+      result->host_time = host_end - host_start;
+      profiler.fill(*result);
+      result->rows = buf_size;
+      result->bytes_read = 2 * buf_size * sizeof(uint32_t);
+      result->bytes_written = buf_size * sizeof(uint32_t);
+      const SlabHash::HeapUsage heap = adap.usage();
+      result->table_bytes = SlabHash::memory_size<pair<uint32_t, uint32_t>>(
+          buckets_count, heap.allocated);
+      result->slabs_allocated = heap.allocated;
+      result->slabs_used = heap.used;
+
+      TraceSpan check(opts.tracer, "check");
+      q.submit([&](sycl::handler &h) {
+         auto k = sycl::accessor(keys, h, sycl::read_only);
+         auto o = sycl::accessor(out_buf, h, sycl::write_only);
+         auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
+
+         h.parallel_for<class slab_mixed_ops_check>(
+             r, [=](sycl::nd_item<1> it) [
+                    [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
+               size_t ind = it.get_group().get_id();
+               Table ht(SlabHash::EMPTY_UINT32_T, it, *adap_acc.get_pointer());
+
+               for (int i = ind * scale; i < (ind + 1) * scale && i < buf_size;
+                    i++) {
+                 auto ans = ht.find(k[first_op + i]);
+                 if (it.get_local_id() == 0)
+                   o[i] = ans.value_or(0);
+               }
+             });
+       }).wait();
+      profiler.download(q, out_buf, output_after).wait();
+
+      if (heap.overflowed) {
+        std::cerr << "Slab heap overflow" << std::endl;
+        result->valid = false;
+      }
+      if (output != expected || output_after != expected_after) {
+        std::cerr << "Incorrect results" << std::endl;
+        result->valid = false;
+      }
+
+      return result;
+    }
+  });
+}
+
+void SlabMixedOps::run(const RunOptions &opts) {
+  const std::vector<OpMix> mixes =
+      opts.op_mix.empty() ? std::vector<OpMix>{OpMix()} : opts.op_mix;
+  for (auto size : opts.input_size) {
+    for (double load_factor :
+         helpers::load_factors(opts, SlabHash::DEFAULT_LOAD_FACTOR,
+                               std::numeric_limits<double>::infinity())) {
+      for (const OpMix &mix : mixes) {
+        _run(size, load_factor, mix, meter());
+      }
+    }
+  }
+}
+
+void SlabMixedOps::init(const RunOptions &opts) {
+  meter().set_opts(opts);
+  DwarfParams params = {{"device_type", to_string(opts.device_ty)}};
+  meter().set_params(params);
+}
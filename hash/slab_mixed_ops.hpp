@@ -0,0 +1,17 @@
+#pragma once
+
+#include "common/common.hpp"
+
+// Inserts (updating present keys), finds and erases on a slab hash table in
+// one kernel, the operations of a long-lived dictionary. Throughput is in
+// operations per second, one point per --op_mix.
+class SlabMixedOps : public Dwarf {
+public:
+  SlabMixedOps();
+  void run(const RunOptions &opts) override;
+  void init(const RunOptions &opts) override;
+
+private:
+  void _run(const size_t buffer_size, double load_factor, const OpMix &mix,
+            Meter &meter);
+};
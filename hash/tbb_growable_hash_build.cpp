@@ -0,0 +1,77 @@
+#include "tbb_growable_hash_build.hpp"
+#include "common/growable_hashtable.hpp"
+#include "common/hashers.hpp"
+#include <unordered_map>
+
+namespace {
+// Slots of the table before the first row, as in GrowableHashBuild.
+constexpr size_t INITIAL_CAPACITY = 1024;
+} // namespace
+
+TBBGrowableHashBuild::TBBGrowableHashBuild()
+    : Dwarf("TBBGrowableHashBuild") {}
+
+void TBBGrowableHashBuild::_run(const size_t buf_size, double load_factor,
+                                Meter &meter) {
+  using Table = HostGrowableHashTable<uint32_t, uint32_t, Hashes::Fibonacci>;
+  auto opts = meter.opts();
+  const Column<uint32_t> host_src =
+      helpers::input_column<uint32_t>(opts, "keys", buf_size, [&] {
+        return helpers::make_keys<uint32_t>(opts, "keys", buf_size, 1,
+                                            std::max<size_t>(buf_size, 1));
+      });
+  const std::vector<uint32_t> ones(buf_size, 1);
+  std::unordered_map<uint32_t, uint32_t> expected;
+  for (uint32_t key : host_src) {
+    ++expected[key];
+  }
+
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  meter.measure(std::move(params), [&]() {
+    Table ht(INITIAL_CAPACITY, load_factor);
+    PerfCounters counters(opts.perf_counters);
+    counters.start();
+    auto host_start = std::chrono::steady_clock::now();
+    ht.add(host_src.data(), ones.data(), buf_size);
+    auto host_end = std::chrono::steady_clock::now();
+    counters.stop();
+
+    std::unique_ptr<Result> result = std::make_unique<Result>();
+    result->host_time = host_end - host_start;
+    counters.fill(*result);
+    result->rows = buf_size;
+    result->bytes_read = 2 * buf_size * sizeof(uint32_t);
+    result->bytes_written = 2 * expected.size() * sizeof(uint32_t);
+    result->table_bytes = ht.bytes();
+    result->rehashes = ht.rehashes();
+
+    TraceSpan check(opts.tracer, "check");
+    bool valid = ht.size() == expected.size();
+    for (const auto &e : expected) {
+      valid = valid && ht.at(e.first) == std::make_pair(e.second, true);
+    }
+    if (!valid) {
+      std::cerr << "Incorrect results" << std::endl;
+      result->valid = false;
+    }
+
+    return result;
+  });
+}
+
+void TBBGrowableHashBuild::run(const RunOptions &opts) {
+  for (auto size : opts.input_size) {
+    for (double load_factor : helpers::load_factors(opts, 0.5, 0.95)) {
+      _run(size, load_factor, meter());
+    }
+  }
+}
+
+void TBBGrowableHashBuild::init(const RunOptions &opts) {
+  meter().set_opts(opts);
+  DwarfParams params = {{"device_type", to_string(opts.device_ty)},
+                        {"distribution", to_string(opts.distribution)}};
+  meter().set_params(params);
+  meter().set_device_info(host_device_info());
+  helpers::calibrate_peak_bandwidth(meter());
+}
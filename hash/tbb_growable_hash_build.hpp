@@ -0,0 +1,13 @@
+#pragma once
+#include "common/common.hpp"
+
+// GrowableHashBuild on the host with HostGrowableHashTable and TBB.
+class TBBGrowableHashBuild : public Dwarf {
+public:
+  TBBGrowableHashBuild();
+  void run(const RunOptions &opts) override;
+  void init(const RunOptions &opts) override;
+
+private:
+  void _run(const size_t buffer_size, double load_factor, Meter &meter);
+};
@@ -0,0 +1,258 @@
+
+#include "bucket_join.hpp"
+#include "common/dpcpp/bucket_hashtable.hpp"
+#include "join_helpers/join_helpers.hpp"
+
+template <class Key> class BucketJoinBuild;
+template <class Key> class BucketJoinCount;
+template <class Key> class BucketJoinProbe;
+
+BucketJoin::BucketJoin() : Dwarf("BucketJoin") {}
+using namespace join_helpers;
+void BucketJoin::_run(const size_t buf_size, double load_factor,
+                      Meter &meter) {
+  if (meter.opts().key_width == KeyWidth::Bits32) {
+    _run_keys<uint32_t>(buf_size, load_factor, meter);
+  } else {
+    _run_keys<uint64_t>(buf_size, load_factor, meter);
+  }
+}
+
+template <class Key>
+void BucketJoin::_run_keys(const size_t buf_size, double load_factor,
+                           Meter &meter) {
+  auto opts = meter.opts();
+
+  constexpr Key empty_element = std::numeric_limits<Key>::max();
+  const size_t probe_size = helpers::probe_rows(opts, buf_size);
+  const Column<Key> table_a_keys =
+      helpers::input_column<Key>(opts, "build_keys", buf_size, [&] {
+        return helpers::make_build_keys<Key>(opts, buf_size);
+      });
+  const Column<uint32_t> table_a_values =
+      helpers::input_column<uint32_t>(opts, "build_values", buf_size, [&] {
+        return helpers::make_unique_random(opts, "build_values", buf_size);
+      });
+
+  const Column<Key> table_b_keys =
+      helpers::input_column<Key>(opts, "probe_keys", probe_size, [&] {
+        return helpers::make_probe_keys<Key>(opts, buf_size);
+      });
+  const Column<uint32_t> table_b_values =
+      helpers::input_column<uint32_t>(opts, "probe_values", probe_size, [&] {
+        return helpers::make_unique_random(opts, "probe_values", probe_size);
+      });
+
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
+  JoinChecker<Key, uint32_t, uint32_t> verify(
+      opts, table_a_keys, table_a_values, table_b_keys, table_b_values);
+
+  using Table = BucketizedHashTable<Key, uint32_t, SimpleHasher<Key>>;
+  // Vector compares on CPUs, sub-groups on other devices.
+  const bool cooperative = !q.get_device().is_cpu();
+  const size_t buckets =
+      BucketHash::buckets_count(buf_size, Table::bucket_size, load_factor);
+  const size_t ht_size = buckets * Table::bucket_size;
+  SimpleHasher<Key> hasher(buckets);
+
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  params["probing"] = cooperative ? "sub_group" : "vector";
+  meter.measure(std::move(params), [&]() {
+    // hash table
+    std::vector<uint32_t> data(ht_size, 0);
+    std::vector<Key> keys(ht_size, empty_element);
+
+    // output rows of every probe row and their total
+    std::vector<uint32_t> total(1, 0);
+    std::vector<Key> key_out;
+    std::vector<uint32_t> val1_out;
+    std::vector<uint32_t> val2_out;
+    std::unique_ptr<HashJoinResult> result = std::make_unique<HashJoinResult>();
+    {
+      sycl::buffer<uint32_t> data_buf{sycl::range<1>{ht_size}};
+      sycl::buffer<Key> keys_buf{sycl::range<1>{ht_size}};
+
+      sycl::buffer<Key> key_a{sycl::range<1>{buf_size}};
+      sycl::buffer<uint32_t> val_a{sycl::range<1>{buf_size}};
+      sycl::buffer<Key> key_b{sycl::range<1>{probe_size}};
+      sycl::buffer<uint32_t> val_b{sycl::range<1>{probe_size}};
+
+      sycl::buffer<uint32_t> offsets_buf{sycl::range<1>{probe_size}};
+      sycl::buffer<uint32_t> total_buf{sycl::range<1>{1}};
+
+      EventProfiler profiler;
+      PerfCounters counters(opts.perf_counters && q.get_device().is_cpu());
+      counters.start();
+      auto host_start = std::chrono::steady_clock::now();
+      profiler.upload(q, data, data_buf);
+      profiler.upload(q, keys, keys_buf);
+      profiler.upload(q, table_a_keys, key_a);
+      profiler.upload(q, table_a_values, val_a);
+      sycl::event build = q.submit([&](sycl::handler &h) {
+        auto key_a_acc = key_a.get_access(h);
+        auto val_a_acc = val_a.get_access(h);
+
+        // ht data accessors
+        auto data_acc = data_buf.get_access(h);
+        auto keys_acc = keys_buf.get_access(h);
+
+        BucketHash::parallel_for<BucketJoinBuild<Key>>(
+            h, buf_size, cooperative,
+            [=](sycl::nd_item<1> it, auto cooperative) {
+              const size_t idx = BucketHash::key_index(it, cooperative);
+              if (idx >= buf_size)
+                return;
+              Table ht(buckets, keys_acc.get_pointer(),
+                       data_acc.get_pointer(), hasher, empty_element);
+
+              if constexpr (decltype(cooperative)::value) {
+                ht.insert(it.get_sub_group(), key_a_acc[idx], val_a_acc[idx]);
+              } else {
+                ht.insert(key_a_acc[idx], val_a_acc[idx]);
+              }
+            });
+      });
+      profiler.kernel(build, "join_build").wait();
+      auto build_end = std::chrono::steady_clock::now();
+
+      // Probe rows may match several build rows, so the first pass counts
+      // the matches and reserves output rows for them.
+      profiler.upload(q, table_b_keys, key_b);
+      profiler.upload(q, table_b_values, val_b);
+      profiler.upload(q, total, total_buf);
+      sycl::event count = q.submit([&](sycl::handler &h) {
+        auto key_b_acc = key_b.get_access(h);
+        auto offsets_acc = offsets_buf.get_access(h);
+        auto total_acc = total_buf.get_access(h);
+
+        // ht data accessors
+        auto data_acc = data_buf.get_access(h);
+        auto keys_acc = keys_buf.get_access(h);
+
+        BucketHash::parallel_for<BucketJoinCount<Key>>(
+            h, probe_size, cooperative,
+            [=](sycl::nd_item<1> it, auto cooperative) {
+              const size_t idx = BucketHash::key_index(it, cooperative);
+              if (idx >= probe_size)
+                return;
+              Table ht(buckets, keys_acc.get_pointer(),
+                       data_acc.get_pointer(), hasher, empty_element);
+              auto none = [](uint32_t, size_t) {};
+              uint32_t matches;
+              if constexpr (decltype(cooperative)::value) {
+                matches =
+                    ht.find_all(it.get_sub_group(), key_b_acc[idx], none);
+                // Lane 0 reserves the rows of a cooperative probe.
+                if (it.get_sub_group().get_local_id()[0] != 0)
+                  return;
+              } else {
+                matches = ht.find_all(key_b_acc[idx], none);
+              }
+              offsets_acc[idx] =
+                  matches ? sycl::atomic<uint32_t>(total_acc.get_pointer())
+                                .fetch_add(matches)
+                          : 0;
+            });
+      });
+      profiler.kernel(count, "join_count");
+      profiler.download(q, total_buf, total).wait();
+
+      const size_t out_size = std::max<size_t>(total[0], 1);
+      key_out.resize(out_size);
+      val1_out.resize(out_size);
+      val2_out.resize(out_size);
+      sycl::buffer<Key> out_key_buf{sycl::range<1>{out_size}};
+      sycl::buffer<uint32_t> out_val1_buf{sycl::range<1>{out_size}};
+      sycl::buffer<uint32_t> out_val2_buf{sycl::range<1>{out_size}};
+      sycl::event probe = q.submit([&](sycl::handler &h) {
+        auto key_b_acc = key_b.get_access(h);
+        auto val_b_acc = val_b.get_access(h);
+        auto offsets_acc = offsets_buf.get_access(h);
+
+        auto out_key_acc = out_key_buf.get_access(h);
+        auto out_val1_acc = out_val1_buf.get_access(h);
+        auto out_val2_acc = out_val2_buf.get_access(h);
+
+        // ht data accessors
+        auto data_acc = data_buf.get_access(h);
+        auto keys_acc = keys_buf.get_access(h);
+
+        BucketHash::parallel_for<BucketJoinProbe<Key>>(
+            h, probe_size, cooperative,
+            [=](sycl::nd_item<1> it, auto cooperative) {
+              const size_t idx = BucketHash::key_index(it, cooperative);
+              if (idx >= probe_size)
+                return;
+              Table ht(buckets, keys_acc.get_pointer(),
+                       data_acc.get_pointer(), hasher, empty_element);
+              const Key key = key_b_acc[idx];
+              auto write = [&](uint32_t val, size_t i) {
+                size_t at = offsets_acc[idx] + i;
+                out_key_acc[at] = key;
+                out_val1_acc[at] = val;
+                out_val2_acc[at] = val_b_acc[idx];
+              };
+              if constexpr (decltype(cooperative)::value) {
+                ht.find_all(it.get_sub_group(), key, write);
+              } else {
+                ht.find_all(key, write);
+              }
+            });
+      });
+      profiler.kernel(probe, "join_probe");
+      profiler.download(q, out_key_buf, key_out);
+      profiler.download(q, out_val1_buf, val1_out);
+      profiler.download(q, out_val2_buf, val2_out).wait();
+      auto host_end = std::chrono::steady_clock::now();
+      counters.stop();
+      key_out.resize(total[0]);
+      val1_out.resize(total[0]);
+      val2_out.resize(total[0]);
+
+      result->host_time = host_end - host_start;
+      result->build_time = build_end - host_start;
+      result->probe_time = host_end - build_end;
+      profiler.fill(*result);
+      counters.fill(*result);
+      if (opts.tracer) {
+        opts.tracer->span("build", "phase", host_start, build_end);
+        opts.tracer->span("probe", "phase", build_end, host_end);
+      }
+    }
+
+    TraceSpan check(opts.tracer, "check");
+    ColJoinedTableTy<Key, uint32_t, uint32_t> output = {
+        key_out, {val1_out, val2_out}};
+
+    result->rows = buf_size + probe_size;
+    result->bytes_read =
+        (buf_size + probe_size) * (sizeof(Key) + sizeof(uint32_t));
+    // Build writes the table, probe writes the matched rows.
+    result->bytes_written = (buf_size + key_out.size()) * sizeof(Key) +
+                            (buf_size + key_out.size() * 2) * sizeof(uint32_t);
+    result->table_bytes = ht_size * (sizeof(Key) + sizeof(uint32_t));
+
+    if (!verify(output)) {
+      std::cerr << "Incorrect results" << std::endl;
+      result->valid = false;
+    }
+
+    return result;
+  });
+}
+
+void BucketJoin::run(const RunOptions &opts) {
+  for (auto size : opts.input_size) {
+    for (double load_factor : helpers::load_factors(opts, 0.5)) {
+      _run(size, load_factor, meter());
+    }
+  }
+}
+void BucketJoin::init(const RunOptions &opts) {
+  meter().set_opts(opts);
+  DwarfParams params = input_params(opts);
+  params["device_type"] = to_string(opts.device_ty);
+  meter().set_params(params);
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+#include "common/common.hpp"
+
+class BucketJoin : public Dwarf {
+public:
+  BucketJoin();
+  void run(const RunOptions &opts) override;
+  void init(const RunOptions &opts) override;
+
+private:
+  void _run(const size_t buffer_size, double load_factor, Meter &meter);
+  template <class Key>
+  void _run_keys(const size_t buffer_size, double load_factor, Meter &meter);
+};
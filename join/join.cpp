@@ -3,148 +3,252 @@
 #include "common/dpcpp/hashtable.hpp"
 #include "join_helpers/join_helpers.hpp"
 
+template <class Key, class Hash, class Stats> class JoinBuild;
+template <class Key, class Hash, class Stats> class JoinCount;
+template <class Key, class Hash, class Stats> class JoinProbe;
+
 Join::Join() : Dwarf("Join") {}
 using namespace join_helpers;
-void Join::_run(const size_t buf_size, Meter &meter) {
+void Join::_run(const size_t buf_size, double load_factor, Meter &meter) {
+  if (meter.opts().key_width == KeyWidth::Bits32) {
+    _run_keys<uint32_t>(buf_size, load_factor, meter);
+  } else {
+    _run_keys<uint64_t>(buf_size, load_factor, meter);
+  }
+}
+
+template <class Key>
+void Join::_run_keys(const size_t buf_size, double load_factor,
+                     Meter &meter) {
+  const RunOptions &opts = meter.opts();
+  const size_t ht_size = hashed_table_size(
+      opts.hasher, helpers::table_capacity(buf_size, load_factor));
+  with_hasher(opts.hasher, ht_size, helpers::input_seed(opts, "hasher"),
+              SimpleHasher<Key>(ht_size), [&](auto hasher) {
+                with_probe_stats(opts.probe_stats, [&](auto stats) {
+                  _run_hashed<Key, decltype(hasher), decltype(stats)>(
+                      buf_size, load_factor, meter, hasher);
+                });
+              });
+}
+
+template <class Key, class Hash, class Stats>
+void Join::_run_hashed(const size_t buf_size, double load_factor,
+                       Meter &meter, Hash hasher) {
   auto opts = meter.opts();
 
-  constexpr uint32_t empty_element = std::numeric_limits<uint32_t>::max();
-  // todo: sizes
-  const std::vector<uint32_t> table_a_keys =
-      helpers::make_unique_random(buf_size);
-  const std::vector<uint32_t> table_a_values =
-      helpers::make_unique_random(table_a_keys.size());
-
-  const std::vector<uint32_t> table_b_keys =
-      helpers::make_unique_random(buf_size);
-  const std::vector<uint32_t> table_b_values =
-      helpers::make_unique_random(table_b_keys.size());
-
-  auto sel = get_device_selector(opts);
-  sycl::queue q{*sel};
-  std::cout << "Selected device: "
-            << q.get_device().get_info<sycl::info::device::name>() << "\n";
-  auto expected =
-      seq_join(table_a_keys, table_a_values, table_b_keys, table_b_values);
-
-  const size_t ht_size = buf_size * 2;
+  constexpr Key empty_element = std::numeric_limits<Key>::max();
+  const size_t probe_size = helpers::probe_rows(opts, buf_size);
+  const Column<Key> table_a_keys =
+      helpers::input_column<Key>(opts, "build_keys", buf_size, [&] {
+        return helpers::make_build_keys<Key>(opts, buf_size);
+      });
+  const Column<uint32_t> table_a_values =
+      helpers::input_column<uint32_t>(opts, "build_values", buf_size, [&] {
+        return helpers::make_unique_random(opts, "build_values", buf_size);
+      });
+
+  const Column<Key> table_b_keys =
+      helpers::input_column<Key>(opts, "probe_keys", probe_size, [&] {
+        return helpers::make_probe_keys<Key>(opts, buf_size);
+      });
+  const Column<uint32_t> table_b_values =
+      helpers::input_column<uint32_t>(opts, "probe_values", probe_size, [&] {
+        return helpers::make_unique_random(opts, "probe_values", probe_size);
+      });
+
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
+  JoinChecker<Key, uint32_t, uint32_t> verify(
+      opts, table_a_keys, table_a_values, table_b_keys, table_b_values);
+
+  const size_t ht_size = hashed_table_size(
+      opts.hasher, helpers::table_capacity(buf_size, load_factor));
   const size_t bitmask_sz = ht_size / 32 + 1;
-  SimpleHasher<uint32_t> hasher(ht_size);
 
-  for (unsigned it = 0; it < opts.iterations; ++it) {
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  meter.measure(std::move(params), [&]() {
     // hash table
     std::vector<uint32_t> bitmask(bitmask_sz, 0);
     std::vector<uint32_t> data(ht_size, 0);
-    std::vector<uint32_t> keys(ht_size, empty_element);
+    std::vector<Key> keys(ht_size, empty_element);
 
-    // testing
-    std::vector<uint32_t> key_out(buf_size, -1);
-    std::vector<uint32_t> key_present_out(buf_size, -1);
-    std::vector<uint32_t> val_out(buf_size, -1);
+    // output rows of every probe row and their total
+    std::vector<uint32_t> total(1, 0);
+    std::vector<Key> key_out;
+    std::vector<uint32_t> val1_out;
+    std::vector<uint32_t> val2_out;
     std::unique_ptr<HashJoinResult> result = std::make_unique<HashJoinResult>();
     {
-      sycl::buffer<uint32_t> bitmask_buf(bitmask);
-      sycl::buffer<uint32_t> data_buf(data);
-      sycl::buffer<uint32_t> keys_buf(keys);
-
-      sycl::buffer<uint32_t> key_a(table_a_keys);
-      sycl::buffer<uint32_t> val_a(table_a_values);
-      sycl::buffer<uint32_t> key_b(table_b_keys);
-      sycl::buffer<uint32_t> val_b(table_b_values);
-
-      sycl::buffer<uint32_t> out_key_buf(key_out);
-      sycl::buffer<uint32_t> out_key_present_buf(key_present_out);
-      sycl::buffer<uint32_t> out_val_buf(val_out);
-
+      sycl::buffer<uint32_t> bitmask_buf{sycl::range<1>{bitmask_sz}};
+      sycl::buffer<uint32_t> data_buf{sycl::range<1>{ht_size}};
+      sycl::buffer<Key> keys_buf{sycl::range<1>{ht_size}};
+
+      sycl::buffer<Key> key_a{sycl::range<1>{buf_size}};
+      sycl::buffer<uint32_t> val_a{sycl::range<1>{buf_size}};
+      sycl::buffer<Key> key_b{sycl::range<1>{probe_size}};
+      sycl::buffer<uint32_t> val_b{sycl::range<1>{probe_size}};
+
+      sycl::buffer<uint32_t> offsets_buf{sycl::range<1>{probe_size}};
+      sycl::buffer<uint32_t> total_buf{sycl::range<1>{1}};
+      // Lookups are counted once, by the count pass.
+      ProbeCounters probes(opts.probe_stats);
+
+      EventProfiler profiler;
+      PerfCounters counters(opts.perf_counters && q.get_device().is_cpu());
+      counters.start();
       auto host_start = std::chrono::steady_clock::now();
-      q.submit([&](sycl::handler &h) {
-         auto key_a_acc = key_a.get_access(h);
-         auto val_a_acc = val_a.get_access(h);
-
-         // ht data accessors
-         auto bitmask_acc = bitmask_buf.get_access(h);
-         auto data_acc = data_buf.get_access(h);
-         auto keys_acc = keys_buf.get_access(h);
-
-         h.parallel_for<class join_build>(buf_size, [=](auto &idx) {
-           SimpleNonOwningHashTable<uint32_t, uint32_t, SimpleHasher<uint32_t>>
-               ht(ht_size, keys_acc.get_pointer(), data_acc.get_pointer(),
-                  bitmask_acc.get_pointer(), hasher);
-
-           ht.insert(key_a_acc[idx], val_a_acc[idx]);
-         });
-         q.wait();
-       }).wait();
+      profiler.upload(q, bitmask, bitmask_buf);
+      profiler.upload(q, data, data_buf);
+      profiler.upload(q, keys, keys_buf);
+      profiler.upload(q, table_a_keys, key_a);
+      profiler.upload(q, table_a_values, val_a);
+      sycl::event build = q.submit([&](sycl::handler &h) {
+        auto key_a_acc = key_a.get_access(h);
+        auto val_a_acc = val_a.get_access(h);
+
+        // ht data accessors
+        auto bitmask_acc = bitmask_buf.get_access(h);
+        auto data_acc = data_buf.get_access(h);
+        auto keys_acc = keys_buf.get_access(h);
+        auto probes_acc = probes.access<Stats>(h);
+
+        h.parallel_for<JoinBuild<Key, Hash, Stats>>(buf_size, [=](auto &idx) {
+          SimpleNonOwningHashTable<Key, uint32_t, Hash, Stats> ht(
+              ht_size, keys_acc.get_pointer(), data_acc.get_pointer(),
+              bitmask_acc.get_pointer(), hasher,
+              Stats(probes_acc.get_pointer()));
+
+          ht.insert(key_a_acc[idx], val_a_acc[idx]);
+        });
+      });
+      profiler.kernel(build, "join_build").wait();
       auto build_end = std::chrono::steady_clock::now();
 
-      q.submit([&](sycl::handler &h) {
-         auto key_b_acc = key_b.get_access(h);
-         auto val_b_acc = val_b.get_access(h);
-
-         auto out_key_acc = out_key_buf.get_access(h);
-         auto out_key_present_acc = out_key_present_buf.get_access(h);
-         auto out_val_acc = out_val_buf.get_access(h);
-
-         // ht data accessors
-         auto bitmask_acc = bitmask_buf.get_access(h);
-         auto data_acc = data_buf.get_access(h);
-         auto keys_acc = keys_buf.get_access(h);
-
-         h.parallel_for<class join_probe>(buf_size, [=](auto &idx) {
-           SimpleNonOwningHashTable<uint32_t, uint32_t, SimpleHasher<uint32_t>>
-               ht(ht_size, keys_acc.get_pointer(), data_acc.get_pointer(),
-                  bitmask_acc.get_pointer(), hasher);
-           auto ans = ht.at(key_b_acc[idx]);
-           if (ans.second) {
-             out_key_acc[idx] = key_b_acc[idx];
-             out_key_present_acc[idx] = ans.first;
-             out_val_acc[idx] = val_b_acc[idx];
-           }
-         });
-       }).wait();
+      // Probe rows may match several build rows, so the first pass counts
+      // the matches and reserves output rows for them.
+      profiler.upload(q, table_b_keys, key_b);
+      profiler.upload(q, table_b_values, val_b);
+      profiler.upload(q, total, total_buf);
+      sycl::event count = q.submit([&](sycl::handler &h) {
+        auto key_b_acc = key_b.get_access(h);
+        auto offsets_acc = offsets_buf.get_access(h);
+        auto total_acc = total_buf.get_access(h);
+
+        // ht data accessors
+        auto bitmask_acc = bitmask_buf.get_access(h);
+        auto data_acc = data_buf.get_access(h);
+        auto keys_acc = keys_buf.get_access(h);
+        auto probes_acc = probes.access<Stats>(h);
+
+        h.parallel_for<JoinCount<Key, Hash, Stats>>(probe_size, [=](auto &idx) {
+          SimpleNonOwningHashTable<Key, uint32_t, Hash, Stats> ht(
+              ht_size, keys_acc.get_pointer(), data_acc.get_pointer(),
+              bitmask_acc.get_pointer(), hasher,
+              Stats(probes_acc.get_pointer()));
+          uint32_t matches =
+              ht.find_all(key_b_acc[idx], [](uint32_t, size_t) {});
+          offsets_acc[idx] =
+              matches ? sycl::atomic<uint32_t>(total_acc.get_pointer())
+                            .fetch_add(matches)
+                      : 0;
+        });
+      });
+      profiler.kernel(count, "join_count");
+      profiler.download(q, total_buf, total).wait();
+
+      const size_t out_size = std::max<size_t>(total[0], 1);
+      key_out.resize(out_size);
+      val1_out.resize(out_size);
+      val2_out.resize(out_size);
+      sycl::buffer<Key> out_key_buf{sycl::range<1>{out_size}};
+      sycl::buffer<uint32_t> out_val1_buf{sycl::range<1>{out_size}};
+      sycl::buffer<uint32_t> out_val2_buf{sycl::range<1>{out_size}};
+      sycl::event probe = q.submit([&](sycl::handler &h) {
+        auto key_b_acc = key_b.get_access(h);
+        auto val_b_acc = val_b.get_access(h);
+        auto offsets_acc = offsets_buf.get_access(h);
+
+        auto out_key_acc = out_key_buf.get_access(h);
+        auto out_val1_acc = out_val1_buf.get_access(h);
+        auto out_val2_acc = out_val2_buf.get_access(h);
+
+        // ht data accessors
+        auto bitmask_acc = bitmask_buf.get_access(h);
+        auto data_acc = data_buf.get_access(h);
+        auto keys_acc = keys_buf.get_access(h);
+
+        h.parallel_for<JoinProbe<Key, Hash, Stats>>(probe_size, [=](auto &idx) {
+          SimpleNonOwningHashTable<Key, uint32_t, Hash> ht(
+              ht_size, keys_acc.get_pointer(), data_acc.get_pointer(),
+              bitmask_acc.get_pointer(), hasher);
+          const Key key = key_b_acc[idx];
+          ht.find_all(key, [&](uint32_t val, size_t i) {
+            size_t at = offsets_acc[idx] + i;
+            out_key_acc[at] = key;
+            out_val1_acc[at] = val;
+            out_val2_acc[at] = val_b_acc[idx];
+          });
+        });
+      });
+      profiler.kernel(probe, "join_probe");
+      profiler.download(q, out_key_buf, key_out);
+      profiler.download(q, out_val1_buf, val1_out);
+      profiler.download(q, out_val2_buf, val2_out).wait();
       auto host_end = std::chrono::steady_clock::now();
-      auto host_exe_time =
-          std::chrono::duration_cast<std::chrono::microseconds>(host_end -
-                                                                host_start)
-              .count();
+      counters.stop();
+      key_out.resize(total[0]);
+      val1_out.resize(total[0]);
+      val2_out.resize(total[0]);
 
       result->host_time = host_end - host_start;
       result->build_time = build_end - host_start;
       result->probe_time = host_end - build_end;
-
-      std::vector<uint32_t> res_k;
-      std::vector<uint32_t> res_present;
-      std::vector<uint32_t> res_val;
-
-      for (int i = 0; i < buf_size; i++) {
-        if (key_out[i] != empty_element) {
-          res_k.push_back(key_out[i]);
-          res_present.push_back(key_present_out[i]);
-          res_val.push_back(val_out[i]);
-        }
+      profiler.fill(*result);
+      counters.fill(*result);
+      probes.fill(*result);
+      if (opts.tracer) {
+        opts.tracer->span("build", "phase", host_start, build_end);
+        opts.tracer->span("probe", "phase", build_end, host_end);
       }
-      ColJoinedTableTy<uint32_t, uint32_t, uint32_t> output = {
-          res_k, {res_present, res_val}};
+    }
 
-      if (output != expected) {
-        std::cerr << "Incorrect results" << std::endl;
-        result->valid = false;
-      }
+    TraceSpan check(opts.tracer, "check");
+    ColJoinedTableTy<Key, uint32_t, uint32_t> output = {
+        key_out, {val1_out, val2_out}};
+
+    result->rows = buf_size + probe_size;
+    result->bytes_read =
+        (buf_size + probe_size) * (sizeof(Key) + sizeof(uint32_t));
+    // Build writes the table, probe writes the matched rows.
+    result->bytes_written = (buf_size + key_out.size()) * sizeof(Key) +
+                            (buf_size + key_out.size() * 2) * sizeof(uint32_t);
+    result->table_bytes = ht_size * (sizeof(Key) + sizeof(uint32_t)) +
+                          bitmask_sz * sizeof(uint32_t);
+
+    if (!verify(output)) {
+      std::cerr << "Incorrect results" << std::endl;
+      result->valid = false;
     }
 
-    DwarfParams params{{"buf_size", std::to_string(buf_size)}};
-    meter.add_result(std::move(params), std::move(result));
-    // todo: scale factor?
-  }
+    return result;
+  });
 }
 
 void Join::run(const RunOptions &opts) {
   for (auto size : opts.input_size) {
-    _run(size, meter());
+    for (double load_factor : helpers::load_factors(opts, 0.5)) {
+      _run(size, load_factor, meter());
+    }
   }
 }
 void Join::init(const RunOptions &opts) {
   meter().set_opts(opts);
-  DwarfParams params = {{"device_type", to_string(opts.device_ty)}};
+  DwarfParams params = input_params(opts);
+  params["device_type"] = to_string(opts.device_ty);
+  params["hasher"] = to_string(opts.hasher);
+  if (opts.probe_stats)
+    params["probe_stats"] = "true";
   meter().set_params(params);
 }
\ No newline at end of file
@@ -1,5 +1,12 @@
 #pragma once
 #include "common/common.hpp"
+#include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/parallel_scan.h>
+#include <oneapi/tbb/parallel_sort.h>
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <unordered_set>
 
 namespace join_helpers {
 
@@ -72,11 +79,107 @@ std::ostream &operator<<(std::ostream &os,
   return os;
 }
 
-template <class K, class V1, class V2>
-ColJoinedTableTy<K, V1, V2>
-seq_join(const std::vector<K> &a_keys, const std::vector<V1> &a_vals,
-         const std::vector<K> &b_keys, const std::vector<V2> &b_vals) {
-  ColJoinedTableTy<K, V1, V2> result;
+// Shape of the generated inputs of join dwarfs, for their params.
+inline DwarfParams input_params(const RunOptions &opts) {
+  auto str = [](double v) {
+    std::ostringstream os;
+    os << v;
+    return os.str();
+  };
+  return {{"probe_ratio", str(opts.probe_ratio)},
+          {"match_rate", str(opts.match_rate)},
+          {"build_duplicates", std::to_string(opts.build_duplicates)},
+          {"probe_duplicates", std::to_string(opts.probe_duplicates)},
+          {"key_width", to_string(opts.key_width)},
+          {"verify", to_string(opts.verify)}};
+}
+
+// Radix partitioning of the partitioned joins: `passes` passes over the
+// rows, each splitting every partition by the next `bits` bits of the hash.
+struct RadixPartitioning {
+  unsigned bits = 0;
+  size_t passes = 1;
+
+  size_t fanout() const { return size_t(1) << bits; }
+  unsigned total_bits() const { return bits * passes; }
+  size_t partitions() const { return size_t(1) << total_bits(); }
+};
+
+// Build rows per partition of the default fanout. Their table of 32-bit keys
+// and values at load factor 0.5 takes 64 KiB, which stays in the L2 cache of
+// CPUs and GPUs while the partition is probed.
+constexpr size_t PARTITION_ROWS = 4096;
+constexpr unsigned MAX_PARTITION_BITS = 24;
+
+// --partition_fanout and --partition_passes, with the fanout that makes
+// partitions of `build_rows` rows fit in the cache if none is given.
+inline RadixPartitioning radix_partitioning(const RunOptions &opts,
+                                            size_t build_rows) {
+  const size_t fanout = opts.partition_fanout;
+  if (opts.partition_passes == 0)
+    throw std::invalid_argument("Radix partitioning needs at least one pass");
+  if (fanout && (fanout < 2 || (fanout & (fanout - 1)) != 0))
+    throw std::invalid_argument("Partition fanout " + std::to_string(fanout) +
+                                " is not a power of two above 1");
+
+  RadixPartitioning p;
+  p.passes = opts.partition_passes;
+  if (fanout) {
+    while (p.fanout() < fanout) {
+      ++p.bits;
+    }
+  } else {
+    unsigned total = 0;
+    while ((PARTITION_ROWS << total) < build_rows) {
+      ++total;
+    }
+    p.bits = (total + p.passes - 1) / p.passes;
+  }
+  if (p.total_bits() > MAX_PARTITION_BITS)
+    throw std::invalid_argument("Radix partitioning into more than 2^" +
+                                std::to_string(MAX_PARTITION_BITS) +
+                                " partitions");
+  return p;
+}
+
+// Hash of join keys for radix partitioning, on the host and in kernels: the
+// partition of a row is the top bits of the hash and its slot in the table
+// of the partition the bits below them.
+inline uint64_t radix_hash(uint64_t key) { return key * 0x9e3779b97f4a7c15ull; }
+inline size_t radix_partition(uint64_t hash, unsigned bits) {
+  return bits ? hash >> (64 - bits) : 0;
+}
+// For tables of 2^slot_bits slots, at least two.
+inline size_t radix_slot(uint64_t hash, unsigned bits, unsigned slot_bits) {
+  return (hash << bits) >> (64 - slot_bits);
+}
+
+// Offsets of the tables of all partitions from the offsets of their build
+// rows: every table takes a power of two of at least two slots, above the
+// rows and enough for `load_factor`, so that probing ends at an empty slot.
+inline std::vector<uint64_t>
+partition_tables(const std::vector<uint32_t> &build_offsets,
+                 double load_factor) {
+  std::vector<uint64_t> out(build_offsets.size(), 0);
+  for (size_t p = 0; p + 1 < build_offsets.size(); ++p) {
+    const size_t rows = build_offsets[p + 1] - build_offsets[p];
+    size_t slots = 2;
+    while (slots <= rows || slots * load_factor < rows) {
+      slots <<= 1;
+    }
+    out[p + 1] = out[p] + slots;
+  }
+  return out;
+}
+
+// Columns are std::vector or Column of the same key type.
+template <class KeysA, class ValsA, class KeysB, class ValsB,
+          class K = typename KeysA::value_type,
+          class V1 = typename ValsA::value_type,
+          class V2 = typename ValsB::value_type>
+ColJoinedTableTy<K, V1, V2> seq_join(const KeysA &a_keys, const ValsA &a_vals,
+                                     const KeysB &b_keys,
+                                     const ValsB &b_vals) {
   std::vector<K> keys;
   std::vector<V1> vals1;
   std::vector<V2> vals2;
@@ -93,6 +196,160 @@ seq_join(const std::vector<K> &a_keys, const std::vector<V1> &a_vals,
   return {keys, {vals1, vals2}};
 }
 
+struct AllKeys {
+  template <class K> bool operator()(const K &) const { return true; }
+};
+
+// Same rows as seq_join in O(n + m): a parallel hash join on TBB. Build rows
+// are inserted by row index into a linear probing table with CAS, so keys
+// with duplicates get one slot per row. Only probe rows with keys accepted
+// by `filter` are joined.
+template <class KeysA, class ValsA, class KeysB, class ValsB,
+          class Filter = AllKeys, class K = typename KeysA::value_type,
+          class V1 = typename ValsA::value_type,
+          class V2 = typename ValsB::value_type>
+ColJoinedTableTy<K, V1, V2>
+hash_join(const KeysA &a_keys, const ValsA &a_vals, const KeysB &b_keys,
+          const ValsB &b_vals, Filter filter = Filter()) {
+  using Range = oneapi::tbb::blocked_range<size_t>;
+  unsigned bits = 1;
+  while ((size_t(1) << bits) < 2 * a_keys.size()) {
+    ++bits;
+  }
+  const size_t mask = (size_t(1) << bits) - 1;
+  auto slot = [&](const K &key) {
+    return (std::hash<K>()(key) * 0x9e3779b97f4a7c15ull) >> (64 - bits);
+  };
+
+  // Build row index + 1 in every slot, 0 when empty.
+  std::unique_ptr<std::atomic<size_t>[]> table(
+      new std::atomic<size_t>[mask + 1]);
+  oneapi::tbb::parallel_for(Range(0, mask + 1), [&](const Range &r) {
+    for (size_t i = r.begin(); i != r.end(); ++i) {
+      table[i].store(0, std::memory_order_relaxed);
+    }
+  });
+  oneapi::tbb::parallel_for(Range(0, a_keys.size()), [&](const Range &r) {
+    for (size_t i = r.begin(); i != r.end(); ++i) {
+      size_t at = slot(a_keys[i]);
+      size_t empty = 0;
+      while (!table[at].compare_exchange_strong(empty, i + 1,
+                                                std::memory_order_relaxed)) {
+        empty = 0;
+        at = (at + 1) & mask;
+      }
+    }
+  });
+  auto for_each_match = [&](const K &key, auto f) {
+    size_t at = slot(key);
+    while (size_t row = table[at].load(std::memory_order_relaxed)) {
+      if (a_keys[row - 1] == key)
+        f(row - 1);
+      at = (at + 1) & mask;
+    }
+  };
+
+  // Output rows of every probe row, then their offsets.
+  std::vector<size_t> offsets(b_keys.size() + 1, 0);
+  oneapi::tbb::parallel_for(Range(0, b_keys.size()), [&](const Range &r) {
+    for (size_t i = r.begin(); i != r.end(); ++i) {
+      if (filter(b_keys[i]))
+        for_each_match(b_keys[i], [&](size_t) { ++offsets[i + 1]; });
+    }
+  });
+  oneapi::tbb::parallel_scan(
+      Range(0, offsets.size()), size_t(0),
+      [&](const Range &r, size_t sum, bool final) {
+        for (size_t i = r.begin(); i != r.end(); ++i) {
+          sum += offsets[i];
+          if (final)
+            offsets[i] = sum;
+        }
+        return sum;
+      },
+      std::plus<size_t>());
+
+  const size_t rows = offsets.back();
+  ColJoinedTableTy<K, V1, V2> res = {
+      std::vector<K>(rows), {std::vector<V1>(rows), std::vector<V2>(rows)}};
+  oneapi::tbb::parallel_for(Range(0, b_keys.size()), [&](const Range &r) {
+    for (size_t i = r.begin(); i != r.end(); ++i) {
+      if (offsets[i] == offsets[i + 1])
+        continue;
+      size_t at = offsets[i];
+      for_each_match(b_keys[i], [&](size_t row) {
+        res.first[at] = b_keys[i];
+        res.second.first[at] = a_vals[row];
+        res.second.second[at++] = b_vals[i];
+      });
+    }
+  });
+  return res;
+}
+
+// Whether the tables have the same rows in any order, by sorting copies of
+// both in parallel.
+template <class K, class V1, class V2>
+bool same_rows(const ColJoinedTableTy<K, V1, V2> &t1,
+               const ColJoinedTableTy<K, V1, V2> &t2) {
+  if (get_size(t1) != get_size(t2))
+    return false;
+  auto rows1 = to_row_store(t1);
+  auto rows2 = to_row_store(t2);
+  oneapi::tbb::parallel_sort(rows1.begin(), rows1.end());
+  oneapi::tbb::parallel_sort(rows2.begin(), rows2.end());
+  return rows1 == rows2;
+}
+
+// Checks the output of a join dwarf as set by --verify. The reference rows
+// are computed once, for all rows or for the probe rows of a sample of keys.
+template <class K, class V1, class V2> class JoinChecker {
+public:
+  template <class KeysA, class ValsA, class KeysB, class ValsB>
+  JoinChecker(const RunOptions &opts, const KeysA &a_keys,
+              const ValsA &a_vals, const KeysB &b_keys, const ValsB &b_vals)
+      : mode_(opts.verify) {
+    if (mode_ == RunOptions::Verification::None)
+      return;
+    if (mode_ == RunOptions::Verification::Sample && !b_keys.empty()) {
+      std::mt19937_64 gen(helpers::input_seed(opts, "verify"));
+      std::uniform_int_distribution<size_t> row(0, b_keys.size() - 1);
+      for (size_t i = 0; i < sample_size; ++i) {
+        sample_.insert(b_keys[row(gen)]);
+      }
+    }
+    expected_ = hash_join(a_keys, a_vals, b_keys, b_vals,
+                          [&](const K &key) { return sampled(key); });
+  }
+
+  bool operator()(const ColJoinedTableTy<K, V1, V2> &output) const {
+    if (mode_ != RunOptions::Verification::Sample)
+      return mode_ == RunOptions::Verification::None ||
+             same_rows(output, expected_);
+
+    ColJoinedTableTy<K, V1, V2> sampled_rows;
+    for (size_t i = 0; i < get_size(output); ++i) {
+      if (sampled(output.first[i])) {
+        sampled_rows.first.push_back(output.first[i]);
+        sampled_rows.second.first.push_back(output.second.first[i]);
+        sampled_rows.second.second.push_back(output.second.second[i]);
+      }
+    }
+    return same_rows(sampled_rows, expected_);
+  }
+
+private:
+  static constexpr size_t sample_size = 1024;
+
+  bool sampled(const K &key) const {
+    return mode_ != RunOptions::Verification::Sample || sample_.count(key);
+  }
+
+  RunOptions::Verification mode_;
+  std::unordered_set<K> sample_;
+  ColJoinedTableTy<K, V1, V2> expected_;
+};
+
 template <class K, class V1, class V2>
 bool operator==(const ColJoinedTableTy<K, V1, V2> &t1,
                 const ColJoinedTableTy<K, V1, V2> &t2) {
@@ -108,8 +365,8 @@ bool operator==(const RowJoinedTableTy<K, V1, V2> &t1,
   auto temp1 = t1;
   auto temp2 = t2;
 
-  std::sort(temp1);
-  std::sort(temp2);
+  std::sort(temp1.begin(), temp1.end());
+  std::sort(temp2.begin(), temp2.end());
 
   return temp1 == temp2;
 }
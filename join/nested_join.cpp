@@ -10,75 +10,100 @@ NestedLoopJoin::NestedLoopJoin() : Dwarf("NestedLoopJoin") {}
 void NestedLoopJoin::_run(const size_t buf_size, Meter &meter) {
   auto opts = meter.opts();
 
-  const std::vector<uint32_t> table_a_keys =
-      helpers::make_random<uint32_t>(buf_size);
-  const std::vector<uint32_t> table_a_values =
-      helpers::make_random<uint32_t>(table_a_keys.size());
-
-  const std::vector<uint32_t> table_b_keys =
-      helpers::make_random<uint32_t>(buf_size);
-  const std::vector<uint32_t> table_b_values =
-      helpers::make_random<uint32_t>(table_b_keys.size());
-
-  auto sel = get_device_selector(opts);
-  sycl::queue q{*sel};
-  std::cout << "Selected device: "
-            << q.get_device().get_info<sycl::info::device::name>() << "\n";
-
-  std::vector<uint32_t> key_out(buf_size * buf_size, 0);
-  std::vector<uint32_t> val1_out(buf_size * buf_size, -1);
-  std::vector<uint32_t> val2_out(buf_size * buf_size, -1);
-
-  auto expected = join_helpers::seq_join(table_a_keys, table_a_values,
-                                         table_b_keys, table_b_values);
-
-  for (auto it = 0; it < opts.iterations; ++it) {
+  const size_t probe_size = helpers::probe_rows(opts, buf_size);
+  const Column<uint32_t> table_a_keys =
+      helpers::input_column<uint32_t>(opts, "build_keys", buf_size, [&] {
+        return helpers::make_build_keys(opts, buf_size);
+      });
+  const Column<uint32_t> table_a_values =
+      helpers::input_column<uint32_t>(opts, "build_values", buf_size, [&] {
+        return helpers::make_random<uint32_t>(opts, "build_values", buf_size);
+      });
+
+  const Column<uint32_t> table_b_keys =
+      helpers::input_column<uint32_t>(opts, "probe_keys", probe_size, [&] {
+        return helpers::make_probe_keys(opts, buf_size);
+      });
+  const Column<uint32_t> table_b_values =
+      helpers::input_column<uint32_t>(opts, "probe_values", probe_size, [&] {
+        return helpers::make_random<uint32_t>(opts, "probe_values",
+                                              probe_size);
+      });
+
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
+
+  const size_t out_size = buf_size * probe_size;
+  std::vector<uint32_t> key_out(out_size, 0);
+  std::vector<uint32_t> val1_out(out_size, -1);
+  std::vector<uint32_t> val2_out(out_size, -1);
+
+  join_helpers::JoinChecker<uint32_t, uint32_t, uint32_t> verify(
+      opts, table_a_keys, table_a_values, table_b_keys, table_b_values);
+
+  DwarfParams params{{"buf_size", std::to_string(buf_size)}};
+  meter.measure(std::move(params), [&]() {
     std::unique_ptr<Result> result = std::make_unique<Result>();
 
     {
-      sycl::buffer<uint32_t> key_a(table_a_keys);
-      sycl::buffer<uint32_t> val_a(table_a_values);
-      sycl::buffer<uint32_t> key_b(table_b_keys);
-      sycl::buffer<uint32_t> val_b(table_b_values);
+      sycl::buffer<uint32_t> key_a{sycl::range<1>{buf_size}};
+      sycl::buffer<uint32_t> val_a{sycl::range<1>{buf_size}};
+      sycl::buffer<uint32_t> key_b{sycl::range<1>{probe_size}};
+      sycl::buffer<uint32_t> val_b{sycl::range<1>{probe_size}};
 
-      sycl::buffer<uint32_t> out_key_b(key_out);
-      sycl::buffer<uint32_t> out_val1_b(val1_out);
-      sycl::buffer<uint32_t> out_val2_b(val2_out);
+      sycl::buffer<uint32_t> out_key_b{sycl::range<1>{out_size}};
+      sycl::buffer<uint32_t> out_val1_b{sycl::range<1>{out_size}};
+      sycl::buffer<uint32_t> out_val2_b{sycl::range<1>{out_size}};
 
+      EventProfiler profiler;
       auto host_start = std::chrono::steady_clock::now();
-      q.submit([&](sycl::handler &h) {
-         auto key_a_acc = sycl::accessor(key_a, h, sycl::read_only);
-         auto val_a_acc = sycl::accessor(val_a, h, sycl::read_only);
-
-         auto key_b_acc = sycl::accessor(key_b, h, sycl::read_only);
-         auto val_b_acc = sycl::accessor(val_b, h, sycl::read_only);
-
-         auto out_key_acc = sycl::accessor(out_key_b, h, sycl::read_write);
-         auto out_val1_acc = sycl::accessor(out_val1_b, h, sycl::read_write);
-         auto out_val2_acc = sycl::accessor(out_val2_b, h, sycl::read_write);
-
-         h.parallel_for<class nested_join>(buf_size, [=](auto &it) {
-           uint32_t key = key_a_acc[it];
-           uint32_t val = val_a_acc[it];
-           for (int i = 0; i < buf_size; i++) {
-             if (key_b_acc[i] == key) {
-               out_key_acc[it * buf_size + i] = key;
-               out_val1_acc[it * buf_size + i] = val;
-               out_val2_acc[it * buf_size + i] = val_b_acc[i];
-             }
-           }
-         });
-       }).wait();
+      profiler.upload(q, table_a_keys, key_a);
+      profiler.upload(q, table_a_values, val_a);
+      profiler.upload(q, table_b_keys, key_b);
+      profiler.upload(q, table_b_values, val_b);
+      profiler.upload(q, key_out, out_key_b);
+      profiler.upload(q, val1_out, out_val1_b);
+      profiler.upload(q, val2_out, out_val2_b);
+      sycl::event join = q.submit([&](sycl::handler &h) {
+        auto key_a_acc = sycl::accessor(key_a, h, sycl::read_only);
+        auto val_a_acc = sycl::accessor(val_a, h, sycl::read_only);
+
+        auto key_b_acc = sycl::accessor(key_b, h, sycl::read_only);
+        auto val_b_acc = sycl::accessor(val_b, h, sycl::read_only);
+
+        auto out_key_acc = sycl::accessor(out_key_b, h, sycl::read_write);
+        auto out_val1_acc = sycl::accessor(out_val1_b, h, sycl::read_write);
+        auto out_val2_acc = sycl::accessor(out_val2_b, h, sycl::read_write);
+
+        h.parallel_for<class nested_join>(buf_size, [=](auto &it) {
+          uint32_t key = key_a_acc[it];
+          uint32_t val = val_a_acc[it];
+          for (int i = 0; i < probe_size; i++) {
+            if (key_b_acc[i] == key) {
+              out_key_acc[it * probe_size + i] = key;
+              out_val1_acc[it * probe_size + i] = val;
+              out_val2_acc[it * probe_size + i] = val_b_acc[i];
+            }
+          }
+        });
+      });
+      profiler.kernel(join, "nested_join");
+      profiler.download(q, out_key_b, key_out);
+      profiler.download(q, out_val1_b, val1_out);
+      profiler.download(q, out_val2_b, val2_out).wait();
       auto host_end = std::chrono::steady_clock::now();
 
       result->host_time = host_end - host_start;
+      profiler.fill(*result);
     }
 
+    TraceSpan check(opts.tracer, "check");
     std::vector<uint32_t> res_k;
     std::vector<uint32_t> res1;
     std::vector<uint32_t> res2;
 
-    for (int i = 0; i < buf_size * buf_size; i++) {
+    for (int i = 0; i < out_size; i++) {
       if (key_out[i] != ((uint32_t)0)) {
         res_k.push_back(key_out[i]);
         res1.push_back(val1_out[i]);
@@ -89,14 +114,17 @@ void NestedLoopJoin::_run(const size_t buf_size, Meter &meter) {
     join_helpers::ColJoinedTableTy<uint32_t, uint32_t, uint32_t> output = {
         res_k, {res1, res2}};
 
-    if (output != expected) {
+    result->rows = buf_size + probe_size;
+    result->bytes_read = 2 * (buf_size + probe_size) * sizeof(uint32_t);
+    result->bytes_written = res_k.size() * 3 * sizeof(uint32_t);
+
+    if (!verify(output)) {
       std::cerr << "Incorrect results" << std::endl;
       result->valid = false;
     }
 
-    DwarfParams params{{"buf_size", std::to_string(buf_size)}};
-    meter.add_result(std::move(params), std::move(result));
-  }
+    return result;
+  });
 }
 
 void NestedLoopJoin::run(const RunOptions &opts) {
@@ -106,6 +134,7 @@ void NestedLoopJoin::run(const RunOptions &opts) {
 }
 void NestedLoopJoin::init(const RunOptions &opts) {
   meter().set_opts(opts);
-  DwarfParams params = {{"device_type", to_string(opts.device_ty)}};
+  DwarfParams params = join_helpers::input_params(opts);
+  params["device_type"] = to_string(opts.device_ty);
   meter().set_params(params);
 }
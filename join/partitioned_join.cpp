@@ -0,0 +1,443 @@
+#include "partitioned_join.hpp"
+#include "common/dpcpp/dpcpp_common.hpp"
+#include "join_helpers/join_helpers.hpp"
+
+template <class Key> class PartitionHistogram;
+template <class Key> class PartitionScatter;
+template <class Key> class PartitionSplitHistogram;
+template <class Key> class PartitionSplitScatter;
+template <class Key> class PartitionedJoinBuild;
+template <class Key> class PartitionedJoinCount;
+template <class Key> class PartitionedJoinProbe;
+
+using namespace join_helpers;
+
+namespace {
+using LocalCounters =
+    sycl::accessor<uint32_t, 1, sycl::access::mode::read_write,
+                   sycl::access::target::local>;
+using LocalAtomic =
+    sycl::atomic<uint32_t, sycl::access::address_space::local_space>;
+
+// Work-items splitting one partition in the passes after the first.
+constexpr size_t SPLIT_GROUP_SIZE = 256;
+
+// The first radix pass: scatters the rows to `out_keys` and `out_vals`
+// ordered by the top `bits` bits of their hashes, partition p taking rows
+// offsets[p] to offsets[p + 1]. Rows of a partition are in no particular
+// order.
+template <class Key>
+void partition_pass(sycl::queue &q, EventProfiler &profiler, size_t rows,
+                    unsigned bits, sycl::buffer<Key> &keys,
+                    sycl::buffer<uint32_t> &vals, sycl::buffer<Key> &out_keys,
+                    sycl::buffer<uint32_t> &out_vals,
+                    std::vector<uint32_t> &offsets) {
+  const size_t parts = size_t(1) << bits;
+  std::vector<uint32_t> histogram(parts, 0);
+  sycl::buffer<uint32_t> histogram_buf{sycl::range<1>{parts}};
+  sycl::buffer<uint32_t> cursors_buf{sycl::range<1>{parts}};
+
+  profiler.upload(q, histogram, histogram_buf);
+  sycl::event count = q.submit([&](sycl::handler &h) {
+    auto k = sycl::accessor(keys, h, sycl::read_only);
+    auto c = histogram_buf.get_access(h);
+
+    h.parallel_for<PartitionHistogram<Key>>(rows, [=](sycl::id<1> i) {
+      const size_t p = radix_partition(radix_hash(k[i]), bits);
+      sycl::atomic<uint32_t>(c.get_pointer() + p).fetch_add(1);
+    });
+  });
+  profiler.kernel(count, "partition_histogram");
+  profiler.download(q, histogram_buf, histogram).wait();
+
+  offsets.assign(parts + 1, 0);
+  for (size_t p = 0; p < parts; ++p) {
+    offsets[p + 1] = offsets[p] + histogram[p];
+  }
+
+  profiler.upload(q, offsets.data(), cursors_buf);
+  sycl::event scatter = q.submit([&](sycl::handler &h) {
+    auto k = sycl::accessor(keys, h, sycl::read_only);
+    auto v = sycl::accessor(vals, h, sycl::read_only);
+    auto out_k = sycl::accessor(out_keys, h, sycl::write_only);
+    auto out_v = sycl::accessor(out_vals, h, sycl::write_only);
+    auto c = cursors_buf.get_access(h);
+
+    h.parallel_for<PartitionScatter<Key>>(rows, [=](sycl::id<1> i) {
+      const size_t p = radix_partition(radix_hash(k[i]), bits);
+      const uint32_t at =
+          sycl::atomic<uint32_t>(c.get_pointer() + p).fetch_add(1);
+      out_k[at] = k[i];
+      out_v[at] = v[i];
+    });
+  });
+  profiler.kernel(scatter, "partition_scatter");
+}
+
+// A later radix pass, splitting every partition of the previous passes
+// (rows offsets[s] to offsets[s + 1]) by the next `pass_bits` bits, up to
+// `bits` bits in all. Work-group s counts and scatters the rows of
+// partition s with cursors in local memory, so rows only move within their
+// partition and each group writes to 2^pass_bits places at a time.
+template <class Key>
+void split_pass(sycl::queue &q, EventProfiler &profiler, unsigned bits,
+                unsigned pass_bits, sycl::buffer<Key> &keys,
+                sycl::buffer<uint32_t> &vals, sycl::buffer<Key> &out_keys,
+                sycl::buffer<uint32_t> &out_vals,
+                std::vector<uint32_t> &offsets) {
+  const size_t fanout = size_t(1) << pass_bits;
+  const size_t segments = offsets.size() - 1;
+  const size_t group_size = std::min(
+      SPLIT_GROUP_SIZE,
+      q.get_device().get_info<sycl::info::device::max_work_group_size>());
+  const sycl::nd_range<1> range{segments * group_size, group_size};
+  std::vector<uint32_t> counts(segments * fanout, 0);
+  sycl::buffer<uint32_t> segments_buf{sycl::range<1>{segments + 1}};
+  sycl::buffer<uint32_t> counts_buf{sycl::range<1>{counts.size()}};
+
+  profiler.upload(q, offsets.data(), segments_buf);
+  sycl::event count = q.submit([&](sycl::handler &h) {
+    auto k = sycl::accessor(keys, h, sycl::read_only);
+    auto o = sycl::accessor(segments_buf, h, sycl::read_only);
+    auto c = sycl::accessor(counts_buf, h, sycl::write_only);
+    LocalCounters local(sycl::range<1>{fanout}, h);
+
+    h.parallel_for<PartitionSplitHistogram<Key>>(
+        range, [=](sycl::nd_item<1> it) {
+          const size_t s = it.get_group(0);
+          const size_t lid = it.get_local_id(0);
+          for (size_t d = lid; d < fanout; d += group_size) {
+            local[d] = 0;
+          }
+          sycl::group_barrier(it.get_group());
+          for (size_t i = o[s] + lid; i < o[s + 1]; i += group_size) {
+            const size_t d =
+                radix_partition(radix_hash(k[i]), bits) & (fanout - 1);
+            LocalAtomic(local.get_pointer() + d).fetch_add(1);
+          }
+          sycl::group_barrier(it.get_group());
+          for (size_t d = lid; d < fanout; d += group_size) {
+            c[s * fanout + d] = local[d];
+          }
+        });
+  });
+  profiler.kernel(count, "partition_histogram");
+  profiler.download(q, counts_buf, counts).wait();
+
+  // Partition d of segment s is partition s * fanout + d of this pass, so
+  // the offsets are a prefix sum of the counts in that order.
+  std::vector<uint32_t> next(counts.size() + 1, 0);
+  for (size_t p = 0; p < counts.size(); ++p) {
+    next[p + 1] = next[p] + counts[p];
+  }
+
+  profiler.upload(q, next.data(), counts_buf);
+  sycl::event scatter = q.submit([&](sycl::handler &h) {
+    auto k = sycl::accessor(keys, h, sycl::read_only);
+    auto v = sycl::accessor(vals, h, sycl::read_only);
+    auto out_k = sycl::accessor(out_keys, h, sycl::write_only);
+    auto out_v = sycl::accessor(out_vals, h, sycl::write_only);
+    auto o = sycl::accessor(segments_buf, h, sycl::read_only);
+    auto c = sycl::accessor(counts_buf, h, sycl::read_only);
+    LocalCounters local(sycl::range<1>{fanout}, h);
+
+    h.parallel_for<PartitionSplitScatter<Key>>(
+        range, [=](sycl::nd_item<1> it) {
+          const size_t s = it.get_group(0);
+          const size_t lid = it.get_local_id(0);
+          for (size_t d = lid; d < fanout; d += group_size) {
+            local[d] = c[s * fanout + d];
+          }
+          sycl::group_barrier(it.get_group());
+          for (size_t i = o[s] + lid; i < o[s + 1]; i += group_size) {
+            const size_t d =
+                radix_partition(radix_hash(k[i]), bits) & (fanout - 1);
+            const uint32_t at =
+                LocalAtomic(local.get_pointer() + d).fetch_add(1);
+            out_k[at] = k[i];
+            out_v[at] = v[i];
+          }
+        });
+  });
+  profiler.kernel(scatter, "partition_scatter");
+  offsets.swap(next);
+}
+
+// All passes of `partitioning` over one side of the join, leaving the
+// partitioned rows in `keys` and `vals`.
+template <class Key>
+void partition(sycl::queue &q, EventProfiler &profiler, size_t rows,
+               const RadixPartitioning &partitioning, sycl::buffer<Key> &keys,
+               sycl::buffer<uint32_t> &vals, std::vector<uint32_t> &offsets) {
+  offsets = {0, static_cast<uint32_t>(rows)};
+  if (partitioning.bits == 0)
+    return;
+  sycl::buffer<Key> out_keys{sycl::range<1>{rows}};
+  sycl::buffer<uint32_t> out_vals{sycl::range<1>{rows}};
+  partition_pass(q, profiler, rows, partitioning.bits, keys, vals, out_keys,
+                 out_vals, offsets);
+  std::swap(keys, out_keys);
+  std::swap(vals, out_vals);
+  for (size_t pass = 1; pass < partitioning.passes; ++pass) {
+    split_pass(q, profiler, (pass + 1) * partitioning.bits, partitioning.bits,
+               keys, vals, out_keys, out_vals, offsets);
+    std::swap(keys, out_keys);
+    std::swap(vals, out_vals);
+  }
+}
+} // namespace
+
+PartitionedJoin::PartitionedJoin() : Dwarf("PartitionedJoin") {}
+
+void PartitionedJoin::_run(const size_t buf_size, double load_factor,
+                           Meter &meter) {
+  if (meter.opts().key_width == KeyWidth::Bits32) {
+    _run_keys<uint32_t>(buf_size, load_factor, meter);
+  } else {
+    _run_keys<uint64_t>(buf_size, load_factor, meter);
+  }
+}
+
+template <class Key>
+void PartitionedJoin::_run_keys(const size_t buf_size, double load_factor,
+                                Meter &meter) {
+  auto opts = meter.opts();
+
+  constexpr Key empty_element = std::numeric_limits<Key>::max();
+  const size_t probe_size = helpers::probe_rows(opts, buf_size);
+  const Column<Key> table_a_keys =
+      helpers::input_column<Key>(opts, "build_keys", buf_size, [&] {
+        return helpers::make_build_keys<Key>(opts, buf_size);
+      });
+  const Column<uint32_t> table_a_values =
+      helpers::input_column<uint32_t>(opts, "build_values", buf_size, [&] {
+        return helpers::make_unique_random(opts, "build_values", buf_size);
+      });
+
+  const Column<Key> table_b_keys =
+      helpers::input_column<Key>(opts, "probe_keys", probe_size, [&] {
+        return helpers::make_probe_keys<Key>(opts, buf_size);
+      });
+  const Column<uint32_t> table_b_values =
+      helpers::input_column<uint32_t>(opts, "probe_values", probe_size, [&] {
+        return helpers::make_unique_random(opts, "probe_values", probe_size);
+      });
+
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
+  JoinChecker<Key, uint32_t, uint32_t> verify(
+      opts, table_a_keys, table_a_values, table_b_keys, table_b_values);
+
+  const RadixPartitioning partitioning = radix_partitioning(opts, buf_size);
+  const unsigned bits = partitioning.total_bits();
+
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  params["fanout"] = std::to_string(partitioning.fanout());
+  params["passes"] = std::to_string(partitioning.passes);
+  meter.measure(std::move(params), [&]() {
+    // output rows of every probe row and their total
+    std::vector<uint32_t> total(1, 0);
+    std::vector<Key> key_out;
+    std::vector<uint32_t> val1_out;
+    std::vector<uint32_t> val2_out;
+    size_t table_slots = 0;
+    std::unique_ptr<HashJoinResult> result = std::make_unique<HashJoinResult>();
+    // An empty side joins to no rows, and SYCL buffers cannot be empty.
+    if (buf_size > 0 && probe_size > 0) {
+      sycl::buffer<Key> key_a{sycl::range<1>{buf_size}};
+      sycl::buffer<uint32_t> val_a{sycl::range<1>{buf_size}};
+      sycl::buffer<Key> key_b{sycl::range<1>{probe_size}};
+      sycl::buffer<uint32_t> val_b{sycl::range<1>{probe_size}};
+
+      sycl::buffer<uint32_t> offsets_buf{sycl::range<1>{probe_size}};
+      sycl::buffer<uint32_t> total_buf{sycl::range<1>{1}};
+
+      EventProfiler profiler;
+      PerfCounters counters(opts.perf_counters && q.get_device().is_cpu());
+      counters.start();
+      auto host_start = std::chrono::steady_clock::now();
+      profiler.upload(q, table_a_keys, key_a);
+      profiler.upload(q, table_a_values, val_a);
+      profiler.upload(q, table_b_keys, key_b);
+      profiler.upload(q, table_b_values, val_b);
+      std::vector<uint32_t> build_offsets;
+      std::vector<uint32_t> probe_offsets;
+      partition(q, profiler, buf_size, partitioning, key_a, val_a,
+                build_offsets);
+      partition(q, profiler, probe_size, partitioning, key_b, val_b,
+                probe_offsets);
+      q.wait();
+      auto partition_end = std::chrono::steady_clock::now();
+
+      // Every partition gets its own table, of a few slots per build row.
+      const std::vector<uint64_t> tables =
+          partition_tables(build_offsets, load_factor);
+      table_slots = tables.back();
+      const std::vector<Key> empty_keys(table_slots, empty_element);
+      sycl::buffer<uint64_t> tables_buf{sycl::range<1>{tables.size()}};
+      sycl::buffer<Key> keys_buf{sycl::range<1>{table_slots}};
+      sycl::buffer<uint32_t> data_buf{sycl::range<1>{table_slots}};
+      profiler.upload(q, tables, tables_buf);
+      profiler.upload(q, empty_keys, keys_buf);
+
+      // Rows come in partition order, so the work-items running at a time
+      // use the tables of a few partitions.
+      sycl::event build = q.submit([&](sycl::handler &h) {
+        auto key_a_acc = sycl::accessor(key_a, h, sycl::read_only);
+        auto val_a_acc = sycl::accessor(val_a, h, sycl::read_only);
+        auto tables_acc = sycl::accessor(tables_buf, h, sycl::read_only);
+        auto keys_acc = keys_buf.get_access(h);
+        auto data_acc = sycl::accessor(data_buf, h, sycl::write_only);
+
+        h.parallel_for<PartitionedJoinBuild<Key>>(
+            buf_size, [=](sycl::id<1> i) {
+              const Key key = key_a_acc[i];
+              const uint64_t hash = radix_hash(key);
+              const size_t p = radix_partition(hash, bits);
+              const uint64_t base = tables_acc[p];
+              const uint64_t mask = tables_acc[p + 1] - base - 1;
+              size_t at = radix_slot(hash, bits, sycl::ctz(mask + 1));
+              while (true) {
+                Key expected = empty_element;
+                if (sycl::atomic<Key>(keys_acc.get_pointer() + base + at)
+                        .compare_exchange_strong(expected, key))
+                  break;
+                at = (at + 1) & mask;
+              }
+              data_acc[base + at] = val_a_acc[i];
+            });
+      });
+      profiler.kernel(build, "partitioned_join_build").wait();
+      auto build_end = std::chrono::steady_clock::now();
+
+      // Calls f(value, i) for the i-th build row matching `key`.
+      auto find_all = [=](auto &tables_acc, auto &keys_acc, auto &data_acc,
+                          const Key &key, auto f) {
+        const uint64_t hash = radix_hash(key);
+        const size_t p = radix_partition(hash, bits);
+        const uint64_t base = tables_acc[p];
+        const uint64_t mask = tables_acc[p + 1] - base - 1;
+        size_t found = 0;
+        for (size_t at = radix_slot(hash, bits, sycl::ctz(mask + 1));
+             keys_acc[base + at] != empty_element; at = (at + 1) & mask) {
+          if (keys_acc[base + at] == key)
+            f(data_acc[base + at], found++);
+        }
+        return found;
+      };
+
+      profiler.upload(q, total, total_buf);
+      sycl::event count = q.submit([&](sycl::handler &h) {
+        auto key_b_acc = sycl::accessor(key_b, h, sycl::read_only);
+        auto offsets_acc = sycl::accessor(offsets_buf, h, sycl::write_only);
+        auto total_acc = total_buf.get_access(h);
+        auto tables_acc = sycl::accessor(tables_buf, h, sycl::read_only);
+        auto keys_acc = sycl::accessor(keys_buf, h, sycl::read_only);
+        auto data_acc = sycl::accessor(data_buf, h, sycl::read_only);
+
+        h.parallel_for<PartitionedJoinCount<Key>>(
+            probe_size, [=](sycl::id<1> i) {
+              uint32_t matches =
+                  find_all(tables_acc, keys_acc, data_acc, key_b_acc[i],
+                           [](uint32_t, size_t) {});
+              offsets_acc[i] =
+                  matches ? sycl::atomic<uint32_t>(total_acc.get_pointer())
+                                .fetch_add(matches)
+                          : 0;
+            });
+      });
+      profiler.kernel(count, "partitioned_join_count");
+      profiler.download(q, total_buf, total).wait();
+
+      const size_t out_size = std::max<size_t>(total[0], 1);
+      key_out.resize(out_size);
+      val1_out.resize(out_size);
+      val2_out.resize(out_size);
+      sycl::buffer<Key> out_key_buf{sycl::range<1>{out_size}};
+      sycl::buffer<uint32_t> out_val1_buf{sycl::range<1>{out_size}};
+      sycl::buffer<uint32_t> out_val2_buf{sycl::range<1>{out_size}};
+      sycl::event probe = q.submit([&](sycl::handler &h) {
+        auto key_b_acc = sycl::accessor(key_b, h, sycl::read_only);
+        auto val_b_acc = sycl::accessor(val_b, h, sycl::read_only);
+        auto offsets_acc = sycl::accessor(offsets_buf, h, sycl::read_only);
+        auto tables_acc = sycl::accessor(tables_buf, h, sycl::read_only);
+        auto keys_acc = sycl::accessor(keys_buf, h, sycl::read_only);
+        auto data_acc = sycl::accessor(data_buf, h, sycl::read_only);
+
+        auto out_key_acc = sycl::accessor(out_key_buf, h, sycl::write_only);
+        auto out_val1_acc = sycl::accessor(out_val1_buf, h, sycl::write_only);
+        auto out_val2_acc = sycl::accessor(out_val2_buf, h, sycl::write_only);
+
+        h.parallel_for<PartitionedJoinProbe<Key>>(
+            probe_size, [=](sycl::id<1> i) {
+              const Key key = key_b_acc[i];
+              find_all(tables_acc, keys_acc, data_acc, key,
+                       [&](uint32_t val, size_t match) {
+                         size_t at = offsets_acc[i] + match;
+                         out_key_acc[at] = key;
+                         out_val1_acc[at] = val;
+                         out_val2_acc[at] = val_b_acc[i];
+                       });
+            });
+      });
+      profiler.kernel(probe, "partitioned_join_probe");
+      profiler.download(q, out_key_buf, key_out);
+      profiler.download(q, out_val1_buf, val1_out);
+      profiler.download(q, out_val2_buf, val2_out).wait();
+      auto host_end = std::chrono::steady_clock::now();
+      counters.stop();
+      key_out.resize(total[0]);
+      val1_out.resize(total[0]);
+      val2_out.resize(total[0]);
+
+      result->host_time = host_end - host_start;
+      result->partition_time = partition_end - host_start;
+      result->build_time = build_end - partition_end;
+      result->probe_time = host_end - build_end;
+      profiler.fill(*result);
+      counters.fill(*result);
+      if (opts.tracer) {
+        opts.tracer->span("partition", "phase", host_start, partition_end);
+        opts.tracer->span("build", "phase", partition_end, build_end);
+        opts.tracer->span("probe", "phase", build_end, host_end);
+      }
+    }
+
+    TraceSpan check(opts.tracer, "check");
+    ColJoinedTableTy<Key, uint32_t, uint32_t> output = {
+        key_out, {val1_out, val2_out}};
+
+    result->rows = buf_size + probe_size;
+    result->bytes_read =
+        (buf_size + probe_size) * (sizeof(Key) + sizeof(uint32_t));
+    // Every pass rewrites both sides, build writes the tables and probe the
+    // matched rows.
+    result->bytes_written =
+        (bits ? partitioning.passes : 0) * result->bytes_read +
+        (buf_size + key_out.size()) * sizeof(Key) +
+        (buf_size + key_out.size() * 2) * sizeof(uint32_t);
+    result->table_bytes = table_slots * (sizeof(Key) + sizeof(uint32_t));
+
+    if (!verify(output)) {
+      std::cerr << "Incorrect results" << std::endl;
+      result->valid = false;
+    }
+
+    return result;
+  });
+}
+
+void PartitionedJoin::run(const RunOptions &opts) {
+  for (auto size : opts.input_size) {
+    for (double load_factor : helpers::load_factors(opts, 0.5)) {
+      _run(size, load_factor, meter());
+    }
+  }
+}
+void PartitionedJoin::init(const RunOptions &opts) {
+  meter().set_opts(opts);
+  DwarfParams params = input_params(opts);
+  params["device_type"] = to_string(opts.device_ty);
+  meter().set_params(params);
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "common/common.hpp"
+
+// Hash join of radix-partitioned inputs: both sides are partitioned by the
+// top bits of the key hashes, then every probe partition is joined with a
+// table of its build partition small enough to stay in the cache.
+class PartitionedJoin : public Dwarf {
+public:
+  PartitionedJoin();
+  void run(const RunOptions &opts) override;
+  void init(const RunOptions &opts) override;
+
+private:
+  void _run(const size_t buffer_size, double load_factor, Meter &meter);
+  template <class Key>
+  void _run_keys(const size_t buffer_size, double load_factor, Meter &meter);
+};
@@ -1,45 +1,70 @@
 #include "slab_join.hpp"
 #include "common/dpcpp/slab_hash.hpp"
 #include "join_helpers/join_helpers.hpp"
+#include <limits>
 #include <math.h>
 
 using std::pair;
 using namespace join_helpers;
+
+namespace {
+using Table = SlabHash::SlabHashTable<
+    uint32_t, uint32_t,
+    SlabHash::DefaultHasher<242792921, 653019598, 2147483647>>;
+} // namespace
+
 SlabJoin::SlabJoin() : Dwarf("SlabJoin") {}
 
-void SlabJoin::_run(const size_t buf_size, Meter &meter) {
+void SlabJoin::_run(const size_t buf_size, double load_factor, Meter &meter) {
   const int scale = 16;
   auto opts = meter.opts();
 
-  const std::vector<uint32_t> table_a_keys =
-      helpers::make_unique_random(buf_size);
-  const std::vector<uint32_t> table_a_values =
-      helpers::make_unique_random(table_a_keys.size());
-
-  const std::vector<uint32_t> table_b_keys =
-      helpers::make_unique_random(buf_size);
-  const std::vector<uint32_t> table_b_values =
-      helpers::make_unique_random(table_b_keys.size());
-
-  auto sel = get_device_selector(opts);
-  sycl::queue q{*sel};
-  std::cout << "Selected device: "
-            << q.get_device().get_info<sycl::info::device::name>() << "\n";
-
-  auto expected = join_helpers::seq_join(table_a_keys, table_a_values,
-                                         table_b_keys, table_b_values);
-
-  for (auto it = 0; it < opts.iterations; ++it) {
+  const size_t probe_size = helpers::probe_rows(opts, buf_size);
+  const Column<uint32_t> table_a_keys =
+      helpers::input_column<uint32_t>(opts, "build_keys", buf_size, [&] {
+        return helpers::make_build_keys(opts, buf_size);
+      });
+  const Column<uint32_t> table_a_values =
+      helpers::input_column<uint32_t>(opts, "build_values", buf_size, [&] {
+        return helpers::make_unique_random(opts, "build_values", buf_size);
+      });
+
+  const Column<uint32_t> table_b_keys =
+      helpers::input_column<uint32_t>(opts, "probe_keys", probe_size, [&] {
+        return helpers::make_probe_keys(opts, buf_size);
+      });
+  const Column<uint32_t> table_b_values =
+      helpers::input_column<uint32_t>(opts, "probe_values", probe_size, [&] {
+        return helpers::make_unique_random(opts, "probe_values", probe_size);
+      });
+
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
+
+  join_helpers::JoinChecker<uint32_t, uint32_t, uint32_t> verify(
+      opts, table_a_keys, table_a_values, table_b_keys, table_b_values);
+
+  const size_t buckets_count = SlabHash::buckets_count(buf_size, load_factor);
+  const size_t cluster_size = SlabHash::nodes_count(buf_size, buckets_count);
+
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  meter.measure(std::move(params), [&]() {
     int num_of_groups = ceil((float)buf_size / scale);
     sycl::nd_range<1> r{SlabHash::SUBGROUP_SIZE * num_of_groups,
                         SlabHash::SUBGROUP_SIZE};
+    int probe_groups = ceil((float)probe_size / scale);
+    sycl::nd_range<1> pr{SlabHash::SUBGROUP_SIZE * probe_groups,
+                         SlabHash::SUBGROUP_SIZE};
 
     SlabHash::AllocAdapter<std::pair<uint32_t, uint32_t>> adap(
-        SlabHash::CLUSTER_SIZE, num_of_groups, SlabHash::BUCKETS_COUNT,
+        cluster_size, num_of_groups, buckets_count,
         {SlabHash::EMPTY_UINT32_T, 0}, q);
-    std::vector<uint32_t> key_out(buf_size, 0);
-    std::vector<uint32_t> val1_out(buf_size, -1);
-    std::vector<uint32_t> val2_out(buf_size, -1);
+    // output rows of every probe row and their total
+    std::vector<uint32_t> total(1, 0);
+    std::vector<uint32_t> key_out;
+    std::vector<uint32_t> val1_out;
+    std::vector<uint32_t> val2_out;
 
     std::unique_ptr<HashJoinResult> result = std::make_unique<HashJoinResult>();
 
@@ -47,111 +72,179 @@ void SlabJoin::_run(const size_t buf_size, Meter &meter) {
       sycl::buffer<SlabHash::AllocAdapter<std::pair<uint32_t, uint32_t>>>
           adap_buf(&adap, sycl::range<1>{1});
 
-      sycl::buffer<uint32_t> key_a(table_a_keys);
-      sycl::buffer<uint32_t> val_a(table_a_values);
-      sycl::buffer<uint32_t> key_b(table_b_keys);
-      sycl::buffer<uint32_t> val_b(table_b_values);
+      sycl::buffer<uint32_t> key_a{sycl::range<1>{buf_size}};
+      sycl::buffer<uint32_t> val_a{sycl::range<1>{buf_size}};
+      sycl::buffer<uint32_t> key_b{sycl::range<1>{probe_size}};
+      sycl::buffer<uint32_t> val_b{sycl::range<1>{probe_size}};
 
-      sycl::buffer<uint32_t> out_key_b(key_out);
-      sycl::buffer<uint32_t> out_val1_b(val1_out);
-      sycl::buffer<uint32_t> out_val2_b(val2_out);
+      // Build rows whose insert found no free slab, inserted again once the
+      // heap grew.
+      sycl::buffer<uint8_t> failed{sycl::range<1>{buf_size}};
+      sycl::buffer<uint32_t> offsets_b{sycl::range<1>{probe_size}};
+      sycl::buffer<uint32_t> total_b{sycl::range<1>{1}};
 
+      EventProfiler profiler;
       auto host_start = std::chrono::steady_clock::now();
-      q.submit([&](sycl::handler &h) {
-         auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
-         auto key_a_acc = sycl::accessor(key_a, h, sycl::read_only);
-         auto val_a_acc = sycl::accessor(val_a, h, sycl::read_only);
-
-         h.parallel_for<class join_build>(
-             r, [=](sycl::nd_item<1> it) [
-                    [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
-               int idx = it.get_local_id();
-               size_t ind = it.get_group().get_id();
-
-               SlabHash::SlabHashTable<uint32_t, uint32_t,
-                                       SlabHash::DefaultHasher<32, 48, 1031>>
-                   ht(SlabHash::EMPTY_UINT32_T, it, *adap_acc.get_pointer());
-
-               // todo: pick smaller one
-               for (int i = ind * scale; i < (ind + 1) * scale && i < buf_size;
-                    i++) {
-                 ht.insert(key_a_acc[i], val_a_acc[i]);
-               }
-             });
-       }).wait();
+      profiler.upload(q, table_a_keys, key_a);
+      profiler.upload(q, table_a_values, val_a);
+      auto build = [&](bool retry) {
+        return q.submit([&](sycl::handler &h) {
+          auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
+          auto key_a_acc = sycl::accessor(key_a, h, sycl::read_only);
+          auto val_a_acc = sycl::accessor(val_a, h, sycl::read_only);
+          auto f = sycl::accessor(failed, h, sycl::read_write);
+
+          h.parallel_for<class join_build>(
+              r, [=](sycl::nd_item<1> it) [
+                     [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
+                size_t ind = it.get_group().get_id();
+
+                Table ht(SlabHash::EMPTY_UINT32_T, it, *adap_acc.get_pointer());
+
+                // todo: pick smaller one
+                for (int i = ind * scale;
+                     i < (ind + 1) * scale && i < buf_size; i++) {
+                  if (retry && !f[i])
+                    continue;
+                  bool inserted = ht.insert(key_a_acc[i], val_a_acc[i]);
+                  if (it.get_local_id() == 0)
+                    f[i] = !inserted;
+                }
+              });
+        });
+      };
+      profiler.kernel(build(false), "join_build").wait();
+      while (adap.grow_if_overflowed()) {
+        profiler.kernel(build(true), "join_build").wait();
+      }
       auto build_end = std::chrono::steady_clock::now();
       auto probe_start = std::chrono::steady_clock::now();
-      q.submit([&](sycl::handler &h) {
-         auto key_b_acc = key_b.get_access(h);
-         auto val_b_acc = val_b.get_access(h);
 
-         auto out_key_a = out_key_b.get_access(h);
-         auto out_val1_a = out_val1_b.get_access(h);
-         auto out_val2_a = out_val2_b.get_access(h);
+      // Probe rows may match several build rows, so the first pass counts
+      // the matches and reserves output rows for them.
+      profiler.upload(q, table_b_keys, key_b);
+      profiler.upload(q, table_b_values, val_b);
+      profiler.upload(q, total, total_b);
+      sycl::event count = q.submit([&](sycl::handler &h) {
+        auto key_b_acc = sycl::accessor(key_b, h, sycl::read_only);
+        auto offsets_acc = sycl::accessor(offsets_b, h, sycl::write_only);
+        auto total_acc = sycl::accessor(total_b, h, sycl::read_write);
 
-         auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
+        auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
 
-         h.parallel_for<class join_probe>(
-             r, [=](sycl::nd_item<1> it) [
+        h.parallel_for<class join_count>(
+            pr, [=](sycl::nd_item<1> it) [
+                    [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
+              size_t ind = it.get_group().get_id();
+
+              Table ht(SlabHash::EMPTY_UINT32_T, it, *adap_acc.get_pointer());
+
+              for (int i = ind * scale; i < (ind + 1) * scale && i < probe_size;
+                   i++) {
+                uint32_t matches =
+                    ht.find_all(key_b_acc[i], [](uint32_t, size_t) {});
+                if (it.get_local_id() == 0) {
+                  offsets_acc[i] =
+                      matches ? sycl::atomic<uint32_t>(total_acc.get_pointer())
+                                    .fetch_add(matches)
+                              : 0;
+                }
+              }
+            });
+      });
+      profiler.kernel(count, "join_count");
+      profiler.download(q, total_b, total).wait();
+
+      const size_t out_size = std::max<size_t>(total[0], 1);
+      key_out.resize(out_size);
+      val1_out.resize(out_size);
+      val2_out.resize(out_size);
+      sycl::buffer<uint32_t> out_key_b{sycl::range<1>{out_size}};
+      sycl::buffer<uint32_t> out_val1_b{sycl::range<1>{out_size}};
+      sycl::buffer<uint32_t> out_val2_b{sycl::range<1>{out_size}};
+      sycl::event probe = q.submit([&](sycl::handler &h) {
+        auto key_b_acc = key_b.get_access(h);
+        auto val_b_acc = val_b.get_access(h);
+        auto offsets_acc = offsets_b.get_access(h);
+
+        auto out_key_a = out_key_b.get_access(h);
+        auto out_val1_a = out_val1_b.get_access(h);
+        auto out_val2_a = out_val2_b.get_access(h);
+
+        auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
+
+        h.parallel_for<class join_probe>(
+            pr, [=](sycl::nd_item<1> it) [
                     [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
-               size_t ind = it.get_group().get_id();
-
-               SlabHash::SlabHashTable<uint32_t, uint32_t,
-                                       SlabHash::DefaultHasher<32, 48, 1031>>
-                   ht(SlabHash::EMPTY_UINT32_T, it, *adap_acc.get_pointer());
-
-               for (int i = ind * scale; i < (ind + 1) * scale && i < buf_size;
-                    i++) {
-                 auto ans = ht.find(key_b_acc[i]);
-
-                 if (static_cast<bool>(ans)) {
-                   out_key_a[i] = key_b_acc[i];
-                   out_val1_a[i] = ans.value_or(-1);
-                   out_val2_a[i] = val_b_acc[i];
-                 }
-               }
-             });
-       }).wait();
+              size_t ind = it.get_group().get_id();
+
+              Table ht(SlabHash::EMPTY_UINT32_T, it, *adap_acc.get_pointer());
+
+              for (int i = ind * scale; i < (ind + 1) * scale && i < probe_size;
+                   i++) {
+                ht.find_all(key_b_acc[i], [&](uint32_t val, size_t j) {
+                  size_t at = offsets_acc[i] + j;
+                  out_key_a[at] = key_b_acc[i];
+                  out_val1_a[at] = val;
+                  out_val2_a[at] = val_b_acc[i];
+                });
+              }
+            });
+      });
+      profiler.kernel(probe, "join_probe");
+      profiler.download(q, out_key_b, key_out);
+      profiler.download(q, out_val1_b, val1_out);
+      profiler.download(q, out_val2_b, val2_out).wait();
       auto host_end = std::chrono::steady_clock::now();
+      key_out.resize(total[0]);
+      val1_out.resize(total[0]);
+      val2_out.resize(total[0]);
 
       result->host_time = host_end - host_start;
       result->build_time = build_end - host_start;
       result->probe_time = host_end - probe_start;
-    }
-
-    std::vector<uint32_t> res_k;
-    std::vector<uint32_t> res1;
-    std::vector<uint32_t> res2;
-
-    for (int i = 0; i < buf_size; i++) {
-      if (key_out[i] != ((uint32_t)0)) {
-        res_k.push_back(key_out[i]);
-        res1.push_back(val1_out[i]);
-        res2.push_back(val2_out[i]);
+      profiler.fill(*result);
+      if (opts.tracer) {
+        opts.tracer->span("build", "phase", host_start, build_end);
+        opts.tracer->span("probe", "phase", probe_start, host_end);
       }
     }
 
+    TraceSpan check(opts.tracer, "check");
     join_helpers::ColJoinedTableTy<uint32_t, uint32_t, uint32_t> output = {
-        res_k, {res1, res2}};
-
-    if (output != expected) {
+        key_out, {val1_out, val2_out}};
+
+    result->rows = buf_size + probe_size;
+    result->bytes_read = 2 * (buf_size + probe_size) * sizeof(uint32_t);
+    result->bytes_written = key_out.size() * 3 * sizeof(uint32_t);
+    const SlabHash::HeapUsage heap = adap.usage();
+    result->table_bytes = SlabHash::memory_size<pair<uint32_t, uint32_t>>(
+        buckets_count, heap.allocated);
+    result->slabs_allocated = heap.allocated;
+    result->slabs_used = heap.used;
+
+    if (!verify(output)) {
       std::cerr << "Incorrect results" << std::endl;
       result->valid = false;
     }
 
-    DwarfParams params{{"buf_size", std::to_string(buf_size)}};
-    meter.add_result(std::move(params), std::move(result));
+    return result;
     // todo: scale factor?
-  }
+  });
 }
 
 void SlabJoin::run(const RunOptions &opts) {
   for (auto size : opts.input_size) {
-    _run(size, meter());
+    for (double load_factor :
+         helpers::load_factors(opts, SlabHash::DEFAULT_LOAD_FACTOR,
+                               std::numeric_limits<double>::infinity())) {
+      _run(size, load_factor, meter());
+    }
   }
 }
 void SlabJoin::init(const RunOptions &opts) {
   meter().set_opts(opts);
-  DwarfParams params = {{"device_type", to_string(opts.device_ty)}};
+  DwarfParams params = join_helpers::input_params(opts);
+  params["device_type"] = to_string(opts.device_ty);
   meter().set_params(params);
 }
@@ -0,0 +1,310 @@
+#include "tbb_partitioned_join.hpp"
+#include "join_helpers/join_helpers.hpp"
+#include <oneapi/tbb/blocked_range.h>
+#include <oneapi/tbb/parallel_for.h>
+
+using namespace join_helpers;
+
+namespace {
+using Range = oneapi::tbb::blocked_range<size_t>;
+
+// Rows of the first pass are counted and scattered by chunks of this many.
+constexpr size_t CHUNK_ROWS = 1 << 16;
+constexpr size_t MAX_CHUNKS = 256;
+
+template <class Key> struct Rows {
+  std::vector<Key> keys;
+  std::vector<uint32_t> vals;
+
+  void resize(size_t rows) {
+    keys.resize(rows);
+    vals.resize(rows);
+  }
+};
+
+// First pass over all rows, by the top `bits` bits of their hashes: every
+// chunk of rows gets a histogram, a prefix sum over partitions and chunks
+// gives each chunk its ranges of the partitions and the chunks scatter their
+// rows to them in order.
+template <class Key>
+void first_pass(const Column<Key> &keys, const Column<uint32_t> &vals,
+                unsigned bits, Rows<Key> &out,
+                std::vector<uint32_t> &offsets) {
+  const size_t rows = keys.size();
+  const size_t parts = size_t(1) << bits;
+  const size_t chunks = std::min(rows / CHUNK_ROWS + 1, MAX_CHUNKS);
+  const size_t chunk = (rows + chunks - 1) / chunks;
+  std::vector<uint32_t> cursors(chunks * parts, 0);
+
+  oneapi::tbb::parallel_for(Range(0, chunks, 1), [&](const Range &r) {
+    for (size_t c = r.begin(); c != r.end(); ++c) {
+      uint32_t *histogram = &cursors[c * parts];
+      for (size_t i = c * chunk; i < std::min(rows, (c + 1) * chunk); ++i) {
+        ++histogram[radix_partition(radix_hash(keys[i]), bits)];
+      }
+    }
+  });
+
+  offsets.assign(parts + 1, 0);
+  uint32_t sum = 0;
+  for (size_t p = 0; p < parts; ++p) {
+    offsets[p] = sum;
+    for (size_t c = 0; c < chunks; ++c) {
+      const uint32_t count = cursors[c * parts + p];
+      cursors[c * parts + p] = sum;
+      sum += count;
+    }
+  }
+  offsets[parts] = sum;
+
+  oneapi::tbb::parallel_for(Range(0, chunks, 1), [&](const Range &r) {
+    for (size_t c = r.begin(); c != r.end(); ++c) {
+      uint32_t *cursor = &cursors[c * parts];
+      for (size_t i = c * chunk; i < std::min(rows, (c + 1) * chunk); ++i) {
+        const uint32_t at =
+            cursor[radix_partition(radix_hash(keys[i]), bits)]++;
+        out.keys[at] = keys[i];
+        out.vals[at] = vals[i];
+      }
+    }
+  });
+}
+
+// A later pass, splitting every partition of `in` on its own by the next
+// `pass_bits` bits, up to `bits` bits in all. Partitions are small by now,
+// so each is counted and scattered by a single thread within the cache.
+template <class Key>
+void next_pass(const Rows<Key> &in, unsigned bits, unsigned pass_bits,
+               Rows<Key> &out, std::vector<uint32_t> &offsets) {
+  const size_t fanout = size_t(1) << pass_bits;
+  const size_t segments = offsets.size() - 1;
+  std::vector<uint32_t> next(segments * fanout + 1, offsets.back());
+  auto digit = [&](const Key &key) {
+    return radix_partition(radix_hash(key), bits) & (fanout - 1);
+  };
+
+  oneapi::tbb::parallel_for(Range(0, segments), [&](const Range &r) {
+    std::vector<uint32_t> cursors(fanout);
+    for (size_t s = r.begin(); s != r.end(); ++s) {
+      std::fill(cursors.begin(), cursors.end(), 0);
+      for (size_t i = offsets[s]; i < offsets[s + 1]; ++i) {
+        ++cursors[digit(in.keys[i])];
+      }
+      uint32_t sum = offsets[s];
+      for (size_t d = 0; d < fanout; ++d) {
+        next[s * fanout + d] = sum;
+        const uint32_t count = cursors[d];
+        cursors[d] = sum;
+        sum += count;
+      }
+      for (size_t i = offsets[s]; i < offsets[s + 1]; ++i) {
+        const uint32_t at = cursors[digit(in.keys[i])]++;
+        out.keys[at] = in.keys[i];
+        out.vals[at] = in.vals[i];
+      }
+    }
+  });
+  offsets.swap(next);
+}
+
+// All passes of `partitioning` over one side of the join.
+template <class Key>
+void partition(const Column<Key> &keys, const Column<uint32_t> &vals,
+               const RadixPartitioning &partitioning, Rows<Key> &rows,
+               std::vector<uint32_t> &offsets) {
+  if (partitioning.bits == 0) {
+    rows.keys.assign(keys.begin(), keys.end());
+    rows.vals.assign(vals.begin(), vals.end());
+    offsets = {0, static_cast<uint32_t>(keys.size())};
+    return;
+  }
+  rows.resize(keys.size());
+  first_pass(keys, vals, partitioning.bits, rows, offsets);
+  Rows<Key> other;
+  if (partitioning.passes > 1)
+    other.resize(keys.size());
+  for (size_t pass = 1; pass < partitioning.passes; ++pass) {
+    next_pass(rows, (pass + 1) * partitioning.bits, partitioning.bits, other,
+              offsets);
+    std::swap(rows, other);
+  }
+}
+} // namespace
+
+TBBPartitionedJoin::TBBPartitionedJoin() : Dwarf("TBBPartitionedJoin") {}
+
+void TBBPartitionedJoin::_run(const size_t buf_size, double load_factor,
+                              Meter &meter) {
+  if (meter.opts().key_width == KeyWidth::Bits32) {
+    _run_keys<uint32_t>(buf_size, load_factor, meter);
+  } else {
+    _run_keys<uint64_t>(buf_size, load_factor, meter);
+  }
+}
+
+template <class Key>
+void TBBPartitionedJoin::_run_keys(const size_t buf_size, double load_factor,
+                                   Meter &meter) {
+  auto opts = meter.opts();
+
+  constexpr Key empty_element = std::numeric_limits<Key>::max();
+  const size_t probe_size = helpers::probe_rows(opts, buf_size);
+  const Column<Key> table_a_keys =
+      helpers::input_column<Key>(opts, "build_keys", buf_size, [&] {
+        return helpers::make_build_keys<Key>(opts, buf_size);
+      });
+  const Column<uint32_t> table_a_values =
+      helpers::input_column<uint32_t>(opts, "build_values", buf_size, [&] {
+        return helpers::make_unique_random(opts, "build_values", buf_size);
+      });
+
+  const Column<Key> table_b_keys =
+      helpers::input_column<Key>(opts, "probe_keys", probe_size, [&] {
+        return helpers::make_probe_keys<Key>(opts, buf_size);
+      });
+  const Column<uint32_t> table_b_values =
+      helpers::input_column<uint32_t>(opts, "probe_values", probe_size, [&] {
+        return helpers::make_unique_random(opts, "probe_values", probe_size);
+      });
+
+  JoinChecker<Key, uint32_t, uint32_t> verify(
+      opts, table_a_keys, table_a_values, table_b_keys, table_b_values);
+
+  const RadixPartitioning partitioning = radix_partitioning(opts, buf_size);
+  const unsigned bits = partitioning.total_bits();
+
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  params["fanout"] = std::to_string(partitioning.fanout());
+  params["passes"] = std::to_string(partitioning.passes);
+  meter.measure(std::move(params), [&]() {
+    std::unique_ptr<HashJoinResult> result = std::make_unique<HashJoinResult>();
+    PerfCounters counters(opts.perf_counters);
+    counters.start();
+    auto host_start = std::chrono::steady_clock::now();
+
+    Rows<Key> build;
+    Rows<Key> probe;
+    std::vector<uint32_t> build_offsets;
+    std::vector<uint32_t> probe_offsets;
+    partition(table_a_keys, table_a_values, partitioning, build,
+              build_offsets);
+    partition(table_b_keys, table_b_values, partitioning, probe,
+              probe_offsets);
+    auto partition_end = std::chrono::steady_clock::now();
+
+    // Every partition gets its own table, built by a single thread.
+    const size_t partitions = build_offsets.size() - 1;
+    const std::vector<uint64_t> tables =
+        partition_tables(build_offsets, load_factor);
+    std::vector<Key> keys(tables.back());
+    std::vector<uint32_t> data(tables.back());
+    oneapi::tbb::parallel_for(Range(0, partitions), [&](const Range &r) {
+      for (size_t p = r.begin(); p != r.end(); ++p) {
+        const uint64_t base = tables[p];
+        const uint64_t mask = tables[p + 1] - base - 1;
+        const unsigned slot_bits = __builtin_ctzll(mask + 1);
+        std::fill(&keys[base], &keys[base] + mask + 1, empty_element);
+        for (size_t i = build_offsets[p]; i < build_offsets[p + 1]; ++i) {
+          const uint64_t hash = radix_hash(build.keys[i]);
+          size_t at = radix_slot(hash, bits, slot_bits);
+          while (keys[base + at] != empty_element) {
+            at = (at + 1) & mask;
+          }
+          keys[base + at] = build.keys[i];
+          data[base + at] = build.vals[i];
+        }
+      }
+    });
+    auto build_end = std::chrono::steady_clock::now();
+
+    // Calls f(value) for the build rows of partition p matching `key`.
+    auto for_each_match = [&](size_t p, const Key &key, auto f) {
+      const uint64_t base = tables[p];
+      const uint64_t mask = tables[p + 1] - base - 1;
+      const uint64_t hash = radix_hash(key);
+      for (size_t at = radix_slot(hash, bits, __builtin_ctzll(mask + 1));
+           keys[base + at] != empty_element; at = (at + 1) & mask) {
+        if (keys[base + at] == key)
+          f(data[base + at]);
+      }
+    };
+
+    // Output rows of every partition, then their offsets.
+    std::vector<size_t> out_offsets(partitions + 1, 0);
+    oneapi::tbb::parallel_for(Range(0, partitions), [&](const Range &r) {
+      for (size_t p = r.begin(); p != r.end(); ++p) {
+        for (size_t i = probe_offsets[p]; i < probe_offsets[p + 1]; ++i) {
+          for_each_match(p, probe.keys[i],
+                         [&](uint32_t) { ++out_offsets[p + 1]; });
+        }
+      }
+    });
+    for (size_t p = 0; p < partitions; ++p) {
+      out_offsets[p + 1] += out_offsets[p];
+    }
+    const size_t rows = out_offsets.back();
+    ColJoinedTableTy<Key, uint32_t, uint32_t> output = {
+        std::vector<Key>(rows),
+        {std::vector<uint32_t>(rows), std::vector<uint32_t>(rows)}};
+    oneapi::tbb::parallel_for(Range(0, partitions), [&](const Range &r) {
+      for (size_t p = r.begin(); p != r.end(); ++p) {
+        size_t at = out_offsets[p];
+        for (size_t i = probe_offsets[p]; i < probe_offsets[p + 1]; ++i) {
+          for_each_match(p, probe.keys[i], [&](uint32_t val) {
+            output.first[at] = probe.keys[i];
+            output.second.first[at] = val;
+            output.second.second[at++] = probe.vals[i];
+          });
+        }
+      }
+    });
+    auto host_end = std::chrono::steady_clock::now();
+    counters.stop();
+
+    result->host_time = host_end - host_start;
+    result->partition_time = partition_end - host_start;
+    result->build_time = build_end - partition_end;
+    result->probe_time = host_end - build_end;
+    counters.fill(*result);
+    if (opts.tracer) {
+      opts.tracer->span("partition", "phase", host_start, partition_end);
+      opts.tracer->span("build", "phase", partition_end, build_end);
+      opts.tracer->span("probe", "phase", build_end, host_end);
+    }
+
+    TraceSpan check(opts.tracer, "check");
+    result->rows = buf_size + probe_size;
+    result->bytes_read =
+        (buf_size + probe_size) * (sizeof(Key) + sizeof(uint32_t));
+    // Every pass rewrites both sides, build writes the tables and probe the
+    // matched rows.
+    result->bytes_written =
+        (bits ? partitioning.passes : 0) * result->bytes_read +
+        (buf_size + rows) * sizeof(Key) +
+        (buf_size + rows * 2) * sizeof(uint32_t);
+    result->table_bytes = keys.size() * (sizeof(Key) + sizeof(uint32_t));
+
+    if (!verify(output)) {
+      std::cerr << "Incorrect results" << std::endl;
+      result->valid = false;
+    }
+
+    return result;
+  });
+}
+
+void TBBPartitionedJoin::run(const RunOptions &opts) {
+  for (auto size : opts.input_size) {
+    for (double load_factor : helpers::load_factors(opts, 0.5)) {
+      _run(size, load_factor, meter());
+    }
+  }
+}
+void TBBPartitionedJoin::init(const RunOptions &opts) {
+  meter().set_opts(opts);
+  DwarfParams params = input_params(opts);
+  params["device_type"] = to_string(opts.device_ty);
+  meter().set_params(params);
+  meter().set_device_info(host_device_info());
+  helpers::calibrate_peak_bandwidth(meter());
+}
@@ -1,26 +1,30 @@
 #include "slab_probe.hpp"
 #include "common/dpcpp/slab_hash.hpp"
+#include <limits>
 #include <math.h>
 
 using std::pair;
 
 SlabProbe::SlabProbe() : Dwarf("SlabProbe") {}
 
-void SlabProbe::_run(const size_t buf_size, Meter &meter) {
+void SlabProbe::_run(const size_t buf_size, double load_factor,
+                     Meter &meter) {
   const int scale = 16; // todo how to get through options
-  int mem_util = 60;
-  size_t buckets_count = SlabHash::calculate_buckets_count(buf_size, mem_util);
-  size_t cluster_size = 2 * buckets_count;
+  size_t buckets_count = SlabHash::buckets_count(buf_size, load_factor);
+  size_t cluster_size = SlabHash::nodes_count(buf_size, buckets_count);
 
   auto opts = meter.opts();
-  const std::vector<uint32_t> host_src = helpers::make_unique_random(buf_size);
+  const Column<uint32_t> host_src =
+      helpers::input_column<uint32_t>(opts, "keys", buf_size, [&] {
+        return helpers::make_unique_random(opts, "keys", buf_size);
+      });
 
-  auto sel = get_device_selector(opts);
-  sycl::queue q{*sel};
-  std::cout << "Selected device: "
-            << q.get_device().get_info<sycl::info::device::name>() << "\n";
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
 
-  for (auto it = 0; it < opts.iterations; ++it) {
+  DwarfParams params = helpers::table_params(opts, buf_size, load_factor);
+  meter.measure(std::move(params), [&]() {
     int num_of_groups = ceil((float)buf_size / scale);
 
     sycl::nd_range<1> r{SlabHash::SUBGROUP_SIZE * num_of_groups,
@@ -35,56 +39,76 @@ void SlabProbe::_run(const size_t buf_size, Meter &meter) {
     {
       sycl::buffer<SlabHash::AllocAdapter<std::pair<uint32_t, uint32_t>>>
           adap_buf(&adap, sycl::range<1>{1});
-      sycl::buffer<uint32_t> src(host_src);
-
-      q.submit([&](sycl::handler &h) {
-         auto s = sycl::accessor(src, h, sycl::read_only);
-
-         auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
-
-         h.parallel_for<class slab_hash_build>(
-             r, [=](sycl::nd_item<1> it) [
-                    [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
-               size_t ind = it.get_group().get_id();
-
-               SlabHash::SlabHashTable<
-                   uint32_t, uint32_t,
-                   SlabHash::DefaultHasher<242792921, 653019598, 2147483647>>
-                   ht(SlabHash::EMPTY_UINT32_T, it, *adap_acc.get_pointer());
+      sycl::buffer<uint32_t> src(host_src.data(), sycl::range<1>{buf_size});
+      // Rows whose insert found no free slab, inserted again once the heap
+      // grew.
+      sycl::buffer<uint8_t> failed{sycl::range<1>{buf_size}};
+
+      auto build = [&](bool retry) {
+        q.submit([&](sycl::handler &h) {
+           auto s = sycl::accessor(src, h, sycl::read_only);
+           auto f = sycl::accessor(failed, h, sycl::read_write);
+
+           auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
+
+           h.parallel_for<class slab_hash_build>(
+               r, [=](sycl::nd_item<1> it) [
+                      [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
+                 size_t ind = it.get_group().get_id();
+
+                 SlabHash::SlabHashTable<
+                     uint32_t, uint32_t,
+                     SlabHash::DefaultHasher<242792921, 653019598,
+                                             2147483647>>
+                     ht(SlabHash::EMPTY_UINT32_T, it,
+                        *adap_acc.get_pointer());
+
+                 for (int i = ind * scale;
+                      i < (ind + 1) * scale && i < buf_size; i++) {
+                   if (retry && !f[i])
+                     continue;
+                   bool inserted = ht.insert(s[i], s[i]);
+                   if (it.get_local_id() == 0)
+                     f[i] = !inserted;
+                 }
+               });
+         }).wait();
+      };
+      build(false);
+      while (adap.grow_if_overflowed()) {
+        build(true);
+      }
 
-               for (int i = ind * scale; i < (ind + 1) * scale && i < buf_size;
-                    i++) {
-                 ht.insert(s[i], s[i]);
-               }
-             });
-       }).wait();
+      sycl::buffer<uint32_t> out_buf{sycl::range<1>{buf_size}};
 
-      sycl::buffer<uint32_t> out_buf(output);
+      EventProfiler profiler;
       auto host_start = std::chrono::steady_clock::now();
-      q.submit([&](sycl::handler &h) {
-         auto s = sycl::accessor(src, h, sycl::read_only);
-         auto o = sycl::accessor(out_buf, h, sycl::read_write);
-         auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
-
-         h.parallel_for<class slab_hash_build_check>(
-             r, [=](sycl::nd_item<1> it) [
-                    [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
-               size_t ind = it.get_group().get_id();
-
-               SlabHash::SlabHashTable<
-                   uint32_t, uint32_t,
-                   SlabHash::DefaultHasher<242792921, 653019598, 2147483647>>
-                   ht(SlabHash::EMPTY_UINT32_T, it, *adap_acc.get_pointer());
-
-               for (int i = ind * scale; i < (ind + 1) * scale && i < buf_size;
-                    i++) {
-                 auto ans = ht.find(s[i]);
-                 if (it.get_local_id() == 0) {
-                   o[i] = static_cast<bool>(ans);
-                 }
-               }
-             });
-       }).wait();
+      sycl::event probe = q.submit([&](sycl::handler &h) {
+        auto s = sycl::accessor(src, h, sycl::read_only);
+        auto o = sycl::accessor(out_buf, h, sycl::write_only);
+        auto adap_acc = sycl::accessor(adap_buf, h, sycl::read_write);
+
+        h.parallel_for<class slab_hash_build_check>(
+            r, [=](sycl::nd_item<1> it) [
+                   [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
+              size_t ind = it.get_group().get_id();
+
+              SlabHash::SlabHashTable<
+                  uint32_t, uint32_t,
+                  SlabHash::DefaultHasher<242792921, 653019598, 2147483647>>
+                  ht(SlabHash::EMPTY_UINT32_T, it, *adap_acc.get_pointer());
+
+              for (int i = ind * scale; i < (ind + 1) * scale && i < buf_size;
+                   i++) {
+                auto ans = ht.find(s[i]);
+                if (it.get_local_id() == 0) {
+                  o[i] = static_cast<bool>(ans);
+                }
+              }
+            });
+      });
+      profiler.kernel(probe, "slab_probe");
+      profiler.download(q, out_buf, output).wait();
 
       auto host_end = std::chrono::steady_clock::now();
       auto host_exe_time =
@@ -93,22 +117,34 @@ void SlabProbe::_run(const size_t buf_size, Meter &meter) {
               .count();
       std::unique_ptr<Result> result = std::make_unique<Result>();
       result->host_time = host_end - host_start;
-
-      out_buf.get_access<sycl::access::mode::read>();
+      profiler.fill(*result);
+      result->rows = buf_size;
+      result->bytes_read = 3 * buf_size * sizeof(uint32_t);
+      result->bytes_written = buf_size * sizeof(uint32_t);
+      const SlabHash::HeapUsage heap = adap.usage();
+      result->table_bytes = SlabHash::memory_size<pair<uint32_t, uint32_t>>(
+          buckets_count, heap.allocated);
+      result->slabs_allocated = heap.allocated;
+      result->slabs_used = heap.used;
+
+      TraceSpan check(opts.tracer, "check");
       if (output != expected) {
         std::cerr << "Incorrect results" << std::endl;
         result->valid = false;
       }
 
-      DwarfParams params{{"buf_size", std::to_string(buf_size)}};
-      meter.add_result(std::move(params), std::move(result));
+      return result;
     }
-  }
+  });
 }
 
 void SlabProbe::run(const RunOptions &opts) {
   for (auto size : opts.input_size) {
-    _run(size, meter());
+    for (double load_factor :
+         helpers::load_factors(opts, SlabHash::DEFAULT_LOAD_FACTOR,
+                               std::numeric_limits<double>::infinity())) {
+      _run(size, load_factor, meter());
+    }
   }
 }
 void SlabProbe::init(const RunOptions &opts) {
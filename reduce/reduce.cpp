@@ -7,7 +7,7 @@
 #include "common/dpcpp/dpcpp_common.hpp"
 
 namespace {
-template <typename T> T expected_out(const std::vector<T> &v) {
+template <typename T> T expected_out(const Column<T> &v) {
   /* addition is not cumulative */
   auto max_T = std::numeric_limits<T>::max();
   auto min_T = std::numeric_limits<T>::min();
@@ -26,28 +26,32 @@ ReduceDPCPP::ReduceDPCPP() : Dwarf("ReduceDPCPP") {}
 
 void ReduceDPCPP::_run(const size_t buf_size, Meter &meter) {
   auto opts = meter.opts();
-  const std::vector<int> host_src = helpers::make_random<int>(buf_size);
+  const Column<int> host_src =
+      helpers::input_column<int>(opts, "values", buf_size, [&] {
+        return helpers::make_random<int>(opts, "values", buf_size);
+      });
   int host_out = 0;
   const int expected = expected_out(host_src);
 
-  auto sel = get_device_selector(opts);
-  sycl::queue q{*sel};
-  std::cout << "Selected device: "
-            << q.get_device().get_info<sycl::info::device::name>() << "\n";
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
 
   auto wg_size =
       q.get_device().get_info<sycl::info::device::max_work_group_size>();
 
-  sycl::buffer<int> src(host_src.data(), sycl::range<1>{host_src.size()});
-  sycl::buffer<int> out(&host_out, 1);
+  sycl::buffer<int> src{sycl::range<1>{host_src.size()}};
+  sycl::buffer<int> out{sycl::range<1>{1}};
 
   auto rng = (buf_size < wg_size) ? sycl::nd_range<1>{buf_size, buf_size}
                                   : sycl::nd_range<1>{buf_size, wg_size};
 
-  for (auto it = 0; it < opts.iterations; ++it) {
+  DwarfParams params{{"buf_size", std::to_string(buf_size)}};
+  meter.measure(std::move(params), [&]() {
+    EventProfiler profiler;
     auto host_start = std::chrono::steady_clock::now();
-
-    q.submit([&](sycl::handler &cgh) {
+    profiler.upload(q, host_src, src);
+    sycl::event reduce = q.submit([&](sycl::handler &cgh) {
       auto s = src.get_access<sycl::access::mode::read>(cgh);
       auto o = out.get_access<sycl::access::mode::discard_write>(cgh);
       auto reducer =
@@ -59,6 +63,8 @@ void ReduceDPCPP::_run(const size_t buf_size, Meter &meter) {
             reducer_arg += s[gid];
           });
     });
+    profiler.kernel(reduce, "reduce");
+    profiler.download(q, out, &host_out).wait();
 
     auto host_end = std::chrono::steady_clock::now();
     auto host_exe_time = std::chrono::duration_cast<std::chrono::microseconds>(
@@ -67,7 +73,11 @@ void ReduceDPCPP::_run(const size_t buf_size, Meter &meter) {
 
     std::unique_ptr<Result> result = std::make_unique<Result>();
     result->host_time = host_end - host_start;
-    out.get_access<sycl::access::mode::read>();
+    profiler.fill(*result);
+    result->rows = buf_size;
+    result->bytes_read = buf_size * sizeof(int);
+    result->bytes_written = sizeof(int);
+    TraceSpan check(opts.tracer, "check");
     if (expected != host_out) {
       std::cerr << "Incorrect results" << std::endl;
       result->valid = false;
@@ -82,9 +92,8 @@ void ReduceDPCPP::_run(const size_t buf_size, Meter &meter) {
       std::cout << std::endl;
     }
 #endif
-    DwarfParams params{{"buf_size", std::to_string(buf_size)}};
-    meter.add_result(std::move(params), std::move(result));
-  }
+    return result;
+  });
 }
 
 void ReduceDPCPP::run(const RunOptions &opts) {
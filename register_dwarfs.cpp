@@ -3,13 +3,21 @@
 #include "constant/constant.hpp"
 #include "groupby/groupby.hpp"
 #include "groupby/groupby_local.hpp"
+#include "hash/bucket_hash_build.hpp"
 #include "hash/cuckoo_hash_build.hpp"
+#include "hash/growable_hash_build.hpp"
 #include "hash/hash_build.hpp"
 #include "hash/hash_build_non_bitmask.hpp"
+#include "hash/hash_functions.hpp"
 #include "hash/slab_hash_build.hpp"
+#include "hash/slab_mixed_ops.hpp"
+#include "hash/tbb_growable_hash_build.hpp"
+#include "join/bucket_join.hpp"
 #include "join/join.hpp"
 #include "join/nested_join.hpp"
+#include "join/partitioned_join.hpp"
 #include "join/slab_join.hpp"
+#include "join/tbb_partitioned_join.hpp"
 #include "probe/slab_probe.hpp"
 #include "reduce/reduce.hpp"
 #include "scan/scan.hpp"
@@ -24,6 +32,8 @@ void populate_registry() {
   registry->registerd(new ConstantExampleCAPI());
   registry->registerd(new TBBSort());
   registry->registerd(new PermutationBufferSort());
+  registry->registerd(new TBBGrowableHashBuild());
+  registry->registerd(new TBBPartitionedJoin());
 
 #ifdef DPCPP_ENABLED
   registry->registerd(new ConstantExampleDPCPP());
@@ -37,8 +47,14 @@ void populate_registry() {
   registry->registerd(new GroupByLocal());
   registry->registerd(new Join());
   registry->registerd(new HashBuildNonBitmask());
+  registry->registerd(new BucketHashBuild());
+  registry->registerd(new GrowableHashBuild());
+  registry->registerd(new BucketJoin());
+  registry->registerd(new PartitionedJoin());
+  registry->registerd(new HashFunctions());
 #ifdef EXPERIMENTAL
   registry->registerd(new SlabHashBuild());
+  registry->registerd(new SlabMixedOps());
   registry->registerd(new SlabJoin());
   registry->registerd(new SlabProbe());
 #endif
@@ -12,7 +12,7 @@ namespace {
 template <typename T> using Func = std::function<bool(T)>;
 
 template <typename T>
-std::vector<T> expected_out(const std::vector<T> &v, Func<T> f) {
+std::vector<T> expected_out(const Column<T> &v, Func<T> f) {
   std::vector<int> out;
   std::copy_if(v.begin(), v.end(), std::back_inserter(out), f);
   return out;
@@ -24,58 +24,74 @@ DPLScanCuda::DPLScanCuda() : Dwarf("DPLScanCuda") {}
 void DPLScanCuda::run_scan(const size_t buf_size, Meter &meter) {
   auto opts = meter.opts();
   const int buffer_size = buf_size;
-  const std::vector<int> host_src = helpers::make_random<int>(buffer_size);
+  const Column<int> host_src =
+      helpers::input_column<int>(opts, "values", buffer_size, [&] {
+        return helpers::make_random<int>(opts, "values", buffer_size);
+      });
 
   std::vector<int> expected =
       expected_out<int>(host_src, [](int x) { return x < 5; });
 
-  auto sel = get_device_selector(opts);
-  sycl::queue q{*sel.get()};
-  std::cout << "Selected device: "
-            << q.get_device().get_info<sycl::info::device::name>() << "\n";
-  auto dev_policy = oneapi::dpl::execution::device_policy{*sel};
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
+  auto dev_policy = oneapi::dpl::execution::device_policy{q};
 
-  for (auto it = 0; it < opts.iterations; ++it) {
-    sycl::buffer<int> src_buf(host_src.data(), sycl::range<1>{buf_size});
+  DwarfParams params{{"buf_size", std::to_string(buffer_size)}};
+  meter.measure(std::move(params), [&]() {
+    sycl::buffer<int> src_buf{sycl::range<1>{buf_size}};
     sycl::buffer<int> out_buf{sycl::range<1>{buf_size}};
+    std::vector<int> output(buf_size);
 
+    EventProfiler profiler;
     auto host_start = std::chrono::steady_clock::now();
+    profiler.upload(q, host_src, src_buf).wait();
 
+    // oneDPL does not expose the events of its kernels, so the algorithm is
+    // timed on the host clock and reported as kernel time.
+    auto scan_start = std::chrono::steady_clock::now();
     auto end_it = std::copy_if(
         dev_policy, oneapi::dpl::begin(src_buf), oneapi::dpl::end(src_buf),
         oneapi::dpl::begin(out_buf), [](auto &x) { return x < 5; });
+    q.wait();
+    auto scan_end = std::chrono::steady_clock::now();
 
+    profiler.download(q, out_buf, output).wait();
     auto host_end = std::chrono::steady_clock::now();
     auto host_exe_time = std::chrono::duration_cast<std::chrono::microseconds>(
                              host_end - host_start)
                              .count();
 #ifndef NDEBUG
     {
-      sycl::host_accessor res(out_buf, sycl::read_only);
       std::cout << "Input:    ";
       dump_collection(host_src);
       std::cout << "Output:    ";
       for (int i = 0; i < expected.size(); ++i) {
-        std::cout << res[i] << " ";
+        std::cout << output[i] << " ";
       }
       std::cout << std::endl;
       std::cout << "Expected: ";
       dump_collection(expected);
     }
 #endif
-    Result result;
-    result.host_time = host_end - host_start;
-    DwarfParams params{{"buf_size", std::to_string(buffer_size)}};
-    meter.add_result(std::move(params), std::move(result));
+    std::unique_ptr<Result> result = std::make_unique<Result>();
+    result->host_time = host_end - host_start;
+    result->kernel_time =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(scan_end -
+                                                             scan_start)
+            .count();
+    profiler.fill(*result);
+    result->rows = buffer_size;
+    result->bytes_read = buffer_size * sizeof(int);
+    result->bytes_written = expected.size() * sizeof(int);
 
-    {
-      sycl::host_accessor res(out_buf, sycl::read_only);
-      if (!helpers::check_first(res, expected, expected.size())) {
-        std::cerr << "incorrect results" << std::endl;
-        result.valid = false;
-      }
+    TraceSpan check(opts.tracer, "check");
+    if (!helpers::check_first(output, expected, expected.size())) {
+      std::cerr << "incorrect results" << std::endl;
+      result->valid = false;
     }
-  }
+    return result;
+  });
 }
 
 void DPLScanCuda::run(const RunOptions &opts) {
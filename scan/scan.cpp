@@ -62,6 +62,15 @@ void TwoPassScan::run_two_pass_scan(const size_t buf_size, Meter &meter) {
   }
   std::cout << std::endl;
 
+  DeviceInfo info;
+  info.name = device.getInfo<CL_DEVICE_NAME>();
+  info.vendor = device.getInfo<CL_DEVICE_VENDOR>();
+  info.driver_version = device.getInfo<CL_DRIVER_VERSION>();
+  info.compute_units = device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+  info.max_work_group_size = device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
+  info.global_mem_bytes = device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>();
+  meter.set_device_info(std::move(info));
+
   constexpr int GPU_MAX_THREADS = 256;
   constexpr int CPU_MAX_THREADS = 8;
 
@@ -88,9 +97,11 @@ void TwoPassScan::run_two_pass_scan(const size_t buf_size, Meter &meter) {
     std::cerr << get_error_string(queue_init_err) << std::endl;
   }
 
-  std::vector<int> host_src = helpers::make_random<int>(buffer_size);
+  std::vector<int> host_src =
+      helpers::make_random<int>(opts, "values", buffer_size);
 
-  for (auto it = 0; it < opts.iterations; ++it) {
+  DwarfParams params{{"buf_size", std::to_string(buffer_size)}};
+  meter.measure(std::move(params), [&]() {
     cl::Buffer src(ctx, CL_MEM_READ_WRITE, buffer_size_bytes);
     cl::Buffer out(ctx, CL_MEM_READ_WRITE, buffer_size_bytes);
     cl::Buffer prefix(ctx, CL_MEM_READ_WRITE, prefix_size_bytes);
@@ -153,17 +164,19 @@ void TwoPassScan::run_two_pass_scan(const size_t buf_size, Meter &meter) {
 
     result->kernel_time = exe_time;
 
+    TraceSpan check(opts.tracer, "check");
     // todo: move out
     std::vector<int> expected_out = expected_out_lt(host_src, filter_value);
     size_t out_sz = host_out_size[0];
     host_out.resize(out_sz);
+    result->rows = buffer_size;
+    result->bytes_read = buffer_size_bytes;
+    result->bytes_written = out_sz * sizeof(int);
 
     if (expected_out != host_out) {
       std::cerr << "incorrect results" << std::endl;
       result->valid = false;
     }
-    DwarfParams params{{"buf_size", std::to_string(buffer_size)}};
-    meter.add_result(std::move(params), std::move(result));
 
 #ifndef NDEBUG
     std::cout << "Input:    ";
@@ -178,7 +191,8 @@ void TwoPassScan::run_two_pass_scan(const size_t buf_size, Meter &meter) {
     std::cout << "Debug: ";
     dump_collection(host_debug);
 #endif
-  }
+    return result;
+  });
 }
 
 void TwoPassScan::run(const RunOptions &opts) {
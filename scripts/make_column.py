@@ -0,0 +1,31 @@
+#!/usr/bin/env python3
+# Converts a .npy array or a raw little-endian file into a column file for
+# --dataset, e.g.: make_column.py keys.npy dataset/keys.col
+# or: make_column.py keys.bin dataset/keys.col --dtype uint32
+import argparse
+import struct
+
+import numpy as np
+
+TYPES = {"uint32": 1, "int32": 2, "uint64": 3, "int64": 4, "float32": 5,
+         "float64": 6}
+
+parser = argparse.ArgumentParser()
+parser.add_argument("input")
+parser.add_argument("output")
+parser.add_argument("--dtype", choices=TYPES.keys(),
+                    help="element type of a raw input file")
+args = parser.parse_args()
+
+if args.input.endswith(".npy"):
+    data = np.load(args.input)
+    if args.dtype:
+        data = data.astype(args.dtype)
+else:
+    data = np.fromfile(args.input, dtype=np.dtype(args.dtype or "uint32"))
+data = np.ascontiguousarray(data.ravel(), dtype=data.dtype.newbyteorder("<"))
+
+with open(args.output, "wb") as f:
+    f.write(b"DWARFCOL")
+    f.write(struct.pack("<IIQQ", 1, TYPES[data.dtype.name], data.size, 0))
+    f.write(data.tobytes())
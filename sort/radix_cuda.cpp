@@ -7,8 +7,8 @@
 #include "common/dpcpp/dpcpp_common.hpp"
 
 namespace {
-template <typename T> std::vector<T> expected_out(const std::vector<T> &v) {
-  std::vector<int> out = v;
+template <typename T> std::vector<T> expected_out(const Column<T> &v) {
+  std::vector<T> out = v.to_vector();
   std::sort(out.begin(), out.end());
   return out;
 }
@@ -18,52 +18,70 @@ RadixCuda::RadixCuda() : Dwarf("RadixCuda") {}
 
 void RadixCuda::_run(const size_t buf_size, Meter &meter) {
   auto opts = meter.opts();
-  const std::vector<int> host_src = helpers::make_random<int>(buf_size);
+  const Column<int> host_src =
+      helpers::input_column<int>(opts, "keys", buf_size, [&] {
+        return helpers::make_keys<int>(opts, "keys", buf_size, 1, 10000);
+      });
   const std::vector<int> expected = expected_out(host_src);
 
-  auto sel = get_device_selector(opts);
-  sycl::queue q{*sel};
-  std::cout << "Selected device: "
-            << q.get_device().get_info<sycl::info::device::name>() << "\n";
+  sycl::queue q = get_queue(opts);
+  report_device(q, meter);
+  calibrate_peak_bandwidth(q, meter);
 
-  auto dev_policy = oneapi::dpl::execution::device_policy{*sel};
+  auto dev_policy = oneapi::dpl::execution::device_policy{q};
 
-  for (auto it = 0; it < opts.iterations; ++it) {
-    sycl::buffer<int> src(host_src.data(), sycl::range<1>{buf_size});
+  DwarfParams params{{"buf_size", std::to_string(buf_size)}};
+  meter.measure(std::move(params), [&]() {
+    sycl::buffer<int> src{sycl::range<1>{buf_size}};
+    std::vector<int> output(buf_size);
 
+    EventProfiler profiler;
     auto host_start = std::chrono::steady_clock::now();
+    profiler.upload(q, host_src, src).wait();
+
+    // oneDPL does not expose the events of its kernels, so the sort is timed
+    // on the host clock and reported as kernel time.
+    auto sort_start = std::chrono::steady_clock::now();
     std::sort(dev_policy, oneapi::dpl::begin(src), oneapi::dpl::end(src));
+    q.wait();
+    auto sort_end = std::chrono::steady_clock::now();
+
+    profiler.download(q, src, output).wait();
     auto host_end = std::chrono::steady_clock::now();
     auto host_exe_time = std::chrono::duration_cast<std::chrono::microseconds>(
                              host_end - host_start)
                              .count();
 #ifndef NDEBUG
     {
-      sycl::host_accessor res(src, sycl::read_only);
       std::cout << "Input:    ";
       dump_collection(host_src);
       std::cout << "Output:    ";
       for (int i = 0; i < expected.size(); ++i) {
-        std::cout << res[i] << " ";
+        std::cout << output[i] << " ";
       }
       std::cout << std::endl;
       std::cout << "Expected:  ";
       dump_collection(expected);
     }
 #endif
-    Result result;
-    result.host_time = host_end - host_start;
-    DwarfParams params{{"buf_size", std::to_string(buf_size)}};
-    meter.add_result(std::move(params), std::move(result));
+    std::unique_ptr<Result> result = std::make_unique<Result>();
+    result->host_time = host_end - host_start;
+    result->kernel_time =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(sort_end -
+                                                             sort_start)
+            .count();
+    profiler.fill(*result);
+    result->rows = buf_size;
+    result->bytes_read = buf_size * sizeof(int);
+    result->bytes_written = buf_size * sizeof(int);
 
-    {
-      sycl::host_accessor res(src, sycl::read_only);
-      if (!helpers::check_first(res, expected, expected.size())) {
-        std::cerr << "incorrect results" << std::endl;
-        result.valid = false;
-      }
+    TraceSpan check(opts.tracer, "check");
+    if (output != expected) {
+      std::cerr << "incorrect results" << std::endl;
+      result->valid = false;
     }
-  }
+    return result;
+  });
 }
 
 void RadixCuda::run(const RunOptions &opts) {
@@ -74,6 +92,7 @@ void RadixCuda::run(const RunOptions &opts) {
 
 void RadixCuda::init(const RunOptions &opts) {
   meter().set_opts(opts);
-  DwarfParams params = {{"device_type", to_string(opts.device_ty)}};
+  DwarfParams params = {{"device_type", to_string(opts.device_ty)},
+                        {"distribution", to_string(opts.distribution)}};
   meter().set_params(params);
 }
\ No newline at end of file
@@ -3,8 +3,8 @@
 #include "sort/tbbsort.hpp"
 
 namespace {
-template <typename T> std::vector<T> expected_out(const std::vector<T> &v) {
-  std::vector<int> out = v;
+template <typename T> std::vector<T> expected_out(const Column<T> &v) {
+  std::vector<T> out = v.to_vector();
   std::sort(out.begin(), out.end());
   return out;
 }
@@ -14,20 +14,29 @@ TBBSort::TBBSort() : Dwarf("TBBSort") {}
 
 void TBBSort::_run(const size_t buf_size, Meter &meter) {
   auto opts = meter.opts();
-  std::vector<int> host_src = helpers::make_random<int>(buf_size);
+  const Column<int> host_src =
+      helpers::input_column<int>(opts, "keys", buf_size, [&] {
+        return helpers::make_keys<int>(opts, "keys", buf_size, 1, 10000);
+      });
   const std::vector<int> expected = expected_out(host_src);
 
-  for (auto it = 0; it < opts.iterations; ++it) {
+  DwarfParams params{{"buf_size", std::to_string(buf_size)}};
+  meter.measure(std::move(params), [&]() {
+    // every iteration has to sort the same unsorted input
+    std::vector<int> data = host_src.to_vector();
+    PerfCounters counters(opts.perf_counters);
+    counters.start();
     auto host_start = std::chrono::steady_clock::now();
-    oneapi::tbb::parallel_sort(host_src.begin(), host_src.end());
+    oneapi::tbb::parallel_sort(data.begin(), data.end());
     auto host_end = std::chrono::steady_clock::now();
+    counters.stop();
     auto host_exe_time = std::chrono::duration_cast<std::chrono::microseconds>(
                              host_end - host_start)
                              .count();
 #if NDEBUG
     {
       std::cout << "Output:    ";
-      dump_collection(host_src);
+      dump_collection(data);
       std::cout << std::endl;
       std::cout << "Expected:  ";
       dump_collection(expected);
@@ -35,16 +44,20 @@ void TBBSort::_run(const size_t buf_size, Meter &meter) {
 #endif
     std::unique_ptr<Result> result = std::make_unique<Result>();
     result->host_time = host_end - host_start;
-    DwarfParams params{{"buf_size", std::to_string(buf_size)}};
+    counters.fill(*result);
+    result->rows = buf_size;
+    result->bytes_read = buf_size * sizeof(int);
+    result->bytes_written = buf_size * sizeof(int);
 
+    TraceSpan check(opts.tracer, "check");
     {
-      if (!helpers::check_first(host_src, expected, expected.size())) {
+      if (!helpers::check_first(data, expected, expected.size())) {
         std::cerr << "incorrect results" << std::endl;
         result->valid = false;
       }
     }
-    meter.add_result(std::move(params), std::move(result));
-  }
+    return result;
+  });
 }
 
 void TBBSort::run(const RunOptions &opts) {
@@ -55,6 +68,9 @@ void TBBSort::run(const RunOptions &opts) {
 
 void TBBSort::init(const RunOptions &opts) {
   meter().set_opts(opts);
-  DwarfParams params = {{"device_type", to_string(opts.device_ty)}};
+  DwarfParams params = {{"device_type", to_string(opts.device_ty)},
+                        {"distribution", to_string(opts.distribution)}};
   meter().set_params(params);
+  meter().set_device_info(host_device_info());
+  helpers::calibrate_peak_bandwidth(meter());
 }
\ No newline at end of file
@@ -229,6 +229,114 @@ TEST(CuckooHashtable, parallel_insertion) {
     ASSERT_EQ(out[i].second, true);
 }
 
+TEST(BucketizedCuckooHashtable, overflows_into_stash) {
+  using Table = BucketizedCuckooHashtable<StaticSimpleHasher<1>,
+                                          StaticSimpleHasher<1>>;
+  // A single bucket, so keys beyond it go to the stash and then fail.
+  const size_t capacity = Table::bucket_size + Table::stash_size;
+  const size_t output_size = capacity + 1;
+
+  sycl::cpu_selector device_selector;
+  sycl::queue q(device_selector);
+
+  std::vector<uint64_t> slots(Table::slots_count(1), Table::empty_entry);
+  std::vector<uint32_t> inserted(output_size, 0);
+  std::vector<uint32_t> found(output_size, 0);
+  uint64_t left = 0;
+
+  {
+    sycl::buffer<uint64_t> slots_buf(slots);
+    sycl::buffer<uint32_t> inserted_buf(inserted);
+    sycl::buffer<uint32_t> found_buf(found);
+    sycl::buffer<uint64_t> left_buf(&left, 1);
+
+    q.submit([&](sycl::handler &h) {
+      auto slots_acc = slots_buf.get_access(h);
+      auto inserted_acc = inserted_buf.get_access(h);
+      auto found_acc = found_buf.get_access(h);
+      auto left_acc = left_buf.get_access(h);
+
+      h.single_task([=]() {
+        Table ht(1, slots_acc.get_pointer(), StaticSimpleHasher<1>(),
+                 StaticSimpleHasher<1>());
+        for (uint32_t i = 0; i < output_size; i++) {
+          uint64_t entry = Table::pack(i, i * 10);
+          inserted_acc[i] = ht.insert(entry);
+          left_acc[0] = entry;
+        }
+        for (uint32_t i = 0; i < output_size; i++) {
+          auto r = ht.at(i);
+          found_acc[i] = r.second && r.first == i * 10;
+        }
+      });
+    });
+  }
+
+  for (int i = 0; i < capacity; i++)
+    ASSERT_EQ(inserted[i], 1);
+  ASSERT_EQ(inserted[capacity], 0);
+
+  // The entry given back is the one missing from the table.
+  const uint32_t missing = Table::key_of(left);
+  ASSERT_EQ(Table::val_of(left), missing * 10);
+  for (uint32_t i = 0; i < output_size; i++)
+    ASSERT_EQ(found[i] != 0, i != missing);
+}
+
+TEST(BucketizedCuckooHashtable, parallel_insertion) {
+  using Table = BucketizedCuckooHashtable<SimpleHasher<uint32_t>,
+                                          SimpleHasherWithOffset>;
+  const size_t buckets = 64;
+  // Keys fill 90% of the slots outside the stash.
+  const size_t buf_size = buckets * Table::bucket_size * 9 / 10;
+
+  SimpleHasher<uint32_t> hasher1(buckets);
+  SimpleHasherWithOffset hasher2(buckets, 17);
+
+  sycl::cpu_selector device_selector;
+  sycl::queue q(device_selector);
+
+  std::vector<uint64_t> slots(Table::slots_count(buckets),
+                              Table::empty_entry);
+  std::vector<uint32_t> inserted(buf_size, 0);
+  std::vector<uint32_t> found(buf_size, 0);
+
+  {
+    sycl::buffer<uint64_t> slots_buf(slots);
+    sycl::buffer<uint32_t> inserted_buf(inserted);
+    sycl::buffer<uint32_t> found_buf(found);
+
+    q.submit([&](sycl::handler &h) {
+       auto slots_acc = slots_buf.get_access(h);
+       auto inserted_acc = inserted_buf.get_access(h);
+
+       h.parallel_for<class bucketized_insertion>(buf_size, [=](auto &i) {
+         Table ht(buckets, slots_acc.get_pointer(), hasher1, hasher2);
+         const uint32_t key = i[0];
+         uint64_t entry = Table::pack(key * 7, key);
+         inserted_acc[i] = ht.insert(entry);
+       });
+     }).wait();
+
+    q.submit([&](sycl::handler &h) {
+       auto slots_acc = slots_buf.get_access(h);
+       auto found_acc = found_buf.get_access(h);
+
+       h.parallel_for<class bucketized_probe>(buf_size, [=](auto &i) {
+         Table ht(buckets, slots_acc.get_pointer(), hasher1, hasher2);
+         const uint32_t key = i[0];
+         auto r = ht.at(key * 7);
+         found_acc[i] = r.second && r.first == key;
+       });
+     }).wait();
+  }
+
+  for (int i = 0; i < buf_size; i++) {
+    ASSERT_EQ(inserted[i], 1);
+    ASSERT_EQ(found[i], 1);
+  }
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,72 @@
+#include "common/dataset.hpp"
+
+#include <cstdio>
+#include <dirent.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+// Every test gets a dataset directory of its own, removed afterwards.
+class DatasetTest : public testing::Test {
+protected:
+  std::string dir;
+
+  void SetUp() override {
+    std::string path = testing::TempDir() + "dataset_tests.XXXXXX";
+    ASSERT_NE(mkdtemp(&path[0]), nullptr);
+    dir = path;
+  }
+
+  void TearDown() override {
+    if (DIR *d = opendir(dir.c_str())) {
+      while (dirent *entry = readdir(d)) {
+        if (entry->d_name[0] != '.')
+          std::remove((dir + "/" + entry->d_name).c_str());
+      }
+      closedir(d);
+    }
+    rmdir(dir.c_str());
+  }
+};
+
+TEST_F(DatasetTest, MapsColumnPrefix) {
+  write_column(dir + "/keys.col", std::vector<uint32_t>{5, 3, 9, 1});
+
+  Dataset dataset(dir);
+  ASSERT_TRUE(dataset.has_column("keys"));
+  ASSERT_FALSE(dataset.has_column("values"));
+
+  Column<uint32_t> keys = dataset.column<uint32_t>("keys", 3);
+  ASSERT_EQ(keys.size(), 3);
+  ASSERT_EQ(keys.to_vector(), std::vector<uint32_t>({5, 3, 9}));
+}
+
+TEST_F(DatasetTest, RejectsWrongTypeAndSize) {
+  write_column(dir + "/values.col", std::vector<int32_t>{1, 2});
+
+  Dataset dataset(dir);
+  ASSERT_THROW(dataset.column<uint32_t>("values", 2), std::invalid_argument);
+  ASSERT_THROW(dataset.column<int32_t>("values", 3), std::invalid_argument);
+  ASSERT_THROW(dataset.column<int32_t>("missing", 1), std::runtime_error);
+  ASSERT_THROW(Dataset(dir + "/values.col"), std::invalid_argument);
+}
+
+TEST_F(DatasetTest, RejectsTruncatedFiles) {
+  const std::string path = dir + "/keys.col";
+  write_column(path, std::vector<uint64_t>{1, 2, 3});
+  ASSERT_EQ(truncate(path.c_str(), sizeof(ColumnFileHeader) + 20), 0);
+
+  Dataset dataset(dir);
+  ASSERT_THROW(dataset.column<uint64_t>("keys", 1), std::runtime_error);
+}
+
+TEST(Column, OwnsGeneratedValues) {
+  Column<int> column(std::vector<int>{1, 2, 3});
+  Column<int> copy = column;
+  ASSERT_EQ(copy.data(), column.data());
+  ASSERT_EQ(copy[2], 3);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,207 @@
+#include "common/distribution.hpp"
+#include "common/keys.hpp"
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace {
+Distribution parse(const std::string &spec) {
+  std::istringstream is(spec);
+  Distribution d;
+  is >> d;
+  if (is.fail())
+    throw std::invalid_argument(spec);
+  return d;
+}
+
+double top_share(const std::vector<uint32_t> &v) {
+  std::map<uint32_t, size_t> counts;
+  for (auto k : v) {
+    ++counts[k];
+  }
+  size_t top = 0;
+  for (const auto &c : counts) {
+    top = std::max(top, c.second);
+  }
+  return static_cast<double>(top) / v.size();
+}
+} // namespace
+
+TEST(Distribution, ParsesSpecs) {
+  ASSERT_EQ(to_string(parse("uniform")), "uniform");
+  ASSERT_EQ(to_string(parse("Zipf")), "zipf:0.99");
+  ASSERT_EQ(to_string(parse("zipf:1.5")), "zipf:1.5");
+  ASSERT_EQ(to_string(parse("collision:64")), "collision:64");
+  ASSERT_THROW(parse("gauss"), std::invalid_argument);
+  ASSERT_THROW(parse("sorted:3"), std::invalid_argument);
+  ASSERT_THROW(parse("heavyhitter:2"), std::invalid_argument);
+}
+
+TEST(Distribution, StaysInRange) {
+  for (auto spec : {"uniform", "zipf:0.5", "zipf:1.2", "selfsimilar:0.2",
+                    "sequential", "sorted", "clustered:4", "heavyhitter:0.3",
+                    "collision:16"}) {
+    auto v = distribution::generate<uint32_t>(parse(spec), 10000, 10, 1000, 1);
+    ASSERT_EQ(v.size(), 10000);
+    ASSERT_GE(*std::min_element(v.begin(), v.end()), 10) << spec;
+    ASSERT_LE(*std::max_element(v.begin(), v.end()), 1000) << spec;
+  }
+}
+
+TEST(Distribution, IsDeterministicPerSeed) {
+  auto d = parse("zipf");
+  ASSERT_EQ(distribution::generate<uint32_t>(d, 100, 0, 1 << 20, 7),
+            distribution::generate<uint32_t>(d, 100, 0, 1 << 20, 7));
+}
+
+TEST(Distribution, HasExpectedShape) {
+  const size_t n = 100000;
+  auto uniform = distribution::generate<uint32_t>(parse("uniform"), n, 0,
+                                                  1000, 1);
+  auto zipf = distribution::generate<uint32_t>(parse("zipf:1"), n, 0, 1000, 1);
+  auto hitter = distribution::generate<uint32_t>(parse("heavyhitter:0.5"), n,
+                                                 0, 1000, 1);
+  ASSERT_LT(top_share(uniform), 0.01);
+  // The first rank of Zipf(1) over 1001 keys has ~13% of the mass.
+  ASSERT_NEAR(top_share(zipf), 0.134, 0.01);
+  ASSERT_NEAR(top_share(hitter), 0.5, 0.01);
+
+  auto sorted = distribution::generate<uint32_t>(parse("sorted"), n, 0, 9, 1);
+  ASSERT_TRUE(std::is_sorted(sorted.begin(), sorted.end()));
+
+  auto collision = distribution::generate<uint32_t>(parse("collision:64"), n,
+                                                    3, 1 << 20, 1);
+  ASSERT_TRUE(std::all_of(collision.begin(), collision.end(),
+                          [](uint32_t k) { return k % 64 == 3; }));
+}
+
+TEST(UniqueKeys, PermutationIsBijective) {
+  for (uint64_t domain : {1, 2, 5, 1000, 4097}) {
+    distribution::Permutation p(domain, 3);
+    std::vector<bool> seen(domain, false);
+    for (uint64_t i = 0; i < domain; ++i) {
+      uint64_t v = p(i);
+      ASSERT_LT(v, domain);
+      ASSERT_FALSE(seen[v]);
+      seen[v] = true;
+    }
+  }
+}
+
+TEST(UniqueKeys, AreDistinctAndReproducible) {
+  const size_t n = 200000;
+  auto keys = distribution::unique(n, 10, 10 + 2 * n, 5);
+  ASSERT_EQ(keys, distribution::unique(n, 10, 10 + 2 * n, 5));
+  ASSERT_NE(keys, distribution::unique(n, 10, 10 + 2 * n, 6));
+
+  auto sorted = keys;
+  std::sort(sorted.begin(), sorted.end());
+  ASSERT_EQ(std::adjacent_find(sorted.begin(), sorted.end()), sorted.end());
+  ASSERT_GE(sorted.front(), 10);
+  ASSERT_LE(sorted.back(), 10 + 2 * n);
+  ASSERT_THROW(distribution::unique(11, 0, 9, 1), std::invalid_argument);
+  ASSERT_EQ(distribution::unique(10, 0, 9, 1).size(), 10);
+}
+
+TEST(UniqueKeys, RepeatEachKey) {
+  auto keys = distribution::repeated(1000, 4, 1, 100000, 9);
+  std::map<uint64_t, size_t> counts;
+  for (auto k : keys) {
+    ++counts[k];
+  }
+  ASSERT_EQ(counts.size(), 250);
+  for (const auto &c : counts) {
+    ASSERT_EQ(c.second, 4);
+  }
+  auto unique = distribution::unique(250, 1, 100000, 9);
+  ASSERT_EQ(std::set<uint64_t>(unique.begin(), unique.end()).size(), 250);
+  for (auto k : unique) {
+    ASSERT_EQ(counts.count(k), 1);
+  }
+}
+
+TEST(UniqueKeys, MatchTheBuildSideAtTheRate) {
+  const size_t build_size = 1000, probe_size = 5000;
+  auto build = distribution::unique(build_size, 1, 100000, 9);
+  auto probe =
+      distribution::matching(probe_size, build_size, 0.1, 1, 1, 100000, 9);
+
+  std::set<uint64_t> build_set(build.begin(), build.end());
+  std::set<uint64_t> probe_set(probe.begin(), probe.end());
+  ASSERT_EQ(probe_set.size(), probe_size);
+  auto matches = [&](const std::vector<uint64_t> &keys) {
+    return std::count_if(keys.begin(), keys.end(), [&](uint64_t k) {
+      return build_set.count(k) > 0;
+    });
+  };
+  ASSERT_EQ(matches(probe), 500);
+
+  // 1:N, each build key is matched by several probe rows.
+  auto fanout = distribution::matching(probe_size, 100, 0.5, 1, 1, 100000, 9);
+  build = distribution::unique(100, 1, 100000, 9);
+  build_set = std::set<uint64_t>(build.begin(), build.end());
+  ASSERT_EQ(matches(fanout), 2500);
+
+  auto dups =
+      distribution::matching(probe_size, build_size, 1, 5, 1, 100000, 9);
+  ASSERT_EQ(std::set<uint64_t>(dups.begin(), dups.end()).size(), 1000);
+
+  ASSERT_THROW(distribution::matching(probe_size, build_size, 0, 1, 1, 5000, 9),
+               std::invalid_argument);
+}
+
+TEST(UniqueKeys, EmptyInputsFitAnyRange) {
+  ASSERT_TRUE(distribution::unique(0, 1, 0, 9).empty());
+  ASSERT_TRUE(distribution::repeated(0, 1, 1, 0, 9).empty());
+  ASSERT_TRUE(distribution::matching(0, 0, 1, 1, 1, 0, 9).empty());
+}
+
+TEST(UniqueKeys, SeedsDependOnTheStream) {
+  ASSERT_EQ(distribution::derive_seed(1, "build_keys"),
+            distribution::derive_seed(1, "build_keys"));
+  ASSERT_NE(distribution::derive_seed(1, "build_keys"),
+            distribution::derive_seed(1, "probe_keys"));
+  ASSERT_NE(distribution::derive_seed(1, "build_keys"),
+            distribution::derive_seed(2, "build_keys"));
+}
+
+TEST(KeyWidths, Parse) {
+  for (auto w : {KeyWidth::Bits32, KeyWidth::Bits64, KeyWidth::Composite}) {
+    std::istringstream is(to_string(w));
+    KeyWidth parsed;
+    ASSERT_TRUE(is >> parsed);
+    ASSERT_EQ(parsed, w);
+  }
+  std::istringstream bad("128");
+  KeyWidth w;
+  ASSERT_FALSE(bad >> w);
+}
+
+TEST(KeyWidths, IdsMapToDistinctKeys) {
+  const uint32_t ids[] = {0, 1, 2, 0xffff, 0x10000, 0x12345678, 0xfffffffe};
+  for (auto w : {KeyWidth::Bits32, KeyWidth::Bits64, KeyWidth::Composite}) {
+    std::set<uint64_t> keys;
+    for (uint32_t id : ids) {
+      uint64_t key = id_key(w, id);
+      ASSERT_EQ(key_id(w, key), id);
+      ASSERT_NE(key, std::numeric_limits<uint64_t>::max());
+      keys.insert(key);
+    }
+    ASSERT_EQ(keys.size(), std::size(ids));
+  }
+  // Both columns of composite keys are used.
+  ASSERT_EQ(key_first(id_key(KeyWidth::Composite, 0x12345678)), 0x12345678u);
+  ASSERT_EQ(key_second(id_key(KeyWidth::Composite, 0x12345678)),
+            uint32_t(0x12345678u * 0x9e3779b1u));
+  ASSERT_GT(key_second(id_key(KeyWidth::Composite, 1)), 0xffffu);
+  ASSERT_NE(key_first(id_key(KeyWidth::Bits64, 1)), 0u);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
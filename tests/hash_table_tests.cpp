@@ -1,5 +1,10 @@
+#include "common/dpcpp/bucket_hashtable.hpp"
+#include "common/dpcpp/growable_hashtable.hpp"
 #include "common/dpcpp/hashtable.hpp"
+#include "common/growable_hashtable.hpp"
 #include <gtest/gtest.h>
+#include <set>
+#include <sstream>
 #include <vector>
 
 TEST(HashTable, Build) {
@@ -245,7 +250,7 @@ TEST(GroupByHashTable, GroupByFunctions) {
     answers[host_src_keys[i]] += host_src_vals[i];
   }
 
-  PolynomialHasher hasher(buf_size);
+  PolynomialHasher hasher(buf_size, 0);
   std::vector<uint32_t> data(buf_size, 0);
   std::vector<uint32_t> data_answers(groups, 0);
   std::vector<uint32_t> keys(buf_size, -1);
@@ -305,6 +310,255 @@ TEST(GroupByHashTable, GroupByFunctions) {
   }
 }
 
+class BucketBuildTest;
+class BucketProbeTest;
+
+TEST(BucketHashTable, BuildAndProbe) {
+  using namespace sycl;
+  cpu_selector sel;
+  queue q{sel};
+
+  // Keys 0..buf_size-1 twice, probed with keys up to 2 * buf_size.
+  constexpr size_t buf_size = 1000;
+  constexpr uint32_t empty = std::numeric_limits<uint32_t>::max();
+  using Table = BucketizedHashTable<uint32_t, uint32_t, SimpleHasher<uint32_t>>;
+  const size_t buckets =
+      BucketHash::buckets_count(2 * buf_size, Table::bucket_size);
+  SimpleHasher<uint32_t> hasher(buckets);
+
+  for (bool cooperative : {false, true}) {
+    std::vector<uint32_t> keys(buckets * Table::bucket_size, empty);
+    std::vector<uint32_t> data(keys.size(), 0);
+    std::vector<uint32_t> counts(2 * buf_size, 0);
+    {
+      buffer<uint32_t> keys_buf(keys);
+      buffer<uint32_t> data_buf(data);
+      buffer<uint32_t> counts_buf(counts);
+
+      q.submit([&](handler &h) {
+        auto keys_acc = keys_buf.get_access<access::mode::read_write>(h);
+        auto data_acc = data_buf.get_access<access::mode::read_write>(h);
+        BucketHash::parallel_for<BucketBuildTest>(
+            h, 2 * buf_size, cooperative,
+            [=](nd_item<1> it, auto cooperative) {
+              size_t idx = BucketHash::key_index(it, cooperative);
+              if (idx >= 2 * buf_size)
+                return;
+              Table ht(buckets, keys_acc.get_pointer(),
+                       data_acc.get_pointer(), hasher, empty);
+              uint32_t key = idx % buf_size;
+              if constexpr (decltype(cooperative)::value) {
+                ht.insert(it.get_sub_group(), key, idx);
+              } else {
+                ht.insert(key, idx);
+              }
+            });
+      });
+      q.submit([&](handler &h) {
+        auto keys_acc = keys_buf.get_access<access::mode::read_write>(h);
+        auto data_acc = data_buf.get_access<access::mode::read_write>(h);
+        auto counts_acc = counts_buf.get_access<access::mode::read_write>(h);
+        BucketHash::parallel_for<BucketProbeTest>(
+            h, 2 * buf_size, cooperative,
+            [=](nd_item<1> it, auto cooperative) {
+              size_t idx = BucketHash::key_index(it, cooperative);
+              if (idx >= 2 * buf_size)
+                return;
+              Table ht(buckets, keys_acc.get_pointer(),
+                       data_acc.get_pointer(), hasher, empty);
+              auto none = [](uint32_t, size_t) {};
+              if constexpr (decltype(cooperative)::value) {
+                counts_acc[idx] = ht.find_all(it.get_sub_group(), idx, none);
+              } else {
+                counts_acc[idx] = ht.find_all(idx, none);
+              }
+            });
+      });
+    }
+
+    for (size_t i = 0; i < counts.size(); ++i) {
+      ASSERT_EQ(counts[i], i < buf_size ? 2 : 0);
+    }
+    std::set<uint32_t> rows(data.begin(), data.end());
+    ASSERT_EQ(rows.size(), 2 * buf_size);
+  }
+}
+
+TEST(ProbeStats, CollidingKeys) {
+  using namespace sycl;
+  cpu_selector sel;
+  queue q{sel};
+
+  // Keys of the same slot take the next free ones, so in any order inserts
+  // and lookups of them visit 1, 2, ..., keys slots.
+  constexpr int input_size = 64;
+  constexpr int keys = 8;
+  std::vector<uint32_t> bitmask(input_size / 32, 0);
+  std::vector<uint32_t> data(input_size, 0);
+  std::vector<uint32_t> table_keys(input_size, 0);
+  StaticSimpleHasher<input_size> hasher;
+  using Table = SimpleNonOwningHashTable<uint32_t, uint32_t,
+                                         StaticSimpleHasher<input_size>,
+                                         DeviceProbeStats>;
+
+  Result result;
+  {
+    buffer<uint32_t> bitmask_buf(bitmask);
+    buffer<uint32_t> data_buf(data);
+    buffer<uint32_t> keys_buf(table_keys);
+    ProbeCounters probes(true);
+
+    for (bool build : {true, false}) {
+      q.submit([&](handler &h) {
+        auto bitmask_acc = bitmask_buf.get_access<access::mode::read_write>(h);
+        auto data_acc = data_buf.get_access<access::mode::read_write>(h);
+        auto keys_acc = keys_buf.get_access<access::mode::read_write>(h);
+        auto probes_acc = probes.access<DeviceProbeStats>(h);
+        h.parallel_for<class probe_stats_test>(range<1>{keys}, [=](auto &idx) {
+          Table ht(input_size, keys_acc.get_pointer(), data_acc.get_pointer(),
+                   bitmask_acc.get_pointer(), hasher,
+                   DeviceProbeStats(probes_acc.get_pointer()));
+          const uint32_t key = 5 + idx.get_id(0) * input_size;
+          if (build) {
+            ht.insert(key, key);
+          } else {
+            ht.has(key);
+          }
+        });
+      });
+    }
+    probes.fill(result);
+  }
+
+  ASSERT_TRUE(result.probes.collected);
+  for (const auto &h : {result.probes.inserts, result.probes.lookups}) {
+    ASSERT_EQ(ProbeStats::count(h), keys);
+    ASSERT_DOUBLE_EQ(ProbeStats::mean(h), (keys + 1) / 2.0);
+    ASSERT_EQ(ProbeStats::quantile(h, 1), keys);
+  }
+  ASSERT_EQ(result.probes.evictions, 0);
+}
+
+TEST(Hashers, PowerOfTwoTables) {
+  constexpr size_t size = 1024;
+  for (auto kind : {HasherKind::MultiplyShift, HasherKind::Fibonacci,
+                    HasherKind::Crc32, HasherKind::XxHash,
+                    HasherKind::WyHash}) {
+    std::istringstream is(to_string(kind));
+    HasherKind parsed;
+    ASSERT_TRUE(is >> parsed);
+    ASSERT_EQ(parsed, kind);
+
+    ASSERT_EQ(hashed_table_size(kind, 1000), size);
+    with_hasher(kind, size, 1, SimpleHasher<uint32_t>(size), [&](auto hash) {
+      std::set<size_t> slots;
+      for (uint32_t key = 0; key < size; ++key) {
+        ASSERT_LT(hash(key), size);
+        ASSERT_LT(hash(uint64_t(key) << 32 | key), size);
+        slots.insert(hash(key));
+      }
+      // Far from all keys in a few slots.
+      ASSERT_GT(slots.size(), size / 2);
+    });
+  }
+  ASSERT_EQ(hashed_table_size(HasherKind::Default, 1000), 1000);
+  ASSERT_THROW(Pow2Hasher<Hashes::Fibonacci>(1000), std::invalid_argument);
+}
+
+TEST(GrowableHashTable, GrowsPastInitialCapacity) {
+  sycl::queue q{sycl::cpu_selector()};
+  constexpr size_t rows = 10000;
+  constexpr uint32_t groups = 3000;
+  std::vector<uint32_t> keys(rows);
+  for (size_t i = 0; i < rows; ++i) {
+    keys[i] = i % groups + 1;
+  }
+  std::vector<uint32_t> ones(rows, 1);
+  std::vector<uint32_t> counts(groups + 1, 0);
+
+  uint32_t *keys_dev = sycl::malloc_device<uint32_t>(rows, q);
+  uint32_t *ones_dev = sycl::malloc_device<uint32_t>(rows, q);
+  q.memcpy(keys_dev, keys.data(), rows * sizeof(uint32_t));
+  q.memcpy(ones_dev, ones.data(), rows * sizeof(uint32_t));
+  q.wait();
+  {
+    GrowableHashTable<uint32_t, uint32_t, Hashes::Fibonacci> ht(q, 16, 0.5);
+    ht.add(keys_dev, ones_dev, rows);
+    ASSERT_EQ(ht.size(), groups);
+    ASSERT_GE(ht.capacity(), 2 * groups);
+    ASSERT_EQ(ht.capacity(), size_t(16) << ht.rehashes());
+
+    sycl::buffer<uint32_t> counts_buf(counts);
+    auto view = ht.view();
+    q.submit([&](sycl::handler &h) {
+      auto c = counts_buf.get_access(h);
+      h.parallel_for<class growable_test>(groups + 1, [=](sycl::id<1> i) {
+        auto found = view.at(i[0]);
+        c[i] = found.second ? found.first : 0;
+      });
+    });
+  }
+  sycl::free(keys_dev, q);
+  sycl::free(ones_dev, q);
+
+  ASSERT_EQ(counts[0], 0);
+  for (uint32_t key = 1; key <= groups; ++key) {
+    ASSERT_EQ(counts[key], key <= rows % groups ? 4 : 3);
+  }
+}
+
+TEST(GrowableHashTable, StartsFromOneSlot) {
+  sycl::queue q{sycl::cpu_selector()};
+  std::vector<uint32_t> keys = {7, 3, 7, 9, 3, 7};
+  std::vector<uint32_t> ones(keys.size(), 1);
+  uint32_t *keys_dev = sycl::malloc_device<uint32_t>(keys.size(), q);
+  uint32_t *ones_dev = sycl::malloc_device<uint32_t>(keys.size(), q);
+  q.memcpy(keys_dev, keys.data(), keys.size() * sizeof(uint32_t));
+  q.memcpy(ones_dev, ones.data(), keys.size() * sizeof(uint32_t));
+  q.wait();
+  {
+    // A table of one slot would be full after its first key.
+    GrowableHashTable<uint32_t, uint32_t, Hashes::Fibonacci> ht(q, 1, 0.9);
+    ht.add(keys_dev, ones_dev, keys.size());
+    ASSERT_EQ(ht.size(), 3);
+    ASSERT_GT(ht.capacity(), ht.size());
+  }
+  sycl::free(keys_dev, q);
+  sycl::free(ones_dev, q);
+}
+
+TEST(HostGrowableHashTable, GrowsPastInitialCapacity) {
+  constexpr size_t rows = 10000;
+  constexpr uint32_t groups = 3000;
+  std::vector<uint32_t> keys(rows);
+  for (size_t i = 0; i < rows; ++i) {
+    keys[i] = i % groups + 1;
+  }
+  std::vector<uint32_t> vals(keys);
+
+  HostGrowableHashTable<uint32_t, uint32_t, Hashes::Fibonacci> ht(16, 0.5);
+  ht.insert(keys.data(), vals.data(), rows);
+  ASSERT_EQ(ht.size(), groups);
+  ASSERT_EQ(ht.capacity(), size_t(16) << ht.rehashes());
+  for (uint32_t key = 1; key <= groups; ++key) {
+    ASSERT_EQ(ht.at(key), std::make_pair(key, true));
+  }
+  ASSERT_FALSE(ht.has(0));
+}
+
+TEST(HostGrowableHashTable, StartsFromOneSlot) {
+  std::vector<uint32_t> keys = {7, 3, 7, 9, 3, 7};
+  std::vector<uint32_t> ones(keys.size(), 1);
+
+  // A table of one slot would be full after its first key.
+  HostGrowableHashTable<uint32_t, uint32_t, Hashes::Fibonacci> ht(1, 0.9);
+  ht.add(keys.data(), ones.data(), keys.size());
+  ASSERT_EQ(ht.size(), 3);
+  ASSERT_GT(ht.capacity(), ht.size());
+  ASSERT_EQ(ht.at(7), std::make_pair(uint32_t(3), true));
+  ASSERT_EQ(ht.at(9), std::make_pair(uint32_t(1), true));
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
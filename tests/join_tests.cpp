@@ -58,6 +58,114 @@ TEST(Join, HelpersConvert) {
   ASSERT_EQ(res, converted);
 }
 
+TEST(Join, HelpersHashJoin) {
+  using namespace std;
+  vector<int> keys_a = {1, 2, 3, 4, 5, 5, 7};
+  vector<int> vals_a = {5, 1, 4, 6, 6, 5, 0};
+  vector<int> keys_b = {6, 2, 3, 4, 5, 5, 7};
+  vector<int> vals_b = {3, 2, 1, 1, 3, 8, 8};
+
+  using namespace join_helpers;
+  auto expected = seq_join(keys_a, vals_a, keys_b, vals_b);
+  auto res = hash_join(keys_a, vals_a, keys_b, vals_b);
+  ASSERT_EQ(get_size(res), 8);
+  ASSERT_TRUE(same_rows(res, expected));
+
+  auto filtered = hash_join(keys_a, vals_a, keys_b, vals_b,
+                            [](int key) { return key == 5; });
+  ASSERT_EQ(get_size(filtered), 4);
+}
+
+TEST(Join, HelpersSameRows) {
+  using namespace join_helpers;
+  ColJoinedTableTy<int, int, int> a = {{1, 2, 2}, {{1, 2, 3}, {4, 5, 6}}};
+  ColJoinedTableTy<int, int, int> b = {{2, 1, 2}, {{3, 1, 2}, {6, 4, 5}}};
+  ColJoinedTableTy<int, int, int> c = {{2, 1, 2}, {{3, 1, 2}, {6, 4, 6}}};
+  ASSERT_TRUE(same_rows(a, b));
+  ASSERT_FALSE(same_rows(a, c));
+  ASSERT_FALSE(same_rows(a, {{1}, {{1}, {4}}}));
+}
+
+TEST(Join, HelpersChecker) {
+  RunOptions opts;
+  opts.probe_ratio = 4;
+  opts.match_rate = 0.5;
+  opts.build_duplicates = 2;
+  const size_t build_size = 10000;
+  auto keys_a = helpers::make_build_keys(opts, build_size);
+  auto keys_b = helpers::make_probe_keys(opts, build_size);
+  std::vector<uint32_t> vals_a(keys_a.size(), 1);
+  std::vector<uint32_t> vals_b(keys_b.size(), 2);
+  auto output = join_helpers::hash_join(keys_a, vals_a, keys_b, vals_b);
+  auto wrong = output;
+  wrong.second.second.assign(wrong.second.second.size(), 3);
+
+  for (auto mode :
+       {RunOptions::Verification::Sample, RunOptions::Verification::Full}) {
+    opts.verify = mode;
+    join_helpers::JoinChecker<uint32_t, uint32_t, uint32_t> verify(
+        opts, keys_a, vals_a, keys_b, vals_b);
+    ASSERT_TRUE(verify(output));
+    ASSERT_FALSE(verify(wrong));
+  }
+  opts.verify = RunOptions::Verification::None;
+  join_helpers::JoinChecker<uint32_t, uint32_t, uint32_t> skip(
+      opts, keys_a, vals_a, keys_b, vals_b);
+  ASSERT_TRUE(skip(wrong));
+}
+
+TEST(Join, HelpersGeneratedInputs) {
+  RunOptions opts;
+  opts.probe_ratio = 10;
+  opts.match_rate = 0.2;
+  opts.build_duplicates = 2;
+  opts.probe_duplicates = 4;
+
+  const size_t build_size = 1000;
+  auto keys_a = helpers::make_build_keys(opts, build_size);
+  auto keys_b = helpers::make_probe_keys(opts, build_size);
+  ASSERT_EQ(keys_a.size(), build_size);
+  ASSERT_EQ(keys_b.size(), helpers::probe_rows(opts, build_size));
+  ASSERT_EQ(keys_b.size(), 10000);
+
+  std::vector<uint32_t> vals_a(keys_a.size(), 1);
+  std::vector<uint32_t> vals_b(keys_b.size(), 2);
+  auto res = join_helpers::seq_join(keys_a, vals_a, keys_b, vals_b);
+  // A fifth of the probe rows match two build rows each.
+  ASSERT_EQ(join_helpers::get_size(res), 2 * 2000);
+
+  opts.seed = 1;
+  ASSERT_NE(helpers::make_probe_keys(opts, build_size), keys_b);
+}
+
+TEST(Join, HelpersRadixPartitioning) {
+  RunOptions opts;
+  // Partitions of at most PARTITION_ROWS build rows by default.
+  auto p = join_helpers::radix_partitioning(opts, 1000);
+  ASSERT_EQ(p.bits, 0);
+  p = join_helpers::radix_partitioning(opts, 1 << 20);
+  ASSERT_EQ(p.partitions(), 256);
+  opts.partition_passes = 2;
+  p = join_helpers::radix_partitioning(opts, 1 << 20);
+  ASSERT_EQ(p.bits, 4);
+  ASSERT_EQ(p.partitions(), 256);
+
+  opts.partition_fanout = 64;
+  p = join_helpers::radix_partitioning(opts, 1000);
+  ASSERT_EQ(p.bits, 6);
+  ASSERT_EQ(p.total_bits(), 12);
+  opts.partition_fanout = 48;
+  ASSERT_THROW(join_helpers::radix_partitioning(opts, 1000),
+               std::invalid_argument);
+  opts.partition_fanout = 1 << 13;
+  ASSERT_THROW(join_helpers::radix_partitioning(opts, 1000),
+               std::invalid_argument);
+
+  // Tables of at least two slots, more than the rows and at the load factor.
+  auto tables = join_helpers::partition_tables({0, 0, 3, 4, 104}, 0.5);
+  ASSERT_EQ(tables, (std::vector<uint64_t>{0, 2, 10, 12, 268}));
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
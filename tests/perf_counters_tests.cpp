@@ -0,0 +1,38 @@
+#include "common/perf_counters.hpp"
+
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+
+TEST(PerfCounters, DisabledDoesNotCollect) {
+  PerfCounters counters(false);
+  counters.start();
+  counters.stop();
+  Result result;
+  counters.fill(result);
+  ASSERT_FALSE(result.counters.collected);
+}
+
+TEST(PerfCounters, CountsMeasuredRegion) {
+  PerfCounters counters(true);
+  std::vector<uint64_t> v(1 << 20);
+  counters.start();
+  std::iota(v.begin(), v.end(), 0);
+  volatile uint64_t sum = std::accumulate(v.begin(), v.end(), uint64_t(0));
+  counters.stop();
+
+  EXPECT_GT(sum, 0);
+
+  Result result;
+  counters.fill(result);
+  if (!result.counters.collected)
+    GTEST_SKIP() << "Hardware counters are not available";
+  ASSERT_GT(result.counters.instructions, v.size());
+  ASSERT_GT(result.counters.cycles, 0);
+  ASSERT_GT(result.counters.ipc(), 0);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,33 @@
+#include "common/dpcpp/queue_manager.hpp"
+#include <gtest/gtest.h>
+
+TEST(QueueManager, SharesContextAcrossRuns) {
+  RunOptions opts;
+  opts.device_ty = RunOptions::CPU;
+  opts.queues = make_queue_manager();
+
+  sycl::queue q1 = get_queue(opts);
+  sycl::queue q2 = get_queue(opts);
+  sycl::queue in_order = get_in_order_queue(opts);
+
+  ASSERT_EQ(q1, q2);
+  ASSERT_EQ(q1.get_context(), in_order.get_context());
+  ASSERT_TRUE(in_order.is_in_order());
+  ASSERT_TRUE(q1.has_property<sycl::property::queue::enable_profiling>());
+}
+
+TEST(QueueManager, FallsBackWithoutManager) {
+  RunOptions opts;
+  opts.device_ty = RunOptions::CPU;
+
+  sycl::queue q1 = get_queue(opts);
+  sycl::queue q2 = get_queue(opts);
+
+  ASSERT_NE(q1, q2);
+  ASSERT_TRUE(q1.get_device().is_cpu());
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
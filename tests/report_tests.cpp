@@ -0,0 +1,162 @@
+#include "common/baseline.hpp"
+#include "common/json.hpp"
+#include "common/result.hpp"
+#include "common/trace.hpp"
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+
+TEST(JsonWriter, NestedValues) {
+  std::ostringstream os;
+  JsonWriter json(os);
+  json.begin_object()
+      .field("name", "a \"quoted\"\nline")
+      .field("count", size_t(3))
+      .field("ok", true);
+  json.key("list").begin_array().value(1.5).value(size_t(2)).end_array();
+  json.key("empty").begin_object().end_object();
+  json.end_object();
+
+  ASSERT_EQ(os.str(), "{\"name\":\"a \\\"quoted\\\"\\nline\",\"count\":3,"
+                      "\"ok\":true,\"list\":[1.5,2],\"empty\":{}}");
+}
+
+TEST(MeasureResults, WritesJsonLines) {
+  MeasureResults results("TestDwarf");
+  std::vector<std::unique_ptr<Result>> samples;
+  for (double t : {10.0, 12.0, 11.0}) {
+    auto r = std::make_unique<HashJoinResult>();
+    r->host_time = Duration(t);
+    r->build_time = Duration(t / 2);
+    r->rows = 100;
+    samples.push_back(std::move(r));
+  }
+  // Device info is taken when the results are added, as in Meter.
+  DeviceInfo device;
+  device.name = "Test device";
+  results.set_device_info(device);
+  results.add_result({{"buf_size", "100"}, {"groups_count", "4"}},
+                     std::move(samples), 0);
+
+  std::string path = testing::TempDir() + "report_tests.jsonl";
+  std::remove(path.c_str());
+  results.write_json(path);
+
+  boost::property_tree::ptree tree;
+  boost::property_tree::read_json(path, tree);
+  ASSERT_EQ(tree.get<std::string>("dwarf"), "TestDwarf");
+  ASSERT_EQ(tree.get<std::string>("params.groups_count"), "4");
+  ASSERT_EQ(tree.get<std::string>("device.name"), "Test device");
+  ASSERT_DOUBLE_EQ(tree.get<double>("host_time_us.median"), 11);
+  ASSERT_EQ(tree.get_child("samples").size(), 3);
+  ASSERT_DOUBLE_EQ(
+      tree.get_child("samples").front().second.get<double>("build_time_us"), 5);
+  ASSERT_FALSE(tree.get<std::string>("environment.git_sha").empty());
+}
+
+TEST(MeasureResults, CsvInputBytesFollowKeyWidth) {
+  MeasureResults results("TestDwarf");
+  for (const char *width : {"32", "64"}) {
+    std::vector<std::unique_ptr<Result>> samples;
+    samples.push_back(std::make_unique<Result>());
+    results.add_result({{"buf_size", "3000000000"},
+                        {"device_type", "cpu"},
+                        {"key_width", width}},
+                       std::move(samples), 0);
+  }
+
+  std::string path = testing::TempDir() + "report_tests.csv";
+  std::remove(path.c_str());
+  results.write_csv(path);
+
+  std::ifstream in(path);
+  std::string header, line32, line64;
+  std::getline(in, header);
+  std::getline(in, line32);
+  std::getline(in, line64);
+  EXPECT_EQ(line32.rfind("cpu,12000000000,", 0), 0) << line32;
+  EXPECT_EQ(line64.rfind("cpu,24000000000,", 0), 0) << line64;
+}
+
+TEST(Tracer, WritesSpansAndDeviceCommands) {
+  auto tracer = std::make_shared<Tracer>();
+  {
+    TraceSpan outer(tracer, "build");
+    TraceSpan inner(tracer, "check", "check");
+  }
+  { TraceSpan disabled(nullptr, "ignored"); }
+
+  DeviceCommand cmd;
+  cmd.name = "copy";
+  cmd.kind = DeviceCommand::H2D;
+  cmd.submit = 1000;
+  cmd.start = 3000;
+  cmd.end = 8000;
+  cmd.host_submit = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        Tracer::Clock::now().time_since_epoch())
+                        .count();
+  tracer->device_commands({cmd});
+
+  std::string path = testing::TempDir() + "report_tests_trace.json";
+  tracer->write(path);
+
+  boost::property_tree::ptree tree;
+  boost::property_tree::read_json(path, tree);
+  std::vector<boost::property_tree::ptree> spans;
+  for (const auto &e : tree.get_child("traceEvents")) {
+    if (e.second.get<std::string>("ph") == "X")
+      spans.push_back(e.second);
+  }
+  ASSERT_EQ(spans.size(), 3);
+  ASSERT_EQ(spans[0].get<std::string>("name"), "check");
+  ASSERT_EQ(spans[1].get<std::string>("name"), "build");
+  ASSERT_GE(spans[1].get<double>("dur"), spans[0].get<double>("dur"));
+  ASSERT_EQ(spans[2].get<std::string>("cat"), "h2d");
+  ASSERT_EQ(spans[2].get<int>("tid"), 0);
+  ASSERT_DOUBLE_EQ(spans[2].get<double>("dur"), 5);
+  // Starts 2us after a submission that happened before the write.
+  ASSERT_GT(spans[2].get<double>("ts"), spans[1].get<double>("ts"));
+}
+
+TEST(Baseline, LoadsReportAndDetectsRegression) {
+  MeasureResults results("TestDwarf");
+  std::vector<std::unique_ptr<Result>> samples;
+  for (double t : {100.0, 101.0, 99.0, 100.0, 100.5}) {
+    auto r = std::make_unique<Result>();
+    r->host_time = Duration(t);
+    samples.push_back(std::move(r));
+  }
+  results.add_result({{"buf_size", "100"}}, std::move(samples), 0);
+
+  std::string path = testing::TempDir() + "baseline_tests.jsonl";
+  std::remove(path.c_str());
+  results.write_json(path);
+
+  Baseline baseline = Baseline::load(path);
+  ASSERT_EQ(baseline.size(), 1);
+  ASSERT_EQ(baseline.find("TestDwarf", {{"buf_size", "200"}}), nullptr);
+  const Stats *base = baseline.find("TestDwarf", {{"buf_size", "100"}});
+  ASSERT_NE(base, nullptr);
+
+  auto slower = stats::summarize({120, 121, 119, 120, 120.5}, 0);
+  auto c = compare(*base, slower, 0.05);
+  ASSERT_TRUE(c.significant);
+  ASSERT_TRUE(c.regression);
+  ASSERT_LT(c.speedup, 1);
+
+  auto same = stats::summarize({100.2, 99.5, 101, 100, 99.8}, 0);
+  c = compare(*base, same, 0.05);
+  ASSERT_FALSE(c.regression);
+
+  std::ostringstream os;
+  ASSERT_EQ(compare_with_baseline(baseline, "TestDwarf", results, 0.05, os), 0);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
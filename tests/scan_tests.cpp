@@ -67,7 +67,8 @@ TEST_F(ScanTest32, PrefixSumLocal) {
 
   oclhelpers::set_args(kernel, src, out, /*prefix,*/ buffer_size);
   //   kernel.setArg(3, prefix);
-  std::vector<int> host_src = helpers::make_random_uniform_binary(buffer_size);
+  std::vector<int> host_src =
+      helpers::make_random_uniform_binary(buffer_size, 0);
   //   std::vector<int> host_src(buffer_size, 1);
   std::vector<int> host_out(buffer_size, -1);
 
@@ -282,6 +282,190 @@ TEST(SlabHash, find_and_insert_together_big) {
   }
 }
 
+TEST(SlabHash, heap_grows_on_reserve) {
+  // Every key gets its own list and slab, twice as many as the first block.
+  const size_t buckets = 64;
+  sycl::queue q{sycl::gpu_selector()};
+  sycl::nd_range<1> r{SUBGROUP_SIZE, SUBGROUP_SIZE};
+
+  SlabHash::AllocAdapter<std::pair<uint32_t, uint32_t>> adap(
+      1, 1, buckets, {SlabHash::EMPTY_UINT32_T, 0}, q);
+  std::vector<uint8_t> inserted(buckets, 0);
+
+  {
+    sycl::buffer<SlabHash::AllocAdapter<std::pair<uint32_t, uint32_t>>>
+        adap_buf(&adap, sycl::range<1>{1});
+    sycl::buffer<uint8_t> inserted_buf(inserted);
+
+    auto insert_missing = [&]() {
+      q.submit([&](sycl::handler &cgh) {
+         auto adap_acc = sycl::accessor(adap_buf, cgh, sycl::read_write);
+         auto done = sycl::accessor(inserted_buf, cgh, sycl::read_write);
+
+         cgh.parallel_for<class grow_test_slab>(
+             r, [=](sycl::nd_item<1> it) [
+                    [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
+               SlabHashTable<uint32_t, uint32_t, DefaultHasher<1, 0, 343>> ht(
+                   SlabHash::EMPTY_UINT32_T, it, *(adap_acc.get_pointer()));
+
+               for (uint32_t i = 0; i < buckets; i++) {
+                 if (done[i])
+                   continue;
+                 bool ok = ht.insert(i, i);
+                 if (it.get_local_id() == 0)
+                   done[i] = ok;
+               }
+             });
+       }).wait();
+    };
+
+    insert_missing();
+    SlabHash::HeapUsage usage = adap.usage();
+    EXPECT_EQ(usage.allocated, buckets / 2);
+    EXPECT_EQ(usage.used, buckets / 2);
+    EXPECT_TRUE(usage.overflowed);
+
+    adap.reserve(buckets);
+    insert_missing();
+    usage = adap.usage();
+    EXPECT_EQ(usage.allocated, buckets);
+    EXPECT_EQ(usage.used, buckets);
+  }
+
+  for (auto e : inserted) {
+    EXPECT_EQ(e, 1);
+  }
+}
+
+TEST(SlabHash, erase_and_upsert) {
+  sycl::queue q{sycl::gpu_selector()};
+  sycl::nd_range<1> r{SUBGROUP_SIZE, SUBGROUP_SIZE};
+
+  SlabHash::AllocAdapter<std::pair<uint32_t, uint32_t>> adap(
+      SlabHash::CLUSTER_SIZE, 1, SlabHash::BUCKETS_COUNT,
+      {SlabHash::EMPTY_UINT32_T, 0}, q);
+  // Results of the erases and upserts, then the values of keys 1 to 6.
+  std::vector<uint32_t> out(11, 0);
+  std::vector<uint32_t> expected = {1, 0, 1, 1, 1, 1, 0, 30, 4, 50, 60};
+
+  {
+    sycl::buffer<SlabHash::AllocAdapter<std::pair<uint32_t, uint32_t>>>
+        adap_buf(&adap, sycl::range<1>{1});
+    sycl::buffer<uint32_t> out_buf(out);
+
+    q.submit([&](sycl::handler &cgh) {
+       auto adap_acc = sycl::accessor(adap_buf, cgh, sycl::read_write);
+       auto o = sycl::accessor(out_buf, cgh, sycl::write_only);
+
+       cgh.parallel_for<class erase_test_slab>(
+           r, [=](sycl::nd_item<1> it) [
+                  [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
+             SlabHashTable<uint32_t, uint32_t, DefaultHasher<13, 24, 343>> ht(
+                 SlabHash::EMPTY_UINT32_T, it, *(adap_acc.get_pointer()));
+
+             for (uint32_t k = 1; k <= 4; k++) {
+               ht.insert(k, k);
+             }
+             uint32_t res[11];
+             res[0] = ht.erase(2);
+             res[1] = ht.erase(2);
+             res[2] = ht.upsert(3, 30);
+             res[3] = ht.upsert(5, 50);
+             res[4] = ht.insert(6, 60);
+             for (uint32_t k = 1; k <= 6; k++) {
+               res[k + 4] = ht.find(k).value_or(0);
+             }
+             if (it.get_local_id() == 0) {
+               for (int i = 0; i < 11; i++) {
+                 o[i] = res[i];
+               }
+             }
+           });
+     }).wait();
+  }
+
+  EXPECT_EQ(out, expected);
+}
+
+TEST(SlabHash, compact_frees_erased_slabs) {
+  // A single list of three full slabs, the middle one of which is erased,
+  // freed and then taken again by new keys.
+  sycl::queue q{sycl::gpu_selector()};
+  sycl::nd_range<1> r{SUBGROUP_SIZE, SUBGROUP_SIZE};
+
+  SlabHash::AllocAdapter<std::pair<uint32_t, uint32_t>> adap(
+      SlabHash::CLUSTER_SIZE, 1, 1, {SlabHash::EMPTY_UINT32_T, 0}, q);
+  // Slabs freed, then whether all keys were found before and after the
+  // new inserts.
+  std::vector<uint32_t> out(3, 0);
+  std::vector<uint32_t> expected = {1, 1, 1};
+  SlabHash::HeapUsage compacted;
+
+  {
+    sycl::buffer<SlabHash::AllocAdapter<std::pair<uint32_t, uint32_t>>>
+        adap_buf(&adap, sycl::range<1>{1});
+    sycl::buffer<uint32_t> out_buf(out);
+
+    q.submit([&](sycl::handler &cgh) {
+       auto adap_acc = sycl::accessor(adap_buf, cgh, sycl::read_write);
+       auto o = sycl::accessor(out_buf, cgh, sycl::read_write);
+
+       cgh.parallel_for<class compact_test_slab>(
+           r, [=](sycl::nd_item<1> it) [
+                  [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
+             SlabHashTable<uint32_t, uint32_t, DefaultHasher<1, 0, 343>> ht(
+                 SlabHash::EMPTY_UINT32_T, it, *(adap_acc.get_pointer()));
+
+             for (uint32_t k = 0; k < 3 * SLAB_SIZE; k++) {
+               ht.insert(k, k);
+             }
+             for (uint32_t k = SLAB_SIZE; k < 2 * SLAB_SIZE; k++) {
+               ht.erase(k);
+             }
+             size_t freed = ht.compact(0);
+             if (it.get_local_id() == 0)
+               o[0] = freed;
+           });
+     }).wait();
+    compacted = adap.usage();
+
+    q.submit([&](sycl::handler &cgh) {
+       auto adap_acc = sycl::accessor(adap_buf, cgh, sycl::read_write);
+       auto o = sycl::accessor(out_buf, cgh, sycl::read_write);
+
+       cgh.parallel_for<class compact_test_slab_reuse>(
+           r, [=](sycl::nd_item<1> it) [
+                  [intel::reqd_sub_group_size(SlabHash::SUBGROUP_SIZE)]] {
+             SlabHashTable<uint32_t, uint32_t, DefaultHasher<1, 0, 343>> ht(
+                 SlabHash::EMPTY_UINT32_T, it, *(adap_acc.get_pointer()));
+
+             bool found = true;
+             for (uint32_t k = 0; k < 3 * SLAB_SIZE; k++) {
+               bool erased = k >= SLAB_SIZE && k < 2 * SLAB_SIZE;
+               found = found && ht.find(k).has_value() != erased;
+             }
+             for (uint32_t k = 3 * SLAB_SIZE; k < 4 * SLAB_SIZE; k++) {
+               ht.insert(k, k);
+             }
+             bool found_new = true;
+             for (uint32_t k = 3 * SLAB_SIZE; k < 4 * SLAB_SIZE; k++) {
+               found_new = found_new && ht.find(k) == k;
+             }
+             if (it.get_local_id() == 0) {
+               o[1] = found;
+               o[2] = found_new;
+             }
+           });
+     }).wait();
+  }
+
+  EXPECT_EQ(out, expected);
+  EXPECT_EQ(compacted.used, 2);
+  SlabHash::HeapUsage usage = adap.usage();
+  EXPECT_EQ(usage.used, 3);
+  EXPECT_EQ(usage.allocated, compacted.allocated);
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,89 @@
+#include "common/meter.hpp"
+#include "common/stats.hpp"
+
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(Stats, Percentiles) {
+  std::vector<double> values = {5, 1, 4, 2, 3};
+
+  auto s = stats::summarize(values, 0);
+
+  ASSERT_EQ(s.samples, 5);
+  ASSERT_EQ(s.outliers, 0);
+  ASSERT_DOUBLE_EQ(s.min, 1);
+  ASSERT_DOUBLE_EQ(s.max, 5);
+  ASSERT_DOUBLE_EQ(s.median, 3);
+  ASSERT_DOUBLE_EQ(s.mean, 3);
+  ASSERT_DOUBLE_EQ(s.p95, 4.8);
+  ASSERT_NEAR(s.stddev, 1.5811, 1e-4);
+  ASSERT_GT(s.ci95, 0);
+}
+
+TEST(Stats, RejectsOutliers) {
+  std::vector<double> values = {10, 11, 10, 12, 11, 10, 500};
+
+  auto s = stats::summarize(values, 3);
+
+  ASSERT_EQ(s.samples, 6);
+  ASSERT_EQ(s.outliers, 1);
+  ASSERT_DOUBLE_EQ(s.max, 12);
+}
+
+TEST(Stats, KeepsIdenticalSamples) {
+  std::vector<double> values = {7, 7, 7, 7};
+
+  auto s = stats::summarize(values, 3);
+
+  ASSERT_EQ(s.samples, 4);
+  ASSERT_DOUBLE_EQ(s.stddev, 0);
+  ASSERT_DOUBLE_EQ(s.relative_ci(), 0);
+}
+
+TEST(Stats, HashQuality) {
+  // Slots 0 and 3 hold two keys each, so two inserts move to the next free
+  // slot: 0 0 1 3 3 probe 1, 2, 2, 1 and 2 slots.
+  auto q = stats::hash_quality({0, 0, 1, 3, 3}, 8);
+
+  ASSERT_EQ(q.keys, 5);
+  ASSERT_EQ(q.collisions, 2);
+  ASSERT_EQ(q.max_probe_length, 2);
+  ASSERT_DOUBLE_EQ(q.mean_probe_length, 8.0 / 5);
+  // Counts 2 1 0 2 0 0 0 0 around a mean of 5 / 8.
+  ASSERT_DOUBLE_EQ(q.occupancy_variance, (2 * 1.890625 + 0.140625 +
+                                          5 * 0.390625) / 8);
+
+  auto perfect = stats::hash_quality({3, 1, 2, 0}, 4);
+  ASSERT_EQ(perfect.collisions, 0);
+  ASSERT_EQ(perfect.max_probe_length, 1);
+  ASSERT_DOUBLE_EQ(perfect.occupancy_variance, 0);
+}
+
+TEST(Meter, TargetCiNeedsSeveralSamples) {
+  RunOptions opts;
+  opts.target_ci = 0.05;
+  MeasureResults results("TestDwarf");
+  Meter meter("TestDwarf", results);
+  meter.set_opts(opts);
+
+  // Identical samples meet any target, but not from a single one.
+  size_t calls = 0;
+  auto iteration = [&] {
+    ++calls;
+    auto r = std::make_unique<Result>();
+    r->host_time = Duration(10);
+    return r;
+  };
+  meter.measure({}, iteration);
+  ASSERT_EQ(calls, 3);
+
+  opts.iterations = 5;
+  calls = 0;
+  meter.measure({}, iteration);
+  ASSERT_EQ(calls, 5);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
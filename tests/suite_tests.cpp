@@ -0,0 +1,68 @@
+#include "common/suite.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+
+namespace {
+std::string write_file(const std::string &name, const std::string &content) {
+  std::string path = testing::TempDir() + name;
+  std::ofstream(path) << content;
+  return path;
+}
+} // namespace
+
+TEST(Suite, ExpandsJsonSweep) {
+  auto path = write_file("suite_tests.json", R"({
+    "iterations": 9,
+    "report_path": "sweep.jsonl",
+    "runs": [
+      {"dwarf": "Radix", "device": ["cpu", "igpu"], "input_size": [256, 512]},
+      {"dwarf": "GroupBy", "groups_count": [1, 16], "iterations": 3}
+    ]
+  })");
+  RunOptions defaults;
+  defaults.device_ty = RunOptions::GPU;
+  defaults.input_size = {1024};
+
+  Suite suite = load_suite(path, defaults, 1, 1);
+
+  ASSERT_EQ(suite.report_path, "sweep.jsonl");
+  ASSERT_EQ(suite.points.size(), 4);
+  ASSERT_EQ(suite.points[0].dwarf, "Radix");
+  ASSERT_EQ(suite.points[0].opts->device_ty, RunOptions::CPU);
+  ASSERT_EQ(suite.points[1].opts->device_ty, RunOptions::iGPU);
+  ASSERT_EQ(suite.points[1].opts->input_size, std::vector<size_t>({256, 512}));
+  ASSERT_EQ(suite.points[1].opts->iterations, 9);
+
+  auto &groupby =
+      static_cast<const GroupByRunOptions &>(*suite.points[3].opts);
+  ASSERT_EQ(groupby.groups_count, 16);
+  ASSERT_EQ(groupby.device_ty, RunOptions::GPU);
+  ASSERT_EQ(groupby.input_size, std::vector<size_t>({1024}));
+  ASSERT_EQ(groupby.iterations, 3);
+}
+
+TEST(Suite, ReadsIniSections) {
+  auto path = write_file("suite_tests.ini", "warmup = 2\n"
+                                            "[scan]\n"
+                                            "dwarf = DPLScan\n"
+                                            "input_size = 256 512\n");
+  Suite suite = load_suite(path, RunOptions(), 1, 1);
+
+  ASSERT_EQ(suite.points.size(), 1);
+  ASSERT_EQ(suite.points[0].dwarf, "DPLScan");
+  ASSERT_EQ(suite.points[0].opts->warmup, 2);
+  ASSERT_EQ(suite.points[0].opts->input_size, std::vector<size_t>({256, 512}));
+}
+
+TEST(Suite, RejectsUnknownSettings) {
+  auto path = write_file("suite_tests_bad.json",
+                         R"({"runs": [{"dwarf": "Radix", "iteration": 3}]})");
+  ASSERT_THROW(load_suite(path, RunOptions(), 1, 1), std::invalid_argument);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}